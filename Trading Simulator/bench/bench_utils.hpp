@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bench {
+
+inline uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Keeps the compiler from optimising away a benchmarked result
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Pins the calling thread to a core (wrapping round on small hosts).
+// macOS has no hard affinity API, so this is a no-op there.
+inline void pin_thread(unsigned cpu) {
+#ifdef __linux__
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % cores, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+// Prints min / percentiles / max of a latency sample set in nanoseconds
+inline void print_latency(const std::string &label,
+                          std::vector<uint64_t> &samples_ns) {
+  if (samples_ns.empty()) {
+    std::printf("%-32s no samples\n", label.c_str());
+    return;
+  }
+  std::sort(samples_ns.begin(), samples_ns.end());
+  auto pct = [&](double p) {
+    size_t i = static_cast<size_t>(p * (samples_ns.size() - 1));
+    return static_cast<unsigned long long>(samples_ns[i]);
+  };
+  std::printf("%-32s min=%llu p50=%llu p99=%llu p99.9=%llu max=%llu ns\n",
+              label.c_str(), pct(0.0), pct(0.50), pct(0.99), pct(0.999),
+              pct(1.0));
+}
+
+// Prints an operation rate for n operations completed in elapsed_ns
+inline void print_rate(const std::string &label, uint64_t n,
+                       uint64_t elapsed_ns) {
+  double secs = elapsed_ns / 1e9;
+  std::printf("%-32s %12.0f ops/sec  %8.2f ns/op\n", label.c_str(),
+              n / secs, static_cast<double>(elapsed_ns) / n);
+}
+
+} // namespace bench
@@ -0,0 +1,92 @@
+// Hot-path cost of one trade log line: the previous synchronous std::ostream
+// print (ANSI colour plus floating-point formatting, here into /dev/null so
+// no terminal is involved) versus core::log, which only copies a 64-byte
+// binary record into the calling thread's queue. The background thread
+// formats into /dev/null while the calls are timed.
+//
+// Calls are issued in bursts with a pause between them, so the logger queue
+// never fills and every record is kept.
+//
+// Usage: binary_log_bench [calls]
+
+#include "bench_utils.hpp"
+#include "binary_log.hpp"
+#include "protocol.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+constexpr size_t BURST = 1024;
+
+static protocol::TickPacket make_tick(size_t i) {
+  protocol::TickPacket tick{};
+  tick.symbol[0] = 'M';
+  tick.symbol[1] = 'S';
+  tick.symbol[2] = 'F';
+  tick.symbol[3] = 'T';
+  tick.price = 412.37 + static_cast<double>(i % 100) * 0.01;
+  return tick;
+}
+
+// Times log_one(i) for each call, pausing between bursts
+template <typename F>
+static std::vector<uint64_t> time_calls(size_t calls, F &&log_one) {
+  std::vector<uint64_t> samples;
+  samples.reserve(calls);
+  for (size_t i = 0; i < calls; i++) {
+    uint64_t start = bench::now_ns();
+    log_one(i);
+    samples.push_back(bench::now_ns() - start);
+    if ((i + 1) % BURST == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return samples;
+}
+
+int main(int argc, char **argv) {
+  const size_t calls =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  const size_t period = 100;
+  const double sma = 413.02, two_sigma = 0.58;
+
+  std::printf("%zu BUY log lines per variant\n", calls);
+
+  // Cost of the timer itself
+  auto empty = time_calls(calls, [](size_t i) { bench::do_not_optimize(i); });
+  bench::print_latency("timer overhead", empty);
+
+  // The previous print, as MeanReversion issued it
+  {
+    std::ofstream out("/dev/null");
+    auto samples = time_calls(calls, [&](size_t i) {
+      protocol::TickPacket tick = make_tick(i);
+      std::string_view sym(tick.symbol, sizeof(tick.symbol));
+      out << "\033[1;32m[STRATEGY SMA" << period << "] BUY 100 " << sym
+          << " @ $" << tick.price << " (SMA: $" << sma << ", 2\u03c3: $"
+          << two_sigma << ")\033[0m\n";
+    });
+    bench::print_latency("std::ostream (sync)", samples);
+  }
+
+  // Binary record, formatted on the background thread
+  {
+    FILE *null = std::fopen("/dev/null", "w");
+    core::Logger &logger = core::Logger::instance();
+    logger.start({null, ""});
+    auto samples = time_calls(calls, [&](size_t i) {
+      protocol::TickPacket tick = make_tick(i);
+      core::log<core::LogId::StrategyBuy>(period, core::LogSymbol(tick.symbol),
+                                          tick.price, sma, two_sigma);
+    });
+    logger.stop();
+    std::fclose(null);
+    bench::print_latency("core::log (async binary)", samples);
+    std::printf("records dropped: %llu\n",
+                static_cast<unsigned long long>(logger.dropped()));
+  }
+  return 0;
+}
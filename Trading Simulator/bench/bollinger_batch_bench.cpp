@@ -0,0 +1,177 @@
+// Per-tick versus batch Bollinger evaluation on one core.
+//  1. Kernel check: every SIMD kernel against the scalar band maths on
+//     random windows, comparing sma / std_dev bit for bit and the signals.
+//  2. Kernel throughput: band evaluations per second for each kernel.
+//  3. End to end: MeanReversion::on_tick versus on_batch over a random tick
+//     stream, in ticks/sec, with the realised PnL compared bit for bit.
+//
+// Usage: bollinger_batch_bench [ticks] [symbols]
+
+#include "bench_utils.hpp"
+#include "bollinger_simd.hpp"
+#include "mean_reversion.hpp"
+#include "protocol.hpp"
+#include "rolling_stats.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+constexpr size_t PERIOD = 100;
+
+static std::vector<strategy::SimdLevel> available_levels() {
+  std::vector<strategy::SimdLevel> levels{strategy::SimdLevel::Scalar};
+  strategy::SimdLevel best = strategy::detect_simd();
+  if (best != strategy::SimdLevel::Scalar)
+    levels.push_back(strategy::SimdLevel::Avx2);
+  if (best == strategy::SimdLevel::Avx512)
+    levels.push_back(strategy::SimdLevel::Avx512);
+  return levels;
+}
+
+// Rolling statistics of PERIOD random prices around a random level,
+// accumulated the way the strategy does. Some windows are flat, to exercise
+// the clamps.
+static void fill_random(strategy::BandBatch &batch, std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> level(5.0, 450.0);
+  std::normal_distribution<double> noise(0.0, 0.3);
+  for (size_t i = 0; i < strategy::BAND_BATCH; i++) {
+    double base = level(rng);
+    bool flat = rng() % 8 == 0;
+    double mean = 0.0, comp = 0.0, m2 = 0.0, price = base;
+    for (uint32_t k = 1; k <= PERIOD; k++) {
+      price = flat ? base : base + noise(rng);
+      strategy::rolling_add(mean, comp, m2, price, k);
+    }
+    batch.mean[i] = mean;
+    batch.m2[i] = m2;
+    batch.price[i] = price - (rng() % 3 == 0 ? 1.0 : 0.0);
+  }
+}
+
+static bool check_kernel(strategy::SimdLevel level, size_t rounds) {
+  std::mt19937_64 rng(11);
+  strategy::BandBatch batch;
+  size_t mismatches = 0;
+  for (size_t r = 0; r < rounds; r++) {
+    fill_random(batch, rng);
+    size_t n = 1 + r % strategy::BAND_BATCH;
+    strategy::bollinger_batch(level, batch, n, PERIOD);
+    for (size_t i = 0; i < n; i++) {
+      double sma, std_dev;
+      strategy::bollinger_bands(batch.mean[i], batch.m2[i], PERIOD, sma,
+                                std_dev);
+      bool below = batch.price[i] <= sma - (2.0 * std_dev);
+      bool above = batch.price[i] >= sma;
+      if (std::memcmp(&sma, &batch.sma[i], sizeof(double)) != 0 ||
+          std::memcmp(&std_dev, &batch.std_dev[i], sizeof(double)) != 0 ||
+          below != static_cast<bool>((batch.below_band >> i) & 1) ||
+          above != static_cast<bool>((batch.above_sma >> i) & 1)) {
+        mismatches++;
+      }
+    }
+    // No signal may leak from the lanes past n
+    if (n < strategy::BAND_BATCH &&
+        ((batch.below_band | batch.above_sma) >> n) != 0)
+      mismatches++;
+  }
+  std::printf("%-32s %s (%zu batches, %zu mismatching lanes)\n",
+              strategy::simd_name(level),
+              mismatches == 0 ? "bit-exact" : "MISMATCH", rounds, mismatches);
+  return mismatches == 0;
+}
+
+static void kernel_throughput(strategy::SimdLevel level, size_t batches) {
+  std::mt19937_64 rng(3);
+  strategy::BandBatch batch;
+  fill_random(batch, rng);
+  uint64_t start = bench::now_ns();
+  for (size_t r = 0; r < batches; r++) {
+    strategy::bollinger_batch(level, batch, strategy::BAND_BATCH, PERIOD);
+    bench::do_not_optimize(batch.below_band);
+  }
+  bench::print_rate(std::string("kernel ") + strategy::simd_name(level),
+                    batches * strategy::BAND_BATCH, bench::now_ns() - start);
+}
+
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] += step(rng);
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      stream[seq].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    stream[seq].price = prices[s];
+    stream[seq].sequence_num = seq;
+  }
+  return stream;
+}
+
+using Strategy = strategy::MeanReversion<PERIOD, 1 << 14>;
+
+// Feeds the stream in drains of 256 ticks, as the subscriber does
+static double run_stream(const std::vector<protocol::TickPacket> &stream,
+                         bool batch, strategy::SimdLevel level,
+                         const std::string &label) {
+  auto strat = std::make_unique<Strategy>(strategy::StrategyConfig{.simd = level});
+  std::span<const protocol::TickPacket> all(stream);
+  uint64_t start = bench::now_ns();
+  if (batch) {
+    for (size_t i = 0; i < all.size(); i += 256) {
+      strat->on_batch(all.subspan(i, std::min<size_t>(256, all.size() - i)));
+    }
+  } else {
+    for (const auto &tick : all) {
+      strat->on_tick(tick);
+    }
+  }
+  bench::print_rate(label, stream.size(), bench::now_ns() - start);
+  return strat->session_pnl();
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  const size_t symbols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+  auto levels = available_levels();
+
+  std::printf("Kernel check against the per-tick band maths\n");
+  bool exact = true;
+  for (auto level : levels) {
+    exact &= check_kernel(level, 200000);
+  }
+
+  std::printf("\nKernel throughput (band evaluations, one core)\n");
+  for (auto level : levels) {
+    kernel_throughput(level, 2000000);
+  }
+
+  std::printf("\nEnd to end: %zu ticks over %zu symbols, SMA%zu\n", ticks,
+              symbols, PERIOD);
+  auto stream = make_stream(ticks, symbols);
+
+  double reference = run_stream(stream, false, strategy::SimdLevel::Scalar,
+                                "on_tick (scalar)");
+  for (auto level : levels) {
+    double pnl = run_stream(stream, true, level,
+                            std::string("on_batch ") +
+                                strategy::simd_name(level));
+    bool same = std::memcmp(&pnl, &reference, sizeof(double)) == 0;
+    exact &= same;
+    std::printf("%-32s PnL $%.2f %s\n", "", pnl,
+                same ? "(identical to on_tick)" : "(DIFFERS from on_tick)");
+  }
+
+  return exact ? 0 : 1;
+}
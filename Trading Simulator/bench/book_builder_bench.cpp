@@ -0,0 +1,313 @@
+// Subscriber-side book building from an L3 stream. The stream is the
+// matching engine's BookUpdate output for a generated order flow (adds,
+// cancels, sweeps over 50 symbols). It is applied to:
+//   flat        core::BookBuilder: price-level arrays, flat order ID map,
+//               pooled order nodes
+//   std::map    per-side std::map levels and an unordered_map of orders
+// and reports updates/sec, per-update latency percentiles (including
+// ~20-30 ns of clock overhead) and the cost of a BBO read. The books are
+// compared on every 1000th update and in full (BBO and 10 levels) at the
+// end; the run fails on any difference. A third builder loses every 1000th
+// update: it must hold no book it cannot vouch for, and hold every book
+// again after the engine's snapshot.
+//
+// Usage: book_builder_bench [orders]
+
+#include "bench_utils.hpp"
+#include "book_builder.hpp"
+#include "matching_engine.hpp"
+#include "order_flow.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using bench::flow_symbol;
+using bench::FLOW_SYMBOLS;
+
+constexpr size_t DEPTH = 10;
+constexpr size_t CHECK_EVERY = 1000;
+
+using Builder = core::BookBuilder<>;
+
+struct Recorder {
+  std::vector<protocol::BookUpdate> updates;
+  void on_execution(const exchange::Execution &) {}
+  void on_book_update(const protocol::BookUpdate &update) {
+    updates.push_back(update);
+    updates.back().sequence_num = updates.size();
+  }
+};
+
+// L3 stream from running the generated flow through the matching engine,
+// and the engine's snapshot of its books at the end
+static std::vector<protocol::BookUpdate>
+record_stream(size_t orders, std::vector<protocol::BookUpdate> &snapshot) {
+  Recorder recorder;
+  exchange::MatchingEngine<Recorder> engine(recorder, 1 << 20);
+  for (const bench::Op &op : bench::generate_order_flow(orders)) {
+    if (op.kind == bench::OpKind::Cancel)
+      engine.cancel(0, op.client_id);
+    else
+      engine.add(0, op.client_id, flow_symbol(op.symbol), op.side, op.price,
+                 op.quantity, op.kind == bench::OpKind::Take);
+  }
+  engine.snapshot([&](const protocol::BookUpdate &update) {
+    snapshot.push_back(update);
+  });
+  return std::move(recorder.updates);
+}
+
+// The straightforward way: ordered maps of aggregated levels
+class MapBook {
+public:
+  struct Level {
+    uint64_t quantity = 0;
+    uint32_t orders = 0;
+  };
+
+  void add(int64_t price, protocol::Side side, uint32_t quantity) {
+    Level &lvl = side == protocol::Side::Buy ? bids_[price] : asks_[price];
+    lvl.quantity += quantity;
+    lvl.orders++;
+  }
+
+  void reduce(int64_t price, protocol::Side side, uint32_t quantity,
+              bool gone) {
+    if (side == protocol::Side::Buy)
+      reduce(bids_, price, quantity, gone);
+    else
+      reduce(asks_, price, quantity, gone);
+  }
+
+  core::Bbo bbo() const {
+    core::Bbo top;
+    if (!bids_.empty()) {
+      top.bid_price = bids_.begin()->first;
+      top.bid_quantity = bids_.begin()->second.quantity;
+    }
+    if (!asks_.empty()) {
+      top.ask_price = asks_.begin()->first;
+      top.ask_quantity = asks_.begin()->second.quantity;
+    }
+    return top;
+  }
+
+  size_t depth(protocol::Side side, std::span<core::LevelView> out) const {
+    return side == protocol::Side::Buy ? depth(bids_, out) : depth(asks_, out);
+  }
+
+private:
+  template <typename Side>
+  static void reduce(Side &levels, int64_t price, uint32_t quantity,
+                     bool gone) {
+    auto it = levels.find(price);
+    it->second.quantity -= quantity;
+    if (gone && --it->second.orders == 0)
+      levels.erase(it);
+  }
+
+  template <typename Side>
+  static size_t depth(const Side &levels, std::span<core::LevelView> out) {
+    size_t n = 0;
+    for (auto it = levels.begin(); it != levels.end() && n < out.size(); ++it)
+      out[n++] = {it->first, it->second.quantity, it->second.orders};
+    return n;
+  }
+
+  std::map<int64_t, Level, std::greater<int64_t>> bids_;
+  std::map<int64_t, Level> asks_;
+};
+
+class MapBuilder {
+public:
+  MapBook *apply(const protocol::BookUpdate &update) {
+    // The stream's only Clears open new books
+    if (update.action == protocol::BookAction::Clear)
+      return &books_[core::symbol_key(update.symbol)];
+    if (update.action == protocol::BookAction::Add) {
+      MapBook &book = books_[core::symbol_key(update.symbol)];
+      orders_[update.order_id] = {update.price, &book, update.quantity,
+                                  update.side};
+      book.add(update.price, update.side, update.quantity);
+      return &book;
+    }
+    auto it = orders_.find(update.order_id);
+    if (it == orders_.end())
+      return nullptr;
+    Order &order = it->second;
+    uint32_t quantity = update.action == protocol::BookAction::Cancel
+                            ? order.quantity
+                            : std::min(update.quantity, order.quantity);
+    order.quantity -= quantity;
+    bool gone = order.quantity == 0;
+    MapBook *book = order.book;
+    book->reduce(order.price, order.side, quantity, gone);
+    if (gone)
+      orders_.erase(it);
+    return book;
+  }
+
+  MapBook *book(const char (&symbol)[4]) {
+    auto it = books_.find(core::symbol_key(symbol));
+    return it == books_.end() ? nullptr : &it->second;
+  }
+
+private:
+  struct Order {
+    int64_t price;
+    MapBook *book;
+    uint32_t quantity;
+    protocol::Side side;
+  };
+
+  std::unordered_map<uint32_t, MapBook> books_;
+  std::unordered_map<uint64_t, Order> orders_;
+};
+
+static bool same_bbo(const core::Bbo &a, const core::Bbo &b) {
+  return a.bid_price == b.bid_price && a.bid_quantity == b.bid_quantity &&
+         a.ask_price == b.ask_price && a.ask_quantity == b.ask_quantity;
+}
+
+static bool same_depth(const core::DepthBook &flat, const MapBook &ref) {
+  for (protocol::Side side : {protocol::Side::Buy, protocol::Side::Sell}) {
+    std::array<core::LevelView, DEPTH> a{}, b{};
+    size_t na = flat.depth(side, a);
+    size_t nb = ref.depth(side, b);
+    if (na != nb)
+      return false;
+    for (size_t i = 0; i < na; i++) {
+      if (a[i].price != b[i].price || a[i].quantity != b[i].quantity ||
+          a[i].orders != b[i].orders)
+        return false;
+    }
+  }
+  return true;
+}
+
+template <typename B>
+static uint64_t replay(B &builder,
+                       const std::vector<protocol::BookUpdate> &stream) {
+  uint64_t start = bench::now_ns();
+  for (const protocol::BookUpdate &update : stream)
+    bench::do_not_optimize(builder.apply(update));
+  return bench::now_ns() - start;
+}
+
+template <typename B>
+static void latency(const std::string &label, B &builder,
+                    const std::vector<protocol::BookUpdate> &stream) {
+  std::vector<uint64_t> samples;
+  samples.reserve(stream.size());
+  for (const protocol::BookUpdate &update : stream) {
+    uint64_t start = bench::now_ns();
+    bench::do_not_optimize(builder.apply(update));
+    samples.push_back(bench::now_ns() - start);
+  }
+  bench::print_latency(label, samples);
+}
+
+// Average cost of a BBO read over every symbol, many times round
+template <typename B> static double bbo_read_ns(B &builder) {
+  constexpr size_t ROUNDS = 20000;
+  std::vector<decltype(builder.book(flow_symbol(0)))> books;
+  for (uint32_t s = 0; s < FLOW_SYMBOLS; s++)
+    books.push_back(builder.book(flow_symbol(s)));
+  uint64_t start = bench::now_ns();
+  for (size_t r = 0; r < ROUNDS; r++) {
+    for (auto *book : books) {
+      core::Bbo top = book->bbo();
+      bench::do_not_optimize(top);
+    }
+  }
+  return static_cast<double>(bench::now_ns() - start) /
+         (ROUNDS * books.size());
+}
+
+int main(int argc, char **argv) {
+  const size_t orders =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  std::vector<protocol::BookUpdate> snapshot;
+  std::vector<protocol::BookUpdate> stream = record_stream(orders, snapshot);
+  std::printf("%zu L3 updates from %zu orders over %zu symbols\n",
+              stream.size(), orders, FLOW_SYMBOLS);
+
+  // Throughput: best of 3 fresh builders each
+  uint64_t flat_best = UINT64_MAX, map_best = UINT64_MAX;
+  for (int run = 0; run < 3; run++) {
+    Builder flat(1 << 20);
+    flat_best = std::min(flat_best, replay(flat, stream));
+    MapBuilder ref;
+    map_best = std::min(map_best, replay(ref, stream));
+  }
+  bench::print_rate("flat updates", stream.size(), flat_best);
+  bench::print_rate("std::map updates", stream.size(), map_best);
+
+  Builder flat(1 << 20);
+  MapBuilder ref;
+  latency("flat apply", flat, stream);
+  latency("std::map apply", ref, stream);
+  std::printf("%-32s %8.2f ns\n", "flat bbo read", bbo_read_ns(flat));
+  std::printf("%-32s %8.2f ns\n", "std::map bbo read", bbo_read_ns(ref));
+
+  // Consistency: a fresh pair, compared as they go and at the end
+  Builder check_flat(1 << 20);
+  MapBuilder check_ref;
+  bool ok = true;
+  uint64_t rejected = 0;
+  for (size_t i = 0; i < stream.size(); i++) {
+    core::DepthBook *a = check_flat.apply(stream[i]);
+    MapBook *b = check_ref.apply(stream[i]);
+    if (a == nullptr)
+      rejected++;
+    if (i % CHECK_EVERY == 0 && a && b)
+      ok = ok && same_bbo(a->bbo(), b->bbo());
+  }
+  for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+    core::DepthBook *a = check_flat.book(flow_symbol(s));
+    MapBook *b = check_ref.book(flow_symbol(s));
+    ok = ok && a && b && same_bbo(a->bbo(), b->bbo()) && same_depth(*a, *b);
+  }
+  ok = ok && rejected == 0;
+  std::printf("%-32s %s (%zu resting orders at the end)\n",
+              "std::map reference check", ok ? "match" : "MISMATCH",
+              check_flat.orders());
+
+  // Lossy: empties its books on each gap, as the subscriber does, then
+  // resyncs from the snapshot
+  Builder lossy(1 << 20);
+  for (size_t i = 0; i < stream.size(); i++) {
+    if (i % CHECK_EVERY == CHECK_EVERY - 1)
+      lossy.desync();
+    else
+      lossy.apply(stream[i]);
+  }
+  bool resynced = true;
+  for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+    core::DepthBook *a = lossy.book(flow_symbol(s));
+    MapBook *b = check_ref.book(flow_symbol(s));
+    resynced = resynced && a && b &&
+               (!lossy.synced(*a) || same_depth(*a, *b));
+  }
+  for (const protocol::BookUpdate &update : snapshot)
+    resynced = resynced && lossy.apply(update) != nullptr;
+  for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+    core::DepthBook *a = lossy.book(flow_symbol(s));
+    MapBook *b = check_ref.book(flow_symbol(s));
+    resynced = resynced && a && b && lossy.synced(*a) &&
+               same_bbo(a->bbo(), b->bbo()) && same_depth(*a, *b);
+  }
+  std::printf("%-32s %s (%zu updates in the snapshot)\n",
+              "lossy resync check", resynced ? "match" : "MISMATCH",
+              snapshot.size());
+  return ok && resynced ? 0 : 1;
+}
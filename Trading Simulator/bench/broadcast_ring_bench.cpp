@@ -0,0 +1,94 @@
+// Fan-out latency of the shared-memory BroadcastRing for 1 to 16 consumers.
+// Every consumer maps the segment separately, exactly as a colocated strategy
+// process would, and measures publish-to-read latency for each tick.
+//
+// Usage: broadcast_ring_bench [ticks_per_run]
+
+#include "bench_utils.hpp"
+#include "broadcast_ring.hpp"
+#include "protocol.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Ring = core::BroadcastRing<protocol::TickPacket, 65536, 16>;
+
+int main(int argc, char **argv) {
+  const uint64_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  const std::string shm_name = "/bench_bcast_" + std::to_string(getpid());
+
+  std::printf("BroadcastRing fan-out: %llu ticks per run, 1 tick every 1us\n",
+              static_cast<unsigned long long>(ticks));
+
+  for (size_t consumers : {1, 2, 4, 8, 16}) {
+    core::SharedMemory shm = core::SharedMemory::create(shm_name, sizeof(Ring));
+    Ring *ring = Ring::create_in(shm);
+
+    std::atomic<size_t> ready{0};
+    std::vector<std::vector<uint64_t>> samples(consumers);
+    std::vector<uint64_t> lost(consumers, 0);
+    std::vector<std::thread> threads;
+
+    for (size_t c = 0; c < consumers; c++) {
+      threads.emplace_back([&, c] {
+        bench::pin_thread(static_cast<unsigned>(c + 1));
+        core::SharedMemory view = core::SharedMemory::attach(shm_name);
+        Ring *mapped = Ring::attach_to(view);
+        core::BroadcastReader<Ring> reader(*mapped);
+        samples[c].reserve(ticks);
+        ready++;
+
+        protocol::TickPacket tick{};
+        while (reader.cursor() < ticks) {
+          if (reader.read(tick) == core::BroadcastReadStatus::Ok) {
+            samples[c].push_back(bench::now_ns() - tick.timestamp);
+          }
+        }
+        lost[c] = reader.lost();
+      });
+    }
+
+    while (ready.load() < consumers) {
+      std::this_thread::yield();
+    }
+
+    bench::pin_thread(0);
+    for (uint64_t seq = 0; seq < ticks; seq++) {
+      protocol::TickPacket tick{};
+      tick.sequence_num = seq;
+      tick.timestamp = bench::now_ns();
+      ring->publish(tick);
+      uint64_t next = tick.timestamp + 1000;
+      while (bench::now_ns() < next) {
+      }
+    }
+
+    ring->check_consumers(Ring::MASK / 2, [](int id, uint64_t lag,
+                                             uint64_t overruns) {
+      std::printf("  slow consumer %d: lag=%llu overruns=%llu\n", id,
+                  static_cast<unsigned long long>(lag),
+                  static_cast<unsigned long long>(overruns));
+    });
+
+    for (auto &t : threads) {
+      t.join();
+    }
+
+    std::vector<uint64_t> all;
+    uint64_t total_lost = 0;
+    for (size_t c = 0; c < consumers; c++) {
+      all.insert(all.end(), samples[c].begin(), samples[c].end());
+      total_lost += lost[c];
+    }
+    bench::print_latency(std::to_string(consumers) + " consumer(s)", all);
+    if (total_lost > 0) {
+      std::printf("  %llu ticks lost to overruns\n",
+                  static_cast<unsigned long long>(total_lost));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,252 @@
+// Restart-to-first-trade with and without checkpoints. A set of two
+// MeanReversion strategies (SMA100, SMA20) trades a random-walk stream,
+// checkpointing every 10000 ticks (1 s of market time at 10k ticks/sec),
+// and is killed partway through; the Publisher keeps sending while it is
+// down. On restart:
+//   cold  the strategies start empty and must refill every symbol's window
+//         from live ticks before they can trade
+//   warm  the newest checkpoint is restored and the ticks since it (the
+//         checkpoint interval plus the downtime) replayed, as the
+//         subscriber recovers them from the Publisher
+// Both report the ticks and wall time to the first order on a live tick,
+// and the market time those live ticks take to arrive at 10k ticks/sec.
+// The gap is replayed from memory here; over the recovery port it costs
+// one round trip per 256 ticks on top. The checkpoint cost on the strategy
+// thread (serialising into the staging buffer) and on the flusher (copy,
+// checksum, msync, commit) is reported too. The run compresses 1 s of
+// market time into a few ms of CPU, so checkpoints arrive faster than the
+// flusher retires them and some are skipped, as they would be on a slow
+// disk.
+// Every order of the warm restart must match the order an uninterrupted run
+// sent for the same tick; the run fails on any difference.
+//
+// Usage: checkpoint_bench [ticks] [symbols] [checkpoint file]
+
+#include "bench_utils.hpp"
+#include "checkpoint.hpp"
+#include "mean_reversion.hpp"
+#include "order_sink.hpp"
+#include "protocol.hpp"
+#include "strategy.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+constexpr size_t BENCH_SYMBOLS = 1 << 12;
+using Strategies =
+    strategy::StrategySet<strategy::MeanReversion<100, BENCH_SYMBOLS>,
+                          strategy::MeanReversion<20, BENCH_SYMBOLS>>;
+
+constexpr uint64_t TICK_SPACING_NS = 100000; // 10k ticks/sec
+constexpr uint64_t CHECKPOINT_EVERY = 10000;
+constexpr uint64_t DOWNTIME_TICKS = 20000;
+constexpr size_t SLOT_BYTES = size_t{64} << 20;
+
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] = std::max(1.0, prices[s] + step(rng));
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      stream[seq].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    stream[seq].price = prices[s];
+    stream[seq].quantity = 100;
+    stream[seq].sequence_num = seq;
+    stream[seq].timestamp = seq * TICK_SPACING_NS;
+  }
+  return stream;
+}
+
+// A strategy set with its order queue, drained after every tick
+struct Trader {
+  strategy::OrderQueue queue;
+  strategy::OrderSink sink{queue};
+  std::unique_ptr<Strategies> set;
+  std::vector<strategy::OrderIntent> orders;
+
+  Trader() {
+    strategy::StrategyConfig config;
+    config.orders = &sink;
+    set = std::make_unique<Strategies>(config);
+  }
+
+  // Orders sent for this tick
+  size_t on_tick(const protocol::TickPacket &tick) {
+    set->on_tick(tick);
+    size_t sent = 0;
+    while (const strategy::OrderIntent *order = queue.front()) {
+      orders.push_back(*order);
+      queue.pop();
+      sent++;
+    }
+    return sent;
+  }
+};
+
+static uint64_t seq_of(const strategy::OrderIntent &order) {
+  return order.tick_ns / TICK_SPACING_NS;
+}
+
+static bool same(const strategy::OrderIntent &a,
+                 const strategy::OrderIntent &b) {
+  return a.side == b.side && std::equal(a.symbol, a.symbol + 4, b.symbol) &&
+         a.price == b.price && a.quantity == b.quantity &&
+         a.tick_ns == b.tick_ns;
+}
+
+struct Restart {
+  uint64_t live_ticks = 0; // Live ticks up to and including the first trade
+  uint64_t wall_ns = 0;    // From process start to the first order
+  bool traded = false;
+};
+
+// Live ticks from first until an order goes out
+static void run_live(Trader &trader,
+                     const std::vector<protocol::TickPacket> &stream,
+                     size_t first, uint64_t start_ns, Restart &result) {
+  for (size_t seq = first; seq < stream.size(); seq++) {
+    result.live_ticks++;
+    if (trader.on_tick(stream[seq]) > 0) {
+      result.wall_ns = bench::now_ns() - start_ns;
+      result.traded = true;
+      return;
+    }
+  }
+  result.wall_ns = bench::now_ns() - start_ns;
+}
+
+static void print_restart(const char *label, const Restart &r) {
+  if (!r.traded) {
+    std::printf("%-32s no trade before the stream ended\n", label);
+    return;
+  }
+  std::printf("%-32s %8llu live ticks | %9.3f ms wall | %8.3f s market\n",
+              label, static_cast<unsigned long long>(r.live_ticks),
+              r.wall_ns / 1e6,
+              static_cast<double>(r.live_ticks * TICK_SPACING_NS) / 1e9);
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t symbols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+  const std::string path = argc > 3 ? argv[3] : "/tmp/checkpoint_bench.ckpt";
+  const size_t crash = ticks * 6 / 10;
+  const size_t resume = crash + DOWNTIME_TICKS;
+  if (symbols == 0 || symbols > BENCH_SYMBOLS || resume >= ticks) {
+    std::fprintf(stderr, "Need 1..%zu symbols and more than %llu ticks\n",
+                 BENCH_SYMBOLS,
+                 static_cast<unsigned long long>(DOWNTIME_TICKS * 2));
+    return 1;
+  }
+  std::printf("%zu ticks over %zu symbols, killed after seq %zu, %llu ticks "
+              "of downtime\n",
+              ticks, symbols, crash - 1,
+              static_cast<unsigned long long>(DOWNTIME_TICKS));
+  auto stream = make_stream(ticks, symbols);
+  unlink(path.c_str());
+
+  // Uninterrupted run: checkpoints until the kill, orders to the end
+  Trader reference;
+  std::vector<uint64_t> serialise;
+  uint64_t skipped = 0, flush_ns = 0, state_bytes = 0;
+  {
+    core::Checkpointer checkpoints(path, SLOT_BYTES);
+    for (size_t seq = 0; seq < ticks; seq++) {
+      reference.on_tick(stream[seq]);
+      if (seq + 1 >= crash || (seq + 1) % CHECKPOINT_EVERY != 0)
+        continue;
+      std::span<std::byte> slot = checkpoints.begin();
+      if (slot.empty()) {
+        skipped++;
+        continue;
+      }
+      uint64_t start = bench::now_ns();
+      core::CheckpointWriter out(slot);
+      reference.set->save_checkpoint(out);
+      serialise.push_back(bench::now_ns() - start);
+      checkpoints.submit(out.size(), seq);
+      state_bytes = out.size();
+      flush_ns = std::max(flush_ns, checkpoints.last_flush_ns());
+    }
+  }
+  std::printf("%-32s %llu bytes per checkpoint, %zu written, %llu skipped "
+              "(flush busy), slowest flush seen %.3f ms\n",
+              "checkpoint", static_cast<unsigned long long>(state_bytes),
+              serialise.size(), static_cast<unsigned long long>(skipped),
+              flush_ns / 1e6);
+  bench::print_latency("serialise (strategy thread)", serialise);
+
+  // Cold restart: empty strategies on the live stream
+  Restart cold;
+  {
+    uint64_t start = bench::now_ns();
+    Trader trader;
+    run_live(trader, stream, resume, start, cold);
+  }
+
+  // Warm restart: restore, replay the gap, then live
+  Restart warm;
+  Trader trader;
+  uint64_t restored_seq = 0, restore_ns = 0, replay_ns = 0;
+  size_t replay_orders = 0;
+  bool ok = false;
+  {
+    uint64_t start = bench::now_ns();
+    core::Checkpointer checkpoints(path, SLOT_BYTES);
+    if (auto snapshot = checkpoints.latest()) {
+      core::CheckpointReader in(snapshot->data);
+      ok = trader.set->restore_checkpoint(in);
+      restored_seq = snapshot->sequence;
+    }
+    restore_ns = bench::now_ns() - start;
+    for (size_t seq = restored_seq + 1; ok && seq < resume; seq++)
+      replay_orders += trader.on_tick(stream[seq]);
+    replay_ns = bench::now_ns() - start - restore_ns;
+    if (ok)
+      run_live(trader, stream, resume, start, warm);
+  }
+  if (!ok) {
+    std::printf("restore FAILED\n");
+    unlink(path.c_str());
+    return 1;
+  }
+  std::printf("%-32s seq %llu in %.3f ms, then %zu gap ticks replayed in "
+              "%.3f ms (%zu orders)\n",
+              "warm restore", static_cast<unsigned long long>(restored_seq),
+              restore_ns / 1e6, resume - restored_seq - 1, replay_ns / 1e6,
+              replay_orders);
+  print_restart("cold restart to first trade", cold);
+  print_restart("warm restart to first trade", warm);
+
+  // The warm run goes on to the end and must trade as the reference did
+  for (size_t seq = resume + warm.live_ticks; seq < ticks; seq++)
+    trader.on_tick(stream[seq]);
+  std::vector<strategy::OrderIntent> expected;
+  for (const strategy::OrderIntent &order : reference.orders) {
+    if (seq_of(order) > restored_seq)
+      expected.push_back(order);
+  }
+  bool match = expected.size() == trader.orders.size() &&
+               std::equal(expected.begin(), expected.end(),
+                          trader.orders.begin(), same) &&
+               reference.set->session_pnl() == trader.set->session_pnl();
+  std::printf("%-32s %s (%zu orders, PnL $%.2f)\n", "uninterrupted run check",
+              match ? "match" : "MISMATCH", expected.size(),
+              trader.set->session_pnl());
+  unlink(path.c_str());
+  return match ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Throughput of FanInQueue as feed-handler threads are added (1 to 8
+// producers into one strategy thread).
+//
+// Usage: fan_in_queue_bench [items_per_run]
+
+#include "bench_utils.hpp"
+#include "fan_in_queue.hpp"
+#include "protocol.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using FanIn = FanInQueue<protocol::TickPacket, 4096>;
+
+int main(int argc, char **argv) {
+  const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 40000000;
+
+  std::printf("FanInQueue throughput (%llu TickPackets per run)\n",
+              static_cast<unsigned long long>(n));
+
+  for (size_t producers : {1, 2, 3, 4, 6, 8}) {
+    FanIn fan_in(producers);
+    const uint64_t per_producer = n / producers;
+    const uint64_t total = per_producer * producers;
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+
+    for (size_t p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        bench::pin_thread(static_cast<unsigned>(p + 1));
+        auto &queue = fan_in.producer(p);
+        while (!go.load(std::memory_order_acquire)) {
+        }
+        for (uint64_t i = 0; i < per_producer; i++) {
+          protocol::TickPacket *slot;
+          while (!(slot = queue.claim_write())) {
+          }
+          slot->sequence_num = i;
+          queue.commit_write();
+        }
+      });
+    }
+
+    bench::pin_thread(0);
+    uint64_t received = 0;
+    uint64_t checksum = 0;
+
+    uint64_t start = bench::now_ns();
+    go.store(true, std::memory_order_release);
+    while (received < total) {
+      received += fan_in.drain([&](const protocol::TickPacket &tick) {
+        checksum += tick.sequence_num;
+      });
+    }
+    uint64_t elapsed = bench::now_ns() - start;
+
+    for (auto &t : threads) {
+      t.join();
+    }
+    bench::do_not_optimize(checksum);
+    bench::print_rate(std::to_string(producers) + " producer(s)", total,
+                      elapsed);
+  }
+  return 0;
+}
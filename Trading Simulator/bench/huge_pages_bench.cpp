@@ -0,0 +1,80 @@
+// TLB misses and access latency tails for random TickPacket reads from a
+// large buffer, on regular pages versus the huge-page allocation layer. The
+// access pattern mimics random-symbol lookups into RingBuffer/strategy state.
+//
+// Usage: huge_pages_bench [buffer_mb] [--huge-1g] [--numa-node=N]
+
+#include "bench_utils.hpp"
+#include "huge_pages.hpp"
+#include "perf_counters.hpp"
+#include "protocol.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+void run(bool huge, size_t bytes) {
+  core::huge_page_options().enabled = huge;
+  size_t len = core::huge_mapping_size(bytes);
+  core::PageBacking backing;
+  auto *ticks =
+      static_cast<protocol::TickPacket *>(core::huge_map(len, backing));
+  const size_t count = bytes / sizeof(protocol::TickPacket);
+
+  // Touch every page so faults stay out of the measurement
+  std::memset(static_cast<void *>(ticks), 1, bytes);
+
+  // Pre-generated random indices so the RNG is not measured
+  constexpr size_t BATCH = 64;
+  constexpr size_t BATCHES = 200000;
+  std::mt19937_64 rng(42);
+  std::vector<uint32_t> indices(BATCH * BATCHES);
+  for (auto &i : indices) {
+    i = static_cast<uint32_t>(rng() % count);
+  }
+
+  bench::PerfCounter tlb(bench::PerfEvent::DtlbLoadMisses);
+  std::vector<uint64_t> batch_ns;
+  batch_ns.reserve(BATCHES);
+  double sum = 0.0;
+
+  tlb.start();
+  uint64_t start = bench::now_ns();
+  for (size_t b = 0; b < BATCHES; b++) {
+    uint64_t t0 = bench::now_ns();
+    for (size_t k = 0; k < BATCH; k++) {
+      sum += ticks[indices[b * BATCH + k]].price;
+    }
+    batch_ns.push_back(bench::now_ns() - t0);
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  uint64_t misses = tlb.stop();
+  bench::do_not_optimize(sum);
+
+  std::string label = std::string(core::backing_name(backing));
+  bench::print_rate(label + " random reads", BATCH * BATCHES, elapsed);
+  if (tlb.available()) {
+    std::printf("%-32s %.3f dTLB misses per read\n", "",
+                static_cast<double>(misses) / (BATCH * BATCHES));
+  } else {
+    std::printf("%-32s dTLB counter unavailable (perf_event_open)\n", "");
+  }
+  bench::print_latency(label + " per 64 reads", batch_ns);
+
+  core::huge_unmap(ticks, len, backing);
+}
+
+int main(int argc, char **argv) {
+  core::CommandLine args(argc, argv);
+  core::configure_huge_pages(args);
+  size_t mb = (argc > 1 && argv[1][0] != '-')
+                  ? std::strtoul(argv[1], nullptr, 10)
+                  : 1024;
+  size_t bytes = mb << 20;
+
+  std::printf("Random TickPacket reads over a %zu MB buffer\n", mb);
+  run(false, bytes);
+  run(true, bytes);
+  return 0;
+}
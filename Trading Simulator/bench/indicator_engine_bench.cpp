@@ -0,0 +1,251 @@
+// Per-tick cost of indicators as the number of strategies and of
+// indicators per strategy grows. Each strategy declares K indicators from a
+// pool of eight (SMA 20/50/100/200, EMA 20/50/100, session VWAP), starting
+// at its own offset into the pool, and reads them on every tick:
+//   shared lazy    one IndicatorEngine for all strategies; identical
+//                  declarations share state, and the z-score (with its
+//                  sqrt) is only derived when the price is below the SMA
+//   private eager  one engine per strategy, every derived value computed
+//                  on every tick, as a strategy owning its statistics does
+// The engine's values are checked against a from-scratch recomputation,
+// and a StrategySet of VwapReversion strategies must make the same
+// decisions tick by tick and in batches.
+//
+// Usage: indicator_engine_bench [ticks] [symbols]
+
+#include "bench_utils.hpp"
+#include "indicators.hpp"
+#include "protocol.hpp"
+#include "strategy.hpp"
+#include "vwap_reversion.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+using strategy::Indicator;
+using strategy::IndicatorEngine;
+using strategy::IndicatorKind;
+
+struct Spec {
+  IndicatorKind kind;
+  uint32_t period;
+};
+
+constexpr Spec POOL[] = {
+    {IndicatorKind::Sma, 20},  {IndicatorKind::Sma, 50},
+    {IndicatorKind::Sma, 100}, {IndicatorKind::Sma, 200},
+    {IndicatorKind::Ema, 20},  {IndicatorKind::Ema, 50},
+    {IndicatorKind::Ema, 100}, {IndicatorKind::Vwap, 0},
+};
+constexpr size_t POOL_SIZE = std::size(POOL);
+
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::uniform_int_distribution<uint32_t> size(1, 10);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] += step(rng);
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      stream[seq].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    stream[seq].price = prices[s];
+    stream[seq].quantity = 100 * size(rng);
+    stream[seq].sequence_num = seq;
+    stream[seq].timestamp = seq * 1000;
+  }
+  return stream;
+}
+
+// A strategy reduced to its indicator reads
+struct Probe {
+  std::vector<Indicator> indicators;
+
+  Probe(IndicatorEngine &engine, size_t first, size_t count) {
+    for (size_t j = 0; j < count; j++) {
+      const Spec &spec = POOL[(first + j) % POOL_SIZE];
+      indicators.push_back(engine.declare(spec.kind, spec.period));
+    }
+  }
+
+  // Reads the primary values; derives the z-score only when eager or when
+  // the price is below the SMA (a strategy looking for a dip)
+  double read(const IndicatorEngine &engine, bool eager) const {
+    double sum = 0.0;
+    for (const Indicator &ind : indicators) {
+      if (!engine.ready(ind))
+        continue;
+      double value = engine.value(ind);
+      sum += value;
+      if (ind.kind == IndicatorKind::Sma &&
+          (eager || engine.price() < value))
+        sum += engine.zscore(ind);
+    }
+    return sum;
+  }
+};
+
+// Both runs pass over the stream once untimed, so symbol blocks are
+// allocated and windows full before the timed pass
+static uint64_t run_shared(const std::vector<protocol::TickPacket> &stream,
+                           size_t symbols, size_t strategies,
+                           size_t per_strategy, size_t &updates) {
+  IndicatorEngine engine(symbols);
+  std::vector<Probe> probes;
+  for (size_t i = 0; i < strategies; i++)
+    probes.emplace_back(engine, i, per_strategy);
+  updates = engine.size();
+  double sink = 0.0;
+  uint64_t start = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    start = bench::now_ns();
+    for (const protocol::TickPacket &tick : stream) {
+      engine.on_tick(tick);
+      for (const Probe &probe : probes)
+        sink += probe.read(engine, false);
+    }
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  bench::do_not_optimize(sink);
+  return elapsed;
+}
+
+static uint64_t run_private(const std::vector<protocol::TickPacket> &stream,
+                            size_t symbols, size_t strategies,
+                            size_t per_strategy, size_t &updates) {
+  std::vector<std::unique_ptr<IndicatorEngine>> engines;
+  std::vector<Probe> probes;
+  updates = 0;
+  for (size_t i = 0; i < strategies; i++) {
+    engines.push_back(std::make_unique<IndicatorEngine>(symbols));
+    probes.emplace_back(*engines.back(), i, per_strategy);
+    updates += engines.back()->size();
+  }
+  double sink = 0.0;
+  uint64_t start = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    start = bench::now_ns();
+    for (const protocol::TickPacket &tick : stream) {
+      for (size_t i = 0; i < strategies; i++) {
+        engines[i]->on_tick(tick);
+        sink += probes[i].read(*engines[i], true);
+      }
+    }
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  bench::do_not_optimize(sink);
+  return elapsed;
+}
+
+// Engine values against a from-scratch recomputation for one symbol
+static bool check_values(const std::vector<protocol::TickPacket> &stream,
+                         size_t symbols) {
+  IndicatorEngine engine(symbols);
+  Indicator sma = engine.sma(50);
+  Indicator ema = engine.ema(20);
+  Indicator vwap = engine.vwap();
+  const uint32_t key = core::symbol_key(stream[0].symbol);
+
+  std::deque<double> window;
+  double ema_value = 0.0, notional = 0.0, volume = 0.0;
+  bool seeded = false;
+  double worst = 0.0;
+  for (const protocol::TickPacket &tick : stream) {
+    engine.on_tick(tick);
+    if (core::symbol_key(tick.symbol) != key)
+      continue;
+    window.push_back(tick.price);
+    if (window.size() > sma.period)
+      window.pop_front();
+    ema_value = seeded ? ema_value + ema.alpha * (tick.price - ema_value)
+                       : tick.price;
+    seeded = true;
+    notional += tick.price * tick.quantity;
+    volume += tick.quantity;
+    if (!engine.ready(sma))
+      continue;
+
+    double mean = 0.0;
+    for (double p : window)
+      mean += p;
+    mean /= static_cast<double>(window.size());
+    double var = 0.0;
+    for (double p : window)
+      var += (p - mean) * (p - mean);
+    double sd = std::max(std::sqrt(var / static_cast<double>(window.size())),
+                         0.10);
+    auto rel = [](double a, double b) {
+      return std::fabs(a - b) / std::max(std::fabs(b), 1e-12);
+    };
+    worst = std::max({worst, rel(engine.value(sma), mean),
+                      rel(engine.std_dev(sma), sd),
+                      rel(engine.value(ema), ema_value),
+                      rel(engine.value(vwap), notional / volume)});
+  }
+  std::printf("%-32s %s (worst relative error %.2e)\n",
+              "recomputation check", worst < 1e-9 ? "match" : "MISMATCH",
+              worst);
+  return worst < 1e-9;
+}
+
+using VwapSet = strategy::StrategySet<strategy::VwapReversion<50, 1 << 12>,
+                                      strategy::VwapReversion<100, 1 << 12>>;
+
+// Tick-by-tick and batched runs of the same set must trade identically
+static bool check_strategies(const std::vector<protocol::TickPacket> &stream) {
+  auto by_tick = std::make_unique<VwapSet>();
+  auto by_batch = std::make_unique<VwapSet>();
+  uint64_t start = bench::now_ns();
+  for (const protocol::TickPacket &tick : stream)
+    by_tick->on_tick(tick);
+  uint64_t elapsed = bench::now_ns() - start;
+  for (size_t i = 0; i < stream.size(); i += 256) {
+    size_t n = std::min<size_t>(256, stream.size() - i);
+    by_batch->on_batch({stream.data() + i, n});
+  }
+  bench::print_rate("StrategySet of 2 VwapReversion", stream.size(), elapsed);
+  bool ok = by_tick->session_pnl() == by_batch->session_pnl();
+  std::printf("%-32s %s (PnL $%.2f)\n", "tick vs batch check",
+              ok ? "match" : "MISMATCH", by_tick->session_pnl());
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t symbols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+  std::printf("%zu ticks over %zu symbols\n", ticks, symbols);
+  auto stream = make_stream(ticks, symbols);
+
+  std::printf("%-11s %-11s %14s %14s %14s %14s\n", "strategies",
+              "indicators", "shared upd", "shared ns/tick", "private upd",
+              "private ns/tick");
+  for (size_t strategies : {1, 4, 16}) {
+    for (size_t per_strategy : {1, 4, 8}) {
+      size_t shared_updates = 0, private_updates = 0;
+      uint64_t shared = run_shared(stream, symbols, strategies, per_strategy,
+                                   shared_updates);
+      uint64_t priv = run_private(stream, symbols, strategies, per_strategy,
+                                  private_updates);
+      std::printf("%-11zu %-11zu %14zu %14.1f %14zu %14.1f\n", strategies,
+                  per_strategy, shared_updates,
+                  static_cast<double>(shared) / ticks, private_updates,
+                  static_cast<double>(priv) / ticks);
+    }
+  }
+
+  bool ok = check_values(stream, symbols);
+  ok = check_strategies(stream) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// L2 market-by-price feed against the L3 feed it conflates. A generated
+// order flow (adds, cancels, sweeps over 50 symbols) runs through the
+// matching engine; every L3 book update marks its symbol, and the
+// MarketByPrice publisher is flushed every W orders, standing in for the
+// publisher's --depth-window-ms timer. Per window it reports:
+//   L3 / L2 msgs   messages on each channel and the reduction
+//   flush          publisher cost per L2 message emitted (diff + copy)
+//   apply          subscriber MbpBuilder updates/sec
+// The subscriber's books are compared with the engine's top levels after
+// every flush; the run fails on any difference or rejected update. A
+// second subscriber loses every 1000th message: it must hold no book it
+// cannot vouch for, and hold every book again after one refresh.
+//
+// Usage: market_by_price_bench [orders]
+
+#include "bench_utils.hpp"
+#include "book_builder.hpp"
+#include "market_by_price.hpp"
+#include "matching_engine.hpp"
+#include "order_flow.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using bench::flow_symbol;
+using bench::FLOW_SYMBOLS;
+
+constexpr size_t DEPTH = 10;
+
+using Publisher = exchange::MarketByPrice<DEPTH>;
+using Builder = core::MbpBuilder<DEPTH>;
+
+struct Marking {
+  Publisher &mbp;
+  uint64_t l3 = 0;
+
+  void on_execution(const exchange::Execution &) {}
+  void on_book_update(const protocol::BookUpdate &update) {
+    l3++;
+    mbp.mark(update.symbol);
+  }
+};
+
+using Engine = exchange::MatchingEngine<Marking>;
+
+// Subscriber book matches the engine's top DEPTH levels on both sides
+static bool same_top(Engine &engine, Builder &builder, uint32_t s) {
+  const exchange::OrderBook *book = engine.book(flow_symbol(s));
+  const Builder::Book *held = builder.book(flow_symbol(s));
+  if (!book)
+    return held == nullptr;
+  for (protocol::Side side : {protocol::Side::Buy, protocol::Side::Sell}) {
+    size_t held_levels = held ? held->levels(side) : 0;
+    bool ok = true;
+    size_t i = 0;
+    book->for_each_level(
+        side, DEPTH, [&](int64_t price, const exchange::PriceLevel &lvl) {
+          ok = ok && i < held_levels &&
+               held->level(side, i).price == price &&
+               held->level(side, i).quantity == lvl.quantity;
+          i++;
+        });
+    if (!ok || i != held_levels)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const size_t orders =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  std::vector<bench::Op> ops = bench::generate_order_flow(orders);
+  std::printf("%zu orders over %zu symbols, top %zu levels\n", orders,
+              FLOW_SYMBOLS, DEPTH);
+  std::printf("%-8s %12s %12s %10s %14s %14s\n", "window", "L3 msgs",
+              "L2 msgs", "L2 / L3", "flush ns/msg", "apply msgs/s");
+
+  bool ok = true;
+  for (size_t window : {1, 10, 100, 1000, 10000}) {
+    Publisher mbp;
+    Marking listener{mbp};
+    Engine engine(listener, 1 << 20);
+    Builder builder;
+    std::vector<protocol::LevelUpdate> stream;
+    uint64_t flush_ns = 0;
+    uint64_t rejected = 0;
+
+    auto flush = [&] {
+      size_t first = stream.size();
+      uint64_t start = bench::now_ns();
+      mbp.flush(engine, [&](const protocol::LevelUpdate &update) {
+        stream.push_back(update);
+        stream.back().sequence_num = stream.size();
+      });
+      flush_ns += bench::now_ns() - start;
+      for (size_t i = first; i < stream.size(); i++)
+        rejected += builder.apply(stream[i]) == nullptr;
+      for (uint32_t s = 0; s < FLOW_SYMBOLS; s++)
+        ok = ok && same_top(engine, builder, s);
+    };
+
+    for (size_t i = 0; i < ops.size(); i++) {
+      const bench::Op &op = ops[i];
+      if (op.kind == bench::OpKind::Cancel)
+        engine.cancel(0, op.client_id);
+      else
+        engine.add(0, op.client_id, flow_symbol(op.symbol), op.side,
+                   op.price, op.quantity, op.kind == bench::OpKind::Take);
+      if ((i + 1) % window == 0)
+        flush();
+    }
+    flush();
+    ok = ok && rejected == 0;
+
+    // Lossy subscriber: empties its books on each gap, as the subscriber
+    // does, then resyncs from a refresh
+    Builder lossy;
+    for (size_t i = 0; i < stream.size(); i++) {
+      if (i % 1000 == 999)
+        lossy.desync();
+      else
+        lossy.apply(stream[i]);
+    }
+    for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+      const Builder::Book *held = lossy.book(flow_symbol(s));
+      ok = ok && (!held || !lossy.synced(*held) ||
+                  same_top(engine, lossy, s));
+    }
+    mbp.refresh([&](const protocol::LevelUpdate &update) {
+      ok = ok && lossy.apply(update) != nullptr;
+    });
+    for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+      const Builder::Book *held = lossy.book(flow_symbol(s));
+      ok = ok && (!held || lossy.synced(*held)) &&
+           same_top(engine, lossy, s);
+    }
+
+    // Subscriber side alone: best of 3 fresh builders over the stream
+    uint64_t apply_best = UINT64_MAX;
+    for (int run = 0; run < 3; run++) {
+      Builder fresh;
+      uint64_t start = bench::now_ns();
+      for (const protocol::LevelUpdate &update : stream)
+        bench::do_not_optimize(fresh.apply(update));
+      apply_best = std::min(apply_best, bench::now_ns() - start);
+    }
+
+    double l2 = static_cast<double>(stream.size());
+    std::printf("%-8zu %12llu %12zu %9.1f%% %14.1f %14.0f\n", window,
+                static_cast<unsigned long long>(listener.l3), stream.size(),
+                100.0 * l2 / static_cast<double>(listener.l3),
+                stream.empty() ? 0.0 : static_cast<double>(flush_ns) / l2,
+                apply_best ? l2 * 1e9 / static_cast<double>(apply_best) : 0.0);
+  }
+  std::printf("%-32s %s\n", "engine top-of-book check",
+              ok ? "match" : "MISMATCH");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Ticks generated per second with the network and the matching engine
+// taken out: the Publisher's original loop (std::mt19937, a chain of
+// static distributions, the symbol table rebuilt per tick) against
+// MarketGenerator (xoshiro256++ lanes, random blocks, ziggurat normals,
+// per-symbol arrays).
+// Each tick is written out as a TickPacket (symbol, price) either way.
+// MarketGenerator runs at 10 ticks per call (one Publisher timer event at
+// the default rate) and 4096, over 50 and 5000 symbols.
+// The two generators draw different numbers, so their markets are checked
+// against each other statistically: share of buys, symbol spread (chi
+// square over degrees of freedom, ~1 for uniform), walk volatility (std of
+// log returns under 2%) and the share of jumps of 2% or more (flash moves
+// and permanent shifts). MarketGenerator must also give the same stream
+// whatever the batch size.
+//
+// Usage: market_generator_bench [ticks]
+
+#include "bench_utils.hpp"
+#include "market_generator.hpp"
+#include "protocol.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr size_t LEGACY_SYMBOLS = 50;
+
+// The Publisher's per-tick generation before MarketGenerator
+static void legacy_tick(protocol::TickPacket &out, uint32_t &sym_out) {
+  static std::mt19937 rng{42};
+  static std::uniform_int_distribution<uint32_t> sym_dist(0, 49);
+  static std::normal_distribution<double> price_delta_dist(0.0, 0.01);
+  static std::vector<double> current_prices(50, 0.0);
+  static bool prices_initialised = false;
+  if (!prices_initialised) {
+    for (int i = 0; i < 50; i++)
+      current_prices[i] = 100.0 + (i * 7);
+    prices_initialised = true;
+  }
+  const char *symbols[] = {
+      "AAPL", "MSFT", "GOOG", "AMZN", "META", "TSLA", "NVDA", "JPM",
+      "JNJ",  "V",    "UNH",  "PG",   "HD",   "DIS",  "MA",   "BAC",
+      "VZ",   "CRM",  "XOM",  "PFE",  "NKE",  "INTC", "T",    "KO",
+      "MRK",  "PEP",  "ABT",  "WMT",  "CVX",  "CSCO", "MCD",  "ABBV",
+      "MDT",  "BMY",  "ACN",  "AVGO", "TXN",  "COST", "NEE",  "QCOM",
+      "DHR",  "LIN",  "PM",   "UNP",  "LOW",  "HON",  "UPS",  "IBM",
+      "SBUX", "CAT"};
+
+  uint32_t sym_idx = sym_dist(rng);
+  current_prices[sym_idx] += current_prices[sym_idx] * price_delta_dist(rng);
+  if (current_prices[sym_idx] < 1.0)
+    current_prices[sym_idx] = 1.0;
+  double published_price = current_prices[sym_idx];
+
+  static std::uniform_int_distribution<int> fund_drop_dist(1, 500);
+  static std::uniform_int_distribution<int> fund_spike_dist(1, 1000);
+  if (fund_drop_dist(rng) == 1) {
+    static std::uniform_real_distribution<double> drop_depth(0.06, 0.09);
+    current_prices[sym_idx] -= current_prices[sym_idx] * drop_depth(rng);
+    if (current_prices[sym_idx] < 1.0)
+      current_prices[sym_idx] = 1.0;
+    published_price = current_prices[sym_idx];
+  } else if (fund_spike_dist(rng) == 1) {
+    static std::uniform_real_distribution<double> spike_depth(0.06, 0.09);
+    current_prices[sym_idx] += current_prices[sym_idx] * spike_depth(rng);
+    published_price = current_prices[sym_idx];
+  } else {
+    static std::uniform_int_distribution<int> anomaly_drop_dist(1, 100);
+    static std::uniform_int_distribution<int> anomaly_spike_dist(1, 200);
+    if (anomaly_drop_dist(rng) == 1) {
+      static std::uniform_real_distribution<double> a_drop_depth(0.025, 0.05);
+      published_price -= published_price * a_drop_depth(rng);
+    } else if (anomaly_spike_dist(rng) == 1) {
+      static std::uniform_real_distribution<double> a_spike_depth(0.025,
+                                                                  0.05);
+      published_price += published_price * a_spike_depth(rng);
+    }
+  }
+
+  std::memset(out.symbol, 0, sizeof(out.symbol));
+  std::strncpy(out.symbol, symbols[sym_idx], sizeof(out.symbol) - 1);
+  out.price = published_price;
+  out.quantity = (rng() & 1) ? 1 : 0; // Side, kept for the statistics
+  sym_out = sym_idx;
+}
+
+// Market statistics over a generated stream
+struct Stats {
+  explicit Stats(size_t symbols) : last(symbols, 0.0), seen(symbols, 0) {}
+
+  void add(uint32_t symbol, double price, bool buy) {
+    ticks++;
+    buys += buy;
+    seen[symbol]++;
+    if (last[symbol] > 0.0) {
+      double r = std::log(price / last[symbol]);
+      if (std::fabs(r) >= 0.02) {
+        jumps++;
+      } else {
+        walk++;
+        sum += r;
+        sum_sq += r * r;
+      }
+    }
+    last[symbol] = price;
+  }
+
+  double buy_share() const { return static_cast<double>(buys) / ticks; }
+  double jump_share() const { return static_cast<double>(jumps) / ticks; }
+  double volatility() const {
+    double mean = sum / walk;
+    return std::sqrt(sum_sq / walk - mean * mean);
+  }
+  double chi_square() const {
+    double expected = static_cast<double>(ticks) / seen.size();
+    double chi = 0.0;
+    for (uint64_t n : seen)
+      chi += (n - expected) * (n - expected) / expected;
+    return chi / static_cast<double>(seen.size() - 1);
+  }
+
+  std::vector<double> last;
+  std::vector<uint64_t> seen;
+  uint64_t ticks = 0, buys = 0, jumps = 0, walk = 0;
+  double sum = 0.0, sum_sq = 0.0;
+};
+
+static void print_stats(const char *label, const Stats &s) {
+  std::printf("  %-30s %9.4f %9.3f %11.5f %9.4f\n", label, s.buy_share(),
+              s.chi_square(), s.volatility(), s.jump_share());
+}
+
+static bool close_to(double a, double b, double tolerance) {
+  return std::fabs(a - b) <= tolerance * std::fabs(b);
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+  std::vector<protocol::TickPacket> out(4096);
+  std::printf("%zu ticks per run\n", ticks);
+
+  // Original loop
+  Stats legacy(LEGACY_SYMBOLS);
+  {
+    uint32_t sym = 0;
+    uint64_t start = bench::now_ns();
+    for (size_t i = 0; i < ticks; i++)
+      legacy_tick(out[i % out.size()], sym);
+    bench::print_rate("mt19937 loop, 50 symbols", ticks,
+                      bench::now_ns() - start);
+    bench::do_not_optimize(out[0]);
+    for (size_t i = 0; i < ticks; i++) {
+      protocol::TickPacket tick;
+      legacy_tick(tick, sym);
+      legacy.add(sym, tick.price, tick.quantity == 1);
+    }
+  }
+
+  // MarketGenerator at two batch sizes and two universes
+  for (size_t symbols : {size_t{50}, size_t{5000}}) {
+    for (size_t batch : {size_t{10}, size_t{4096}}) {
+      exchange::MarketGenerator<> generator(42, symbols);
+      std::vector<exchange::GeneratedTick> moves(batch);
+      size_t done = 0;
+      uint64_t start = bench::now_ns();
+      for (; done < ticks; done += batch) {
+        generator.generate(moves);
+        for (size_t i = 0; i < batch; i++) {
+          protocol::TickPacket &tick = out[i];
+          std::memcpy(tick.symbol, generator.name(moves[i].symbol),
+                      sizeof(tick.symbol));
+          tick.price = moves[i].price;
+        }
+        bench::do_not_optimize(out[0]);
+      }
+      char label[64];
+      std::snprintf(label, sizeof(label), "generator, %zu sym, batch %zu",
+                    symbols, batch);
+      bench::print_rate(label, done, bench::now_ns() - start);
+    }
+  }
+
+  // Statistics, and the same stream at batch 1, 10 and 4096
+  Stats fast(LEGACY_SYMBOLS);
+  bool same_stream = true;
+  {
+    exchange::MarketGenerator<> a(7), b(7), c(7);
+    std::vector<exchange::GeneratedTick> one(1), ten(10), big(4096);
+    std::vector<exchange::GeneratedTick> stream;
+    for (size_t done = 0; done < ticks; done += big.size()) {
+      c.generate(big);
+      for (const exchange::GeneratedTick &move : big) {
+        fast.add(move.symbol, move.price, move.side == protocol::Side::Buy);
+        if (stream.size() < 100000)
+          stream.push_back(move);
+      }
+    }
+    for (size_t i = 0; i < stream.size(); i++) {
+      a.generate(one);
+      if (i % ten.size() == 0)
+        b.generate(ten);
+      const exchange::GeneratedTick &x = ten[i % ten.size()];
+      same_stream = same_stream && one[0].price == stream[i].price &&
+                    one[0].symbol == stream[i].symbol &&
+                    x.price == stream[i].price && x.side == stream[i].side;
+    }
+  }
+  std::printf("%-32s %9s %9s %11s %9s\n", "market (50 symbols)", "buys",
+              "chi2/df", "volatility", "jumps");
+  print_stats("mt19937 loop", legacy);
+  print_stats("generator", fast);
+
+  bool match = close_to(fast.buy_share(), legacy.buy_share(), 0.01) &&
+               fast.chi_square() < 2.0 && legacy.chi_square() < 2.0 &&
+               close_to(fast.volatility(), legacy.volatility(), 0.02) &&
+               close_to(fast.jump_share(), legacy.jump_share(), 0.05);
+  std::printf("%-32s %s\n", "market check", match ? "match" : "MISMATCH");
+  std::printf("%-32s %s\n", "batch size check",
+              same_stream ? "match" : "MISMATCH");
+  return match && same_stream ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+// Matching engine throughput and per-operation latency on a generated order
+// flow over 50 symbols: passive adds around a random-walking mid, cancels of
+// earlier orders and marketable orders that sweep one or more levels.
+//   throughput  orders/sec and executions/sec with no per-op timing
+//   latency     add (rests), cancel, match (trades on arrival) percentiles,
+//               each including ~20-30 ns of clock overhead
+// The same flow is replayed through a std::map reference book; traded
+// volume, notional and the final BBOs must match.
+//
+// Usage: matching_engine_bench [operations]
+
+#include "bench_utils.hpp"
+#include "matching_engine.hpp"
+#include "order_flow.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+using bench::flow_symbol;
+using bench::FLOW_SYMBOLS;
+using bench::Op;
+using bench::OpKind;
+
+struct Totals {
+  uint64_t executions = 0;
+  uint64_t volume = 0;
+  int64_t notional = 0;
+
+  bool operator==(const Totals &) const = default;
+};
+
+struct CountingListener {
+  Totals totals;
+  uint64_t book_updates = 0;
+
+  void on_execution(const exchange::Execution &exec) {
+    totals.executions++;
+    totals.volume += exec.quantity;
+    totals.notional += exec.price * exec.quantity;
+  }
+  void on_book_update(const protocol::BookUpdate &update) {
+    bench::do_not_optimize(update);
+    book_updates++;
+  }
+};
+
+using Engine = exchange::MatchingEngine<CountingListener>;
+
+// Straightforward price-time book: std::map levels of std::list FIFOs
+class ReferenceBook {
+public:
+  struct Resting {
+    uint64_t id;
+    uint32_t quantity;
+  };
+
+  void add(const Op &op, Totals &totals) {
+    bool buy = op.side == protocol::Side::Buy;
+    uint32_t quantity = op.quantity;
+    if (buy)
+      quantity = cross(asks_, op, quantity, totals,
+                       [&](int64_t p) { return p <= op.price; });
+    else
+      quantity = cross(bids_, op, quantity, totals,
+                       [&](int64_t p) { return p >= op.price; });
+    if (quantity == 0 || op.kind == OpKind::Take)
+      return;
+    auto &level = buy ? bids_[op.price] : asks_[op.price];
+    level.push_back({op.client_id, quantity});
+    index_[op.client_id] = {buy, op.price, std::prev(level.end())};
+  }
+
+  void cancel(uint64_t id) {
+    auto it = index_.find(id);
+    if (it == index_.end())
+      return;
+    Where where = it->second;
+    if (where.buy)
+      erase(bids_, where);
+    else
+      erase(asks_, where);
+    index_.erase(it);
+  }
+
+  int64_t best_bid() const {
+    return bids_.empty() ? core::NO_BID : bids_.begin()->first;
+  }
+  int64_t best_ask() const {
+    return asks_.empty() ? core::NO_ASK : asks_.begin()->first;
+  }
+
+private:
+  using Fifo = std::list<Resting>;
+  struct Where {
+    bool buy;
+    int64_t price;
+    Fifo::iterator it;
+  };
+
+  template <typename Side, typename Crosses>
+  uint32_t cross(Side &side, const Op &op, uint32_t quantity, Totals &totals,
+                 Crosses crosses) {
+    (void)op;
+    while (quantity > 0 && !side.empty() && crosses(side.begin()->first)) {
+      Fifo &fifo = side.begin()->second;
+      Resting &maker = fifo.front();
+      uint32_t traded = std::min(quantity, maker.quantity);
+      quantity -= traded;
+      maker.quantity -= traded;
+      totals.executions++;
+      totals.volume += traded;
+      totals.notional += side.begin()->first * traded;
+      if (maker.quantity == 0) {
+        index_.erase(maker.id);
+        fifo.pop_front();
+        if (fifo.empty())
+          side.erase(side.begin());
+      }
+    }
+    return quantity;
+  }
+
+  template <typename Side> void erase(Side &side, const Where &where) {
+    auto level = side.find(where.price);
+    level->second.erase(where.it);
+    if (level->second.empty())
+      side.erase(level);
+  }
+
+  std::map<int64_t, Fifo, std::greater<int64_t>> bids_;
+  std::map<int64_t, Fifo> asks_;
+  std::unordered_map<uint64_t, Where> index_;
+};
+
+static void apply(Engine &engine, const Op &op) {
+  if (op.kind == OpKind::Cancel)
+    engine.cancel(0, op.client_id);
+  else
+    engine.add(0, op.client_id, flow_symbol(op.symbol), op.side,
+               op.price, op.quantity, op.kind == OpKind::Take);
+}
+
+int main(int argc, char **argv) {
+  const size_t count =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  std::vector<Op> ops = bench::generate_order_flow(count);
+  std::printf("%zu operations over %zu symbols\n", count, FLOW_SYMBOLS);
+
+  // Throughput: untimed operations, best of 3 fresh engines
+  uint64_t best = UINT64_MAX;
+  CountingListener counted;
+  for (int run = 0; run < 3; run++) {
+    CountingListener listener;
+    Engine engine(listener, 1 << 20);
+    uint64_t start = bench::now_ns();
+    for (const Op &op : ops)
+      apply(engine, op);
+    best = std::min(best, bench::now_ns() - start);
+    counted = listener;
+  }
+  bench::print_rate("orders", count, best);
+  bench::print_rate("executions", counted.totals.executions, best);
+  std::printf("%-32s %llu\n", "book updates",
+              static_cast<unsigned long long>(counted.book_updates));
+
+  // Latency per operation kind
+  CountingListener listener;
+  Engine engine(listener, 1 << 20);
+  std::vector<uint64_t> add_ns, cancel_ns, match_ns;
+  add_ns.reserve(count);
+  cancel_ns.reserve(count);
+  match_ns.reserve(count);
+  for (const Op &op : ops) {
+    uint64_t executions = listener.totals.executions;
+    uint64_t start = bench::now_ns();
+    apply(engine, op);
+    uint64_t elapsed = bench::now_ns() - start;
+    if (op.kind == OpKind::Cancel)
+      cancel_ns.push_back(elapsed);
+    else if (listener.totals.executions != executions)
+      match_ns.push_back(elapsed);
+    else
+      add_ns.push_back(elapsed);
+  }
+  bench::print_latency("add (rests)", add_ns);
+  bench::print_latency("cancel", cancel_ns);
+  bench::print_latency("match (trades on arrival)", match_ns);
+
+  // Reference replay
+  std::vector<ReferenceBook> reference(FLOW_SYMBOLS);
+  Totals expected;
+  std::vector<uint32_t> symbol_of(count + 1);
+  for (const Op &op : ops) {
+    if (op.kind == OpKind::Cancel) {
+      reference[symbol_of[op.client_id]].cancel(op.client_id);
+    } else {
+      symbol_of[op.client_id] = op.symbol;
+      reference[op.symbol].add(op, expected);
+    }
+  }
+  bool ok = expected == listener.totals;
+  for (uint32_t s = 0; s < FLOW_SYMBOLS; s++) {
+    const exchange::OrderBook *book = engine.book(flow_symbol(s));
+    int64_t bid = book ? book->best_bid() : core::NO_BID;
+    int64_t ask = book ? book->best_ask() : core::NO_ASK;
+    ok = ok && bid == reference[s].best_bid() && ask == reference[s].best_ask();
+  }
+  std::printf("%-32s %s (%llu executions, %llu shares)\n",
+              "reference book check", ok ? "match" : "MISMATCH",
+              static_cast<unsigned long long>(expected.executions),
+              static_cast<unsigned long long>(expected.volume));
+  return ok ? 0 : 1;
+}
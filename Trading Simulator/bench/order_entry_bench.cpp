@@ -0,0 +1,113 @@
+// Order entry round trip over loopback TCP: OrderSink -> gateway thread ->
+// non-blocking session -> exchange stub (ack + fill, as the publisher's
+// order endpoint) and back. Orders are submitted at a paced rate and then
+// unthrottled; each run reports the gateway's histograms:
+//   tick-to-order  decision (submit) -> order written to the socket
+//   order-to-ack   order written -> ack read back
+// The paced run is repeated with the gateway on --wait=block. Each run ends
+// with the session idle for IDLE_MS and reports the CPU used meanwhile: a
+// spinning gateway costs a core whether or not orders are flowing.
+//
+// Usage: order_entry_bench [orders per run]
+
+#include "bench_utils.hpp"
+#include "networking.hpp"
+#include "order_entry.hpp"
+#include "protocol.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int BENCH_ORDER_PORT = 40102;
+constexpr int IDLE_MS = 200;
+
+static void exchange_stub(int listen_sock, size_t sessions) {
+  auto handle = [](const protocol::OrderMessage &msg,
+                   std::vector<protocol::OrderMessage> &replies) {
+    replies.push_back(networking::order_reply(msg, protocol::OrderType::Ack));
+    protocol::OrderMessage fill =
+        networking::order_reply(msg, protocol::OrderType::Fill);
+    fill.leaves = 0;
+    replies.push_back(fill);
+  };
+  for (size_t s = 0; s < sessions; s++) {
+    int fd = accept(listen_sock, nullptr, nullptr);
+    if (fd < 0)
+      return;
+    networking::set_tcp_low_latency(fd);
+    networking::serve_order_session(fd, handle);
+    close(fd);
+  }
+}
+
+// rate = orders per second, 0 for as fast as the queue accepts them
+static void run(size_t orders, uint64_t rate,
+                core::WaitKind wait = core::WaitKind::BusySpin) {
+  networking::OrderGateway gateway("127.0.0.1", BENCH_ORDER_PORT, 1, wait);
+  strategy::OrderSink &sink = gateway.sink(0);
+  const char symbol[4] = {'A', 'A', 'P', 'L'};
+  const uint64_t interval = rate ? 1000000000ull / rate : 0;
+
+  uint64_t start = bench::now_ns();
+  for (size_t i = 0; i < orders; i++) {
+    if (interval) {
+      uint64_t due = start + i * interval;
+      // Yield rather than spin, so the run is meaningful on few cores
+      while (bench::now_ns() < due) {
+        std::this_thread::yield();
+      }
+    }
+    protocol::Side side =
+        (i & 1) ? protocol::Side::Sell : protocol::Side::Buy;
+    while (!sink.submit(side, symbol, 150.0, 100,
+                        networking::order_clock_ns())) {
+      std::this_thread::yield();
+    }
+  }
+  while (gateway.filled() + gateway.rejected() < orders &&
+         gateway.connected()) {
+    std::this_thread::yield();
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+
+  std::clock_t cpu_start = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+  double idle_cpu =
+      static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  gateway.stop();
+
+  std::string label =
+      rate ? std::to_string(rate) + " orders/sec" : "unthrottled";
+  if (wait != core::WaitKind::BusySpin)
+    label += ", gateway --wait=block";
+  std::printf("--- %s ---\n", label.c_str());
+  bench::print_rate("round trips", orders, elapsed);
+  std::printf("%-32s %.0f%% of one core\n", "CPU while idle",
+              100.0 * idle_cpu / (IDLE_MS / 1e3));
+  gateway.tick_to_order().print("tick-to-order");
+  gateway.order_to_ack().print("order-to-ack");
+  gateway.order_to_fill().print("order-to-fill");
+}
+
+int main(int argc, char **argv) {
+  const size_t orders =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  const std::vector<uint64_t> rates = {10000, 100000, 0};
+
+  int listen_sock = networking::create_tcp_listener(BENCH_ORDER_PORT);
+  std::thread exchange(exchange_stub, listen_sock, rates.size() + 1);
+
+  std::printf("%zu orders per run over loopback\n", orders);
+  for (uint64_t rate : rates) {
+    run(orders, rate);
+  }
+  run(orders, rates[0], core::WaitKind::Blocking);
+
+  exchange.join();
+  close(listen_sock);
+  return 0;
+}
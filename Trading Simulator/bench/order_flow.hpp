@@ -0,0 +1,89 @@
+#pragma once
+
+// Generated order flow shared by the order book benchmarks: passive adds
+// around a random-walking mid per symbol, cancels of earlier adds and
+// marketable orders that trade on arrival.
+
+#include "protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+constexpr size_t FLOW_SYMBOLS = 50;
+
+enum class OpKind { Add, Cancel, Take };
+
+struct Op {
+  OpKind kind;
+  uint32_t symbol; // 0..FLOW_SYMBOLS-1
+  protocol::Side side;
+  int64_t price; // Ticks
+  uint32_t quantity;
+  uint64_t client_id; // For a Cancel, the Add it cancels
+};
+
+// Wire symbol of flow symbol s: "AAX", "ABX", ...
+inline const char (&flow_symbol(uint32_t s))[4] {
+  struct Names {
+    char names[FLOW_SYMBOLS][4];
+    Names() {
+      for (size_t i = 0; i < FLOW_SYMBOLS; i++) {
+        names[i][0] = static_cast<char>('A' + i / 26);
+        names[i][1] = static_cast<char>('A' + i % 26);
+        names[i][2] = 'X';
+        names[i][3] = '\0';
+      }
+    }
+  };
+  static const Names table;
+  return table.names[s];
+}
+
+// Roughly 55% adds, 30% cancels and 15% marketable orders; a quarter of
+// those are large enough to sweep several levels
+inline std::vector<Op> generate_order_flow(size_t count, uint64_t seed = 42) {
+  std::mt19937_64 rng(seed);
+  std::vector<int64_t> mid(FLOW_SYMBOLS);
+  for (size_t s = 0; s < FLOW_SYMBOLS; s++)
+    mid[s] = 10000 + static_cast<int64_t>(s) * 700;
+  std::vector<uint64_t> live;
+  std::vector<Op> ops;
+  ops.reserve(count);
+  uint64_t next_id = 1;
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t s = static_cast<uint32_t>(rng() % FLOW_SYMBOLS);
+    mid[s] += static_cast<int64_t>(rng() % 3) - 1;
+    protocol::Side side =
+        (rng() & 1) ? protocol::Side::Buy : protocol::Side::Sell;
+    bool buy = side == protocol::Side::Buy;
+    unsigned roll = static_cast<unsigned>(rng() % 100);
+
+    Op op{OpKind::Add, s, side, 0, 0, next_id++};
+    if (roll < 30 && !live.empty()) {
+      size_t pick = rng() % live.size();
+      op.kind = OpKind::Cancel;
+      op.client_id = live[pick];
+      live[pick] = live.back();
+      live.pop_back();
+    } else if (roll < 45) {
+      op.kind = OpKind::Take;
+      int64_t reach = (rng() & 3) == 0 ? 10 : 1;
+      op.price = buy ? mid[s] + reach : mid[s] - reach;
+      op.quantity = 100 + static_cast<uint32_t>(rng() % 400) *
+                              ((rng() & 3) == 0 ? 10 : 1);
+    } else {
+      int64_t offset = 1 + static_cast<int64_t>(rng() % 20);
+      op.price = buy ? mid[s] - offset : mid[s] + offset;
+      op.quantity = 100 * (1 + static_cast<uint32_t>(rng() % 10));
+      live.push_back(op.client_id);
+    }
+    ops.push_back(op);
+  }
+  return ops;
+}
+
+} // namespace bench
@@ -0,0 +1,227 @@
+// The Publisher's tick path run on one thread against the three-stage
+// pipeline (generator, sequencer, sender threads), over the UDP feed:
+//   send         one sendto per tick against FeedSender::send_batch, which
+//                is one sendmmsg per SEND_BATCH ticks on Linux
+//   inline       generate, trade through the matching engine, stamp, fill
+//                the recovery RingBuffer and send, all on this thread
+//   pipelined    GeneratorStage -> this thread (engine, stamp, RingBuffer)
+//                -> SenderStage, with each stage's throughput, the deepest
+//                queue seen and the gap between consecutive ticks at the
+//                sequencer, which no longer includes the send
+// Both runs must sequence the same ticks (symbol, price, quantity, in
+// order) and the sender must hand every one of them to the feed.
+//
+// The stages only overlap with a core each: on a single-CPU host the
+// pipeline pays for its handoffs without the parallelism. Pass CPUs to pin
+// generator, sequencer and sender to them.
+//
+// Usage: publisher_pipeline_bench [ticks] [generator_cpu sequencer_cpu
+//                                  sender_cpu]
+
+#include "bench_utils.hpp"
+#include "market_generator.hpp"
+#include "matching_engine.hpp"
+#include "protocol.hpp"
+#include "publisher_pipeline.hpp"
+#include "ring_buffer.hpp"
+#include "thread_affinity.hpp"
+#include "transport.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+constexpr uint64_t SEED = 2024;
+constexpr int BENCH_PORT = 30101;
+constexpr size_t TICKS_PER_MS = 10;
+using Ring = core::RingBuffer<protocol::TickPacket, 50000>;
+
+// What ExchangeEvents does with an execution, minus order entry
+struct BenchEvents {
+  networking::FeedSender &feed;
+  Ring &ring;
+  exchange::SenderStage<> *sender = nullptr;
+  uint64_t seq = 1;
+  uint64_t last_ns = 0;
+  std::vector<protocol::TickPacket> ticks;
+  std::vector<uint64_t> gaps_ns;
+
+  BenchEvents(networking::FeedSender &f, Ring &r, uint64_t ticks)
+      : feed(f), ring(r) {
+    this->ticks.reserve(ticks);
+    gaps_ns.reserve(ticks);
+  }
+
+  void on_execution(const exchange::Execution &exec) {
+    protocol::TickPacket tick{};
+    std::memcpy(tick.symbol, exec.symbol, sizeof(tick.symbol));
+    tick.price = protocol::to_price(exec.price);
+    tick.quantity = exec.quantity;
+    tick.sequence_num = seq;
+    tick.timestamp = bench::now_ns();
+    ring.push(seq, tick);
+    if (sender != nullptr)
+      sender->push(tick);
+    else
+      feed.send(tick);
+    if (last_ns != 0)
+      gaps_ns.push_back(tick.timestamp - last_ns);
+    last_ns = tick.timestamp;
+    ticks.push_back(tick);
+    seq++;
+  }
+  void on_book_update(const protocol::BookUpdate &update) {
+    bench::do_not_optimize(update);
+  }
+};
+
+using Engine = exchange::MatchingEngine<BenchEvents>;
+
+// The Publisher's MarketMaker: requote around the move, then cross it
+struct Trader {
+  static constexpr uint32_t QUOTE_OWNER = 0xFFFFFF, TAKER_OWNER = 0xFFFFFE;
+  Engine &engine;
+  BenchEvents &events;
+  std::vector<uint64_t> bid, ask;
+  uint64_t next_id = 1;
+
+  Trader(Engine &e, BenchEvents &ev, size_t symbols)
+      : engine(e), events(ev), bid(symbols), ask(symbols) {}
+
+  void trade(const exchange::GeneratedTick &move, const char (&symbol)[4]) {
+    int64_t fair = protocol::to_ticks(move.price);
+    engine.cancel(QUOTE_OWNER, bid[move.symbol]);
+    engine.cancel(QUOTE_OWNER, ask[move.symbol]);
+    bid[move.symbol] = next_id++;
+    ask[move.symbol] = next_id++;
+    engine.add(QUOTE_OWNER, bid[move.symbol], symbol, protocol::Side::Buy,
+               fair - 1, 1000);
+    engine.add(QUOTE_OWNER, ask[move.symbol], symbol, protocol::Side::Sell,
+               fair + 1, 1000);
+    int64_t limit = move.side == protocol::Side::Buy ? fair + 1 : fair - 1;
+    engine.add(TAKER_OWNER, next_id++, symbol, move.side, limit,
+               100 + static_cast<uint32_t>(events.seq % 50), true);
+  }
+};
+
+static void send_rates(networking::FeedSender &feed, uint64_t ticks) {
+  std::vector<protocol::TickPacket> batch(networking::FeedSender::SEND_BATCH);
+  for (size_t i = 0; i < batch.size(); i++)
+    batch[i].sequence_num = i + 1;
+
+  uint64_t start = bench::now_ns();
+  for (uint64_t i = 0; i < ticks; i++)
+    feed.send(batch[i % batch.size()]);
+  bench::print_rate("send, sendto per tick", ticks, bench::now_ns() - start);
+
+  uint64_t sent = 0;
+  start = bench::now_ns();
+  while (sent < ticks)
+    sent += feed.send_batch(batch);
+  bench::print_rate("send_batch", sent, bench::now_ns() - start);
+}
+
+static void inline_run(uint64_t ticks, BenchEvents &events) {
+  auto engine = std::make_unique<Engine>(events, 1 << 20);
+  exchange::MarketGenerator<> generator(SEED);
+  Trader trader(*engine, events, generator.symbols());
+  std::vector<exchange::GeneratedTick> moves(TICKS_PER_MS);
+  uint64_t start = bench::now_ns();
+  for (uint64_t done = 0; done < ticks; done += moves.size()) {
+    size_t n =
+        static_cast<size_t>(std::min<uint64_t>(moves.size(), ticks - done));
+    generator.generate(std::span(moves.data(), n));
+    for (size_t i = 0; i < n; i++)
+      trader.trade(moves[i], generator.name(moves[i].symbol));
+  }
+  bench::print_rate("inline (one thread)", ticks, bench::now_ns() - start);
+}
+
+static bool pipelined_run(uint64_t ticks, BenchEvents &events,
+                          networking::FeedSender &feed, const int (&cpu)[3]) {
+  auto engine = std::make_unique<Engine>(events, 1 << 20);
+  exchange::SenderStage<> sender(feed, cpu[2]);
+  events.sender = &sender;
+  bool sequencer_pinned = core::pin_this_thread(cpu[1]);
+  uint64_t start = bench::now_ns();
+  // Unpaced: far more moves a millisecond than the sequencer can take, so
+  // the generator only waits on a full queue
+  exchange::GeneratorStage<> generator(SEED, 1 << 20, cpu[0]);
+  Trader trader(*engine, events, generator.symbols());
+  uint64_t traded = 0;
+  size_t deepest_moves = 0, deepest_ticks = 0;
+  while (traded < ticks) {
+    deepest_moves = std::max(deepest_moves, generator.depth());
+    size_t drained = generator.drain([&](const exchange::GeneratedTick &m) {
+      if (traded < ticks) {
+        trader.trade(m, generator.name(m.symbol));
+        traded++;
+      }
+    });
+    deepest_ticks = std::max(deepest_ticks, sender.depth());
+    sender.notify();
+    if (drained == 0)
+      std::this_thread::yield();
+  }
+  uint64_t sequenced_ns = bench::now_ns() - start;
+  sender.finish();
+  uint64_t elapsed = bench::now_ns() - start;
+  events.sender = nullptr;
+
+  bench::print_rate("pipelined (three threads)", ticks, elapsed);
+  std::printf("  %-30s %llu (deepest queue %zu)\n", "generated",
+              static_cast<unsigned long long>(generator.generated.total()),
+              deepest_moves);
+  bench::print_rate("  sequenced", ticks, sequenced_ns);
+  std::printf("  %-30s %llu in %llu batches (deepest queue %zu), "
+              "%llu stalls\n",
+              "sent", static_cast<unsigned long long>(sender.sent.total()),
+              static_cast<unsigned long long>(sender.batches.total()),
+              deepest_ticks, static_cast<unsigned long long>(sender.stalls()));
+  std::printf("  %-30s generator %s, sequencer %s, sender %s\n", "pinned",
+              generator.pinned() ? "yes" : "no",
+              sequencer_pinned ? "yes" : "no", sender.pinned() ? "yes" : "no");
+  return sender.sent.total() == ticks;
+}
+
+int main(int argc, char **argv) {
+  const uint64_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  int cpu[3] = {-1, -1, -1};
+  for (int i = 0; i < 3 && i + 2 < argc; i++)
+    cpu[i] = std::atoi(argv[i + 2]);
+  std::printf("%llu ticks over UDP multicast, %u CPUs\n",
+              static_cast<unsigned long long>(ticks),
+              std::thread::hardware_concurrency());
+
+  networking::FeedSender feed(networking::Transport::Udp, "224.0.0.1",
+                              BENCH_PORT);
+  send_rates(feed, ticks);
+
+  auto ring = std::make_unique<Ring>();
+  BenchEvents one(feed, *ring, ticks);
+  inline_run(ticks, one);
+
+  BenchEvents three(feed, *ring, ticks);
+  bool all_sent = pipelined_run(ticks, three, feed, cpu);
+
+  bench::print_latency("inline tick gap", one.gaps_ns);
+  bench::print_latency("pipelined tick gap", three.gaps_ns);
+
+  bool same = one.ticks.size() == three.ticks.size();
+  for (size_t i = 0; same && i < one.ticks.size(); i++) {
+    const protocol::TickPacket &a = one.ticks[i], &b = three.ticks[i];
+    same = a.price == b.price && a.quantity == b.quantity &&
+           a.sequence_num == b.sequence_num &&
+           std::memcmp(a.symbol, b.symbol, sizeof(a.symbol)) == 0;
+  }
+  std::printf("%-32s %s (%zu ticks)\n", "inline vs pipelined check",
+              same ? "match" : "MISMATCH", three.ticks.size());
+  std::printf("%-32s %s\n", "every tick sent check",
+              all_sent ? "match" : "MISMATCH");
+  return same && all_sent ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+// Pre-trade risk gate cost under sustained order bursts: bursts of 256
+// orders 50 ns apart every 2 ms, each order a lot of 100 on a random
+// symbol at a price near its reference, with 0.5% fat-fingered by 30%.
+// For 50, 5000 and 100000 symbols (gate state from L1-resident to well
+// past L2) it reports:
+//   throughput  checks/sec and ns/check with no per-check timing
+//   latency     per-check percentiles, including ~20-30 ns of clock
+//               overhead (shown separately)
+//   outcome     accepted orders and rejections by reason
+// Every decision is compared with a straightforward branchy gate over an
+// unordered_map, and the gate's positions must survive a checkpoint round
+// trip into a fresh gate; the run fails on any difference.
+//
+// Usage: risk_gate_bench [orders per run]
+
+#include "bench_utils.hpp"
+#include "protocol.hpp"
+#include "risk_gate.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t BURST = 256;
+constexpr int64_t BURST_SPACING_NS = 50;
+constexpr int64_t BURST_GAP_NS = 2000000;
+constexpr uint32_t LOT = 100;
+
+struct Name {
+  char s[4];
+};
+
+struct Order {
+  uint32_t symbol;
+  protocol::Side side;
+  double price;
+  double reference;
+  int64_t now_ns;
+};
+
+static strategy::RiskLimits bench_limits() {
+  strategy::RiskLimits limits;
+  limits.max_position = 1000;
+  limits.max_notional = 1000000;
+  limits.rate = {100, 20};
+  limits.price_band = 0.05;
+  return limits;
+}
+
+constexpr strategy::RateLimit BENCH_TOTAL = {1000000, 1000};
+
+// Four non-zero bytes per symbol, so up to 26^4 distinct keys
+static std::vector<Name> make_names(size_t symbols) {
+  std::vector<Name> names(symbols);
+  for (size_t i = 0; i < symbols; i++) {
+    size_t n = i;
+    for (char &c : names[i].s) {
+      c = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+  }
+  return names;
+}
+
+static std::vector<Order> make_orders(size_t count, size_t symbols) {
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<uint32_t> pick(
+      0, static_cast<uint32_t>(symbols - 1));
+  std::uniform_real_distribution<double> level(20.0, 2000.0);
+  std::normal_distribution<double> noise(0.0, 0.01);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<double> reference(symbols);
+  for (double &r : reference)
+    r = level(rng);
+
+  std::vector<Order> orders(count);
+  int64_t now = 1000000000;
+  for (size_t i = 0; i < count; i++) {
+    now += i % BURST == 0 ? BURST_GAP_NS : BURST_SPACING_NS;
+    Order &o = orders[i];
+    o.symbol = pick(rng);
+    // Buy-heavy, so positions build up to the limits
+    o.side = unit(rng) < 0.6 ? protocol::Side::Buy : protocol::Side::Sell;
+    o.reference = reference[o.symbol];
+    o.price = o.reference * (1.0 + noise(rng));
+    if (unit(rng) < 0.005)
+      o.price *= 1.3;
+    o.now_ns = now;
+  }
+  return orders;
+}
+
+// The same rules written the obvious way: one branch per check
+class BranchyGate {
+public:
+  BranchyGate(const strategy::RiskLimits &limits, strategy::RateLimit total)
+      : limits_(limits), total_{total.burst, 0} {}
+
+  unsigned check(uint32_t key, protocol::Side side, double price,
+                 uint32_t quantity, double reference, int64_t now_ns) {
+    auto [it, inserted] = symbols_.try_emplace(key);
+    State &s = it->second;
+    if (inserted)
+      s.bucket.tokens = limits_.rate.burst;
+    int64_t next = s.position + (side == protocol::Side::Buy
+                                     ? int64_t{quantity}
+                                     : -int64_t{quantity});
+    unsigned reject = 0;
+    if (std::abs(next) > std::abs(s.position)) {
+      if (std::abs(next) > limits_.max_position)
+        reject |= strategy::RISK_POSITION;
+      if (static_cast<double>(std::abs(next)) * price > limits_.max_notional)
+        reject |= strategy::RISK_NOTIONAL;
+    }
+    double tokens = refill(s.bucket, limits_.rate, now_ns);
+    double total_tokens = refill(total_, total_limit_, now_ns);
+    if (tokens < 1.0 || total_tokens < 1.0)
+      reject |= strategy::RISK_RATE;
+    if (!(std::abs(price - reference) <= limits_.price_band * reference))
+      reject |= strategy::RISK_PRICE_BAND;
+    if (reject == 0) {
+      tokens -= 1.0;
+      total_tokens -= 1.0;
+      s.position = next;
+    }
+    s.bucket.tokens = tokens;
+    total_.tokens = total_tokens;
+    s.bucket.last_ns = std::max(s.bucket.last_ns, now_ns);
+    total_.last_ns = std::max(total_.last_ns, now_ns);
+    return reject;
+  }
+
+private:
+  struct Bucket {
+    double tokens = 0;
+    int64_t last_ns = 0;
+  };
+  struct State {
+    int64_t position = 0;
+    Bucket bucket;
+  };
+
+  static double refill(const Bucket &b, strategy::RateLimit limit,
+                       int64_t now_ns) {
+    double elapsed =
+        static_cast<double>(std::max<int64_t>(now_ns - b.last_ns, 0));
+    return std::min(limit.burst, b.tokens + elapsed * (limit.per_sec * 1e-9));
+  }
+
+  strategy::RiskLimits limits_;
+  Bucket total_;
+  strategy::RateLimit total_limit_ = BENCH_TOTAL;
+  std::unordered_map<uint32_t, State> symbols_;
+};
+
+static void run(size_t count, size_t symbols, bool &ok) {
+  std::vector<Name> names = make_names(symbols);
+  std::vector<Order> orders = make_orders(count, symbols);
+  std::printf("--- %zu symbols ---\n", symbols);
+
+  auto check = [&](strategy::RiskGate &gate, const Order &o) {
+    return gate.check(names[o.symbol].s, o.side, o.price, LOT, o.reference,
+                      o.now_ns);
+  };
+
+  // Throughput: untimed checks, best of 3 fresh gates
+  uint64_t best = UINT64_MAX;
+  for (int r = 0; r < 3; r++) {
+    strategy::RiskGate gate(bench_limits(), BENCH_TOTAL);
+    uint64_t start = bench::now_ns();
+    for (const Order &o : orders)
+      bench::do_not_optimize(check(gate, o));
+    best = std::min(best, bench::now_ns() - start);
+  }
+  bench::print_rate("checks", count, best);
+
+  // Latency per check, and the decisions for the reference comparison
+  strategy::RiskGate gate(bench_limits(), BENCH_TOTAL);
+  std::vector<uint64_t> samples;
+  std::vector<uint8_t> decisions;
+  samples.reserve(count);
+  decisions.reserve(count);
+  for (const Order &o : orders) {
+    uint64_t start = bench::now_ns();
+    strategy::RiskReject reject = check(gate, o);
+    samples.push_back(bench::now_ns() - start);
+    decisions.push_back(reject);
+  }
+  bench::print_latency("check", samples);
+  std::printf("%-32s %llu accepted | position %llu, notional %llu, "
+              "rate %llu, band %llu\n",
+              "outcome", static_cast<unsigned long long>(gate.accepted()),
+              static_cast<unsigned long long>(
+                  gate.rejected(strategy::RISK_POSITION)),
+              static_cast<unsigned long long>(
+                  gate.rejected(strategy::RISK_NOTIONAL)),
+              static_cast<unsigned long long>(
+                  gate.rejected(strategy::RISK_RATE)),
+              static_cast<unsigned long long>(
+                  gate.rejected(strategy::RISK_PRICE_BAND)));
+
+  BranchyGate ref(bench_limits(), BENCH_TOTAL);
+  uint64_t start = bench::now_ns();
+  size_t differ = 0;
+  for (size_t i = 0; i < count; i++) {
+    const Order &o = orders[i];
+    unsigned expected = ref.check(core::symbol_key(names[o.symbol].s), o.side,
+                                  o.price, LOT, o.reference, o.now_ns);
+    differ += expected != decisions[i];
+  }
+  bench::print_rate("branchy unordered_map checks", count,
+                    bench::now_ns() - start);
+  std::printf("%-32s %s\n", "branchy reference check",
+              differ == 0 ? "match" : "MISMATCH");
+  ok = ok && differ == 0;
+
+  // Positions through a checkpoint, as the subscriber saves and restores
+  std::vector<std::byte> saved(8 + symbols * 12);
+  core::CheckpointWriter out(saved);
+  gate.save_checkpoint(out);
+  core::CheckpointReader in(std::span<const std::byte>(saved.data(),
+                                                       out.size()));
+  strategy::RiskGate restored(bench_limits(), BENCH_TOTAL);
+  bool same = !out.overflow() && restored.restore_checkpoint(in);
+  for (size_t i = 0; same && i < symbols; i++)
+    same = restored.position(names[i].s) == gate.position(names[i].s);
+  std::printf("%-32s %s\n", "checkpoint positions check",
+              same ? "match" : "MISMATCH");
+  ok = ok && same;
+}
+
+int main(int argc, char **argv) {
+  const size_t count =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+  std::vector<uint64_t> clock;
+  for (int i = 0; i < 100000; i++) {
+    uint64_t start = bench::now_ns();
+    clock.push_back(bench::now_ns() - start);
+  }
+  bench::print_latency("clock overhead", clock);
+
+  bool ok = true;
+  for (size_t symbols : {50, 5000, 100000})
+    run(count, symbols, ok);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+// Rolling window statistics: the previous running sum / sum-of-squares
+// (variance = E[x^2] - E[x]^2, clamped at 0, rescanned every 1000 ticks)
+// versus the O(1) compensated Welford update in rolling_stats.hpp.
+//  1. Accuracy: standard deviation against a long double two-pass reference
+//     at price levels from $5 to $4000. Exits non-zero if the Welford error
+//     exceeds its bound.
+//  2. Latency: per-update histogram for one symbol, where every 1000th
+//     update of the old scheme pays for the rescan.
+//
+// Usage: rolling_stats_bench [ticks]
+
+#include "bench_utils.hpp"
+#include "rolling_stats.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr size_t PERIOD = 100;
+
+// The previous scheme, as it ran in the subscriber
+struct SumOfSquares {
+  std::array<double, PERIOD> prices{};
+  size_t count = 0;
+  size_t idx = 0;
+  uint64_t ticks = 0;
+  double sum = 0.0;
+  double sum_sq = 0.0;
+  size_t negative_clamps = 0;
+
+  void update(double price) {
+    if (count < PERIOD) {
+      prices[count++] = price;
+      sum += price;
+      sum_sq += price * price;
+      return;
+    }
+    double old_price = prices[idx];
+    sum -= old_price;
+    sum_sq -= old_price * old_price;
+    prices[idx] = price;
+    sum += price;
+    sum_sq += price * price;
+    idx = (idx + 1) % PERIOD;
+
+    if (++ticks % 1000 == 0) {
+      double true_sum = 0.0, true_sum_sq = 0.0;
+      for (double p : prices) {
+        true_sum += p;
+        true_sum_sq += p * p;
+      }
+      sum = true_sum;
+      sum_sq = true_sum_sq;
+    }
+  }
+
+  double std_dev() {
+    double mean = sum / PERIOD;
+    double variance = sum_sq / PERIOD - mean * mean;
+    if (variance < 0.0) {
+      negative_clamps++;
+      variance = 0.0;
+    }
+    return std::sqrt(variance);
+  }
+};
+
+struct Welford {
+  std::array<double, PERIOD> prices{};
+  uint32_t count = 0;
+  size_t idx = 0;
+  double mean = 0.0;
+  double comp = 0.0;
+  double m2 = 0.0;
+
+  void update(double price) {
+    if (count < PERIOD) {
+      prices[count++] = price;
+      strategy::rolling_add(mean, comp, m2, price, count);
+      return;
+    }
+    double old_price = prices[idx];
+    prices[idx] = price;
+    strategy::rolling_replace(mean, comp, m2, old_price, price, PERIOD);
+    idx = (idx + 1) % PERIOD;
+  }
+
+  double std_dev() const { return std::sqrt(std::max(0.0, m2 / PERIOD)); }
+};
+
+static long double reference_std_dev(const std::array<double, PERIOD> &w) {
+  long double mean = 0.0L;
+  for (double p : w)
+    mean += p;
+  mean /= PERIOD;
+  long double m2 = 0.0L;
+  for (double p : w)
+    m2 += (p - mean) * (p - mean);
+  return std::sqrt(m2 / PERIOD);
+}
+
+// Returns the worst Welford relative error
+static double accuracy(double level, double sigma, size_t ticks) {
+  std::mt19937_64 rng(5);
+  std::normal_distribution<double> noise(0.0, sigma);
+  SumOfSquares old_scheme;
+  Welford welford;
+  double old_err = 0.0, new_err = 0.0;
+
+  for (size_t t = 0; t < ticks; t++) {
+    // Quote on a one-cent grid, like the feed
+    double price = std::round((level + noise(rng)) * 100.0) / 100.0;
+    old_scheme.update(price);
+    welford.update(price);
+
+    // Sample off the rescan boundary, where the old scheme is at its worst
+    if (t >= PERIOD && t % 97 == 0) {
+      long double ref = reference_std_dev(welford.prices);
+      if (ref == 0.0L)
+        continue;
+      old_err = std::max(old_err, static_cast<double>(std::fabs(
+                                      old_scheme.std_dev() - ref) / ref));
+      new_err = std::max(new_err, static_cast<double>(std::fabs(
+                                      welford.std_dev() - ref) / ref));
+    }
+  }
+
+  std::printf("$%-7.0f sigma %-5.2f  sum/sum_sq %10.2e (%zu clamps)  "
+              "Welford %10.2e\n",
+              level, sigma, old_err, old_scheme.negative_clamps, new_err);
+  return new_err;
+}
+
+// Latency histogram in power-of-two nanosecond buckets
+static void print_histogram(const std::string &label,
+                            const std::vector<uint64_t> &samples,
+                            const std::vector<uint64_t> &every_1000th) {
+  std::array<size_t, 12> buckets{};
+  for (uint64_t ns : samples) {
+    size_t b = 0;
+    while (b + 1 < buckets.size() && ns >= (uint64_t{16} << b))
+      b++;
+    buckets[b]++;
+  }
+  std::vector<uint64_t> copy = samples;
+  bench::print_latency(label, copy);
+  for (size_t b = 0; b < buckets.size(); b++) {
+    if (buckets[b] == 0)
+      continue;
+    if (b + 1 == buckets.size())
+      std::printf("  >= %5llu ns  %10zu\n",
+                  static_cast<unsigned long long>(uint64_t{16} << (b - 1)),
+                  buckets[b]);
+    else
+      std::printf("  <  %5llu ns  %10zu\n",
+                  static_cast<unsigned long long>(uint64_t{16} << b),
+                  buckets[b]);
+  }
+  double spike = 0.0;
+  for (uint64_t ns : every_1000th)
+    spike += static_cast<double>(ns);
+  std::printf("  every 1000th update: %.0f ns average\n",
+              spike / static_cast<double>(every_1000th.size()));
+}
+
+template <typename Stats>
+static void latency(const std::string &label, size_t ticks) {
+  std::mt19937_64 rng(9);
+  std::normal_distribution<double> noise(0.0, 0.25);
+  std::vector<double> prices(ticks);
+  for (auto &p : prices)
+    p = 400.0 + noise(rng);
+
+  Stats stats;
+  for (size_t t = 0; t < PERIOD; t++)
+    stats.update(prices[t]);
+
+  std::vector<uint64_t> samples;
+  std::vector<uint64_t> every_1000th;
+  samples.reserve(ticks);
+  for (size_t t = PERIOD; t < ticks; t++) {
+    uint64_t start = bench::now_ns();
+    stats.update(prices[t]);
+    bench::do_not_optimize(stats);
+    uint64_t ns = bench::now_ns() - start;
+    samples.push_back(ns);
+    if ((t - PERIOD + 1) % 1000 == 0)
+      every_1000th.push_back(ns);
+  }
+  print_histogram(label, samples, every_1000th);
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+  std::printf("Worst relative std-dev error vs long double two-pass, SMA%zu, "
+              "%zu ticks\n",
+              PERIOD, ticks);
+  double worst = 0.0;
+  for (double level : {5.0, 150.0, 400.0, 4000.0}) {
+    for (double sigma : {0.01, 0.25}) {
+      worst = std::max(worst, accuracy(level, sigma, ticks));
+    }
+  }
+  // A few ulps of the window's variance; the old scheme is orders of
+  // magnitude above this at $400
+  const double BOUND = 1e-9;
+  std::printf("Welford worst error %.2e (%s bound %.0e)\n\n", worst,
+              worst <= BOUND ? "within" : "EXCEEDS", BOUND);
+
+  latency<SumOfSquares>("sum/sum_sq + rescan", ticks);
+  latency<Welford>("Welford (compensated)", ticks);
+  return worst <= BOUND ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+// Throughput of symbol-sharded strategy execution with 1-16 worker threads.
+// One router thread replays a random-symbol stream into a ShardedExecutor
+// running four mean-reversion strategies per shard; the clock stops once
+// every worker has drained its queue. The inline row runs the same set on
+// the router thread with no queues.
+//
+// Sharding must not change any decision: each run's realised PnL is checked
+// against the inline run (only the order of the final per-shard sum
+// differs). Exits non-zero on a mismatch.
+//
+// Usage: sharded_workers_bench [ticks] [symbols]
+
+#include "bench_utils.hpp"
+#include "mean_reversion.hpp"
+#include "protocol.hpp"
+#include "sharded_strategies.hpp"
+#include "strategy.hpp"
+#include "wait_strategy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t MAX_SYMBOLS = 1 << 14;
+
+using Set = strategy::StrategySet<strategy::MeanReversion<20, MAX_SYMBOLS>,
+                                  strategy::MeanReversion<50, MAX_SYMBOLS>,
+                                  strategy::MeanReversion<100, MAX_SYMBOLS>,
+                                  strategy::MeanReversion<200, MAX_SYMBOLS>>;
+
+// Yields after a short spin, so oversubscribed runs (more workers than
+// cores) still make progress
+using Wait = core::SpinYieldWait;
+
+// Ticks handed to the router per call, like one subscriber drain
+constexpr size_t ROUTE_BATCH = 256;
+
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] += step(rng);
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      stream[seq].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    stream[seq].price = prices[s];
+    stream[seq].sequence_num = seq;
+  }
+  return stream;
+}
+
+static double run_inline(const std::vector<protocol::TickPacket> &stream) {
+  auto set = std::make_unique<Set>();
+  std::span<const protocol::TickPacket> all(stream);
+  uint64_t start = bench::now_ns();
+  for (size_t i = 0; i < all.size(); i += ROUTE_BATCH) {
+    set->on_batch(all.subspan(i, std::min(ROUTE_BATCH, all.size() - i)));
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  bench::print_rate("inline (router thread)", stream.size(), elapsed);
+  return set->session_pnl();
+}
+
+// Returns true if the sharded PnL matches the inline reference
+static bool run_sharded(const std::vector<protocol::TickPacket> &stream,
+                        size_t workers, double reference) {
+  strategy::ShardGroup<Set> group(workers, strategy::StrategyConfig{});
+  std::span<const protocol::TickPacket> all(stream);
+
+  uint64_t start;
+  uint64_t elapsed;
+  {
+    strategy::ShardedExecutor<Set, Wait> executor(group, true, ROUTE_BATCH);
+    start = bench::now_ns();
+    for (size_t i = 0; i < all.size(); i += ROUTE_BATCH) {
+      executor.route(all.subspan(i, std::min(ROUTE_BATCH, all.size() - i)));
+    }
+    executor.stop();
+    elapsed = bench::now_ns() - start;
+  }
+
+  // Lock-free aggregate of what the workers published
+  double pnl = group.session_pnl();
+  bool match = group.processed() == stream.size() &&
+               std::fabs(pnl - reference) <=
+                   1e-9 * std::max(1.0, std::fabs(reference));
+
+  bench::print_rate(std::to_string(workers) + " workers", stream.size(),
+                    elapsed);
+  std::printf("%-32s PnL $%.2f (%s)\n", "", pnl,
+              match ? "matches inline" : "MISMATCH");
+  return match;
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+  const size_t symbols =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000;
+
+  std::printf("%zu ticks over %zu symbols, %zu strategies per shard, "
+              "%u hardware threads\n",
+              ticks, symbols, Set::size(),
+              std::thread::hardware_concurrency());
+  auto stream = make_stream(ticks, symbols);
+
+  double reference = run_inline(stream);
+  bool ok = true;
+  for (size_t workers : {1, 2, 4, 8, 16}) {
+    ok &= run_sharded(stream, workers, reference);
+  }
+  return ok ? 0 : 1;
+}
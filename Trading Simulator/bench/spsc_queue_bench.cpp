@@ -0,0 +1,175 @@
+// Throughput and cross-core latency of SPSCQueue v2 against the original
+// TickPacket-only queue (reproduced below as LegacySPSCQueue).
+//
+// Usage: spsc_queue_bench [items]
+
+#include "bench_utils.hpp"
+#include "protocol.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// The pre-v2 queue: modulo indexing, shared index read on every call
+template <size_t Capacity> class LegacySPSCQueue {
+private:
+  std::vector<protocol::TickPacket> buffer;
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+
+public:
+  LegacySPSCQueue() : buffer(Capacity) {}
+
+  protocol::TickPacket *claim_write() {
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    size_t next_tail = (current_tail + 1) % Capacity;
+    if (next_tail == head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &buffer[current_tail];
+  }
+
+  void commit_write() {
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    tail.store((current_tail + 1) % Capacity, std::memory_order_release);
+  }
+
+  const protocol::TickPacket *front() {
+    size_t current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &buffer[current_head];
+  }
+
+  void pop() {
+    size_t current_head = head.load(std::memory_order_relaxed);
+    head.store((current_head + 1) % Capacity, std::memory_order_release);
+  }
+};
+
+using Legacy = LegacySPSCQueue<10000>;
+using V2 = SPSCQueue<protocol::TickPacket, 16384>;
+
+// One item at a time through claim_write/commit_write and front/pop
+template <typename Queue>
+void throughput_single(const char *label, uint64_t n) {
+  auto queue = std::make_unique<Queue>();
+  uint64_t checksum = 0;
+
+  std::thread consumer([&] {
+    bench::pin_thread(1);
+    for (uint64_t i = 0; i < n; i++) {
+      const protocol::TickPacket *tick;
+      while (!(tick = queue->front())) {
+      }
+      checksum += tick->sequence_num;
+      queue->pop();
+    }
+  });
+
+  bench::pin_thread(0);
+  uint64_t start = bench::now_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    protocol::TickPacket *slot;
+    while (!(slot = queue->claim_write())) {
+    }
+    slot->sequence_num = i;
+    queue->commit_write();
+  }
+  consumer.join();
+  bench::print_rate(label, n, bench::now_ns() - start);
+  bench::do_not_optimize(checksum);
+}
+
+// Batches of up to `batch` items through the *_n APIs on both sides
+void throughput_batch(const char *label, uint64_t n, size_t batch) {
+  auto queue = std::make_unique<V2>();
+  uint64_t checksum = 0;
+
+  std::thread consumer([&] {
+    bench::pin_thread(1);
+    uint64_t received = 0;
+    while (received < n) {
+      auto ticks = queue->front_n(batch);
+      for (const auto &tick : ticks) {
+        checksum += tick.sequence_num;
+      }
+      queue->pop_n(ticks.size());
+      received += ticks.size();
+    }
+  });
+
+  bench::pin_thread(0);
+  uint64_t start = bench::now_ns();
+  uint64_t sent = 0;
+  while (sent < n) {
+    auto slots = queue->claim_write_n(std::min<uint64_t>(batch, n - sent));
+    for (auto &slot : slots) {
+      slot.sequence_num = sent++;
+    }
+    queue->commit_write_n(slots.size());
+  }
+  consumer.join();
+  bench::print_rate(label, n, bench::now_ns() - start);
+  bench::do_not_optimize(checksum);
+}
+
+// Ping-pong between two queues; one-way latency is half the round trip
+template <typename Queue> void latency(const char *label, uint64_t rounds) {
+  auto ping = std::make_unique<Queue>();
+  auto pong = std::make_unique<Queue>();
+
+  std::thread echo([&] {
+    bench::pin_thread(1);
+    for (uint64_t i = 0; i < rounds; i++) {
+      const protocol::TickPacket *tick;
+      while (!(tick = ping->front())) {
+      }
+      protocol::TickPacket copy = *tick;
+      ping->pop();
+      protocol::TickPacket *slot;
+      while (!(slot = pong->claim_write())) {
+      }
+      *slot = copy;
+      pong->commit_write();
+    }
+  });
+
+  bench::pin_thread(0);
+  std::vector<uint64_t> samples;
+  samples.reserve(rounds);
+  for (uint64_t i = 0; i < rounds; i++) {
+    uint64_t start = bench::now_ns();
+    protocol::TickPacket *slot;
+    while (!(slot = ping->claim_write())) {
+    }
+    slot->sequence_num = i;
+    ping->commit_write();
+    while (!pong->front()) {
+    }
+    pong->pop();
+    samples.push_back((bench::now_ns() - start) / 2);
+  }
+  echo.join();
+  bench::print_latency(label, samples);
+}
+
+int main(int argc, char **argv) {
+  const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000000;
+
+  std::printf("Throughput (%llu TickPackets)\n",
+              static_cast<unsigned long long>(n));
+  throughput_single<Legacy>("legacy SPSCQueue<10000>", n);
+  throughput_single<V2>("v2 SPSCQueue<T, 16384>", n);
+  throughput_batch("v2 batch x32", n, 32);
+  throughput_batch("v2 batch x256", n, 256);
+
+  std::printf("\nCross-core one-way latency (ping-pong / 2)\n");
+  const uint64_t rounds = std::min<uint64_t>(n / 50, 1000000);
+  latency<Legacy>("legacy SPSCQueue<10000>", rounds);
+  latency<V2>("v2 SPSCQueue<T, 16384>", rounds);
+  return 0;
+}
@@ -0,0 +1,164 @@
+// Per-symbol strategy state layout under a uniformly random symbol stream:
+// the array-of-structs layout (one SymbolState per symbol, window inline, all
+// fields interleaved) versus the structure-of-arrays StateStore behind
+// MeanReversion (hot columns, window arena, cold reports). Reports ns/tick
+// and L1d / last-level cache misses per tick at 1k, 16k and 100k symbols.
+//
+// Usage: strategy_layout_bench [ticks]
+
+#include "bench_utils.hpp"
+#include "mean_reversion.hpp"
+#include "perf_counters.hpp"
+#include "protocol.hpp"
+#include "rolling_stats.hpp"
+#include "symbol_table.hpp"
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr size_t PERIOD = 100;
+constexpr size_t MAX_SYMBOLS = size_t{1} << 17;
+
+// Reference: the array-of-structs layout, same arithmetic and decisions
+struct AosState {
+  std::array<double, PERIOD> prices{};
+  uint32_t count = 0;
+  uint32_t idx = 0;
+  double mean = 0.0;
+  double mean_comp = 0.0;
+  double m2 = 0.0;
+  int position = 0;
+  double entry_price = 0.0;
+  double pnl = 0.0;
+  int trades = 0;
+  int ticks_held = 0;
+};
+
+class AosMeanReversion {
+public:
+  void on_tick(const protocol::TickPacket &tick) {
+    AosState &s = states_.find_or_insert(core::symbol_key(tick.symbol));
+    if (s.count < PERIOD) {
+      s.prices[s.count++] = tick.price;
+      strategy::rolling_add(s.mean, s.mean_comp, s.m2, tick.price, s.count);
+      if (s.count != PERIOD)
+        return;
+    } else {
+      double old_price = s.prices[s.idx];
+      s.prices[s.idx] = tick.price;
+      strategy::rolling_replace(s.mean, s.mean_comp, s.m2, old_price,
+                                tick.price, PERIOD);
+      s.idx = strategy::next_index<PERIOD>(s.idx);
+    }
+
+    double sma, std_dev;
+    strategy::bollinger_bands(s.mean, s.m2, PERIOD, sma, std_dev);
+
+    if (s.position == 0 && tick.price <= sma - 2.0 * std_dev) {
+      s.position = 1;
+      s.entry_price = tick.price;
+      s.ticks_held = 0;
+    } else if (s.position == 1) {
+      s.ticks_held++;
+      if (tick.price >= sma ||
+          (tick.price <= s.entry_price - 3.0 * std_dev && s.ticks_held > 2) ||
+          s.ticks_held > 50) {
+        double pnl = (tick.price - s.entry_price) * 100.0;
+        s.pnl += pnl;
+        session_pnl_ += pnl;
+        s.position = 0;
+        s.trades++;
+      }
+    }
+  }
+
+  double session_pnl() const { return session_pnl_; }
+
+private:
+  core::SymbolTable<AosState, MAX_SYMBOLS> states_;
+  double session_pnl_ = 0.0;
+};
+
+static void set_symbol(protocol::TickPacket &tick, size_t s) {
+  for (int c = 3; c >= 0; c--) {
+    tick.symbol[c] = static_cast<char>('A' + s % 26);
+    s /= 26;
+  }
+}
+
+// Random walk per symbol with symbols picked uniformly at random
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] += step(rng);
+    set_symbol(stream[seq], s);
+    stream[seq].price = prices[s];
+    stream[seq].sequence_num = seq;
+  }
+  return stream;
+}
+
+template <typename Strategy>
+void measure(const char *label, const std::vector<protocol::TickPacket> &stream,
+             size_t symbols) {
+  // Fill every window first, so both layouts are measured in steady state
+  auto strat = std::make_unique<Strategy>();
+  protocol::TickPacket tick{};
+  tick.price = 150.0;
+  for (size_t round = 0; round < PERIOD; round++) {
+    for (size_t s = 0; s < symbols; s++) {
+      set_symbol(tick, s);
+      strat->on_tick(tick);
+    }
+  }
+
+  bench::PerfCounter l1d(bench::PerfEvent::L1dLoadMisses);
+  bench::PerfCounter llc(bench::PerfEvent::LlcMisses);
+  size_t ticks = stream.size();
+
+  l1d.start();
+  llc.start();
+  uint64_t start = bench::now_ns();
+  for (const auto &t : stream) {
+    strat->on_tick(t);
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  uint64_t llc_misses = llc.stop();
+  uint64_t l1d_misses = l1d.stop();
+
+  bench::print_rate(label, ticks, elapsed);
+  if (l1d.available() && llc.available()) {
+    std::printf("%-32s %.2f L1d misses, %.2f LLC misses per tick\n", "",
+                static_cast<double>(l1d_misses) / ticks,
+                static_cast<double>(llc_misses) / ticks);
+  } else {
+    std::printf("%-32s cache counters unavailable (perf_event_open)\n", "");
+  }
+  bench::do_not_optimize(strat->session_pnl());
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+
+  for (size_t symbols : {1000, 16000, 100000}) {
+    auto stream = make_stream(ticks, symbols);
+    std::printf("\n%zu symbols, %zu random ticks, SMA%zu\n", symbols, ticks,
+                PERIOD);
+    measure<AosMeanReversion>("array of structs", stream, symbols);
+    measure<strategy::MeanReversion<PERIOD, MAX_SYMBOLS>>(
+        "structure of arrays (StateStore)", stream, symbols);
+  }
+
+  return 0;
+}
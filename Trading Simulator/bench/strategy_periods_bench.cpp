@@ -0,0 +1,96 @@
+// Mean-reversion strategies with 20, 50, 100 and 200 tick windows running side
+// by side in one process on the same random-symbol tick stream. Reports ns per
+// tick for each period and counts heap allocations during the measured run,
+// which must be zero once every symbol has been seen.
+//
+// Usage: strategy_periods_bench [ticks] [symbols]
+
+#include "bench_utils.hpp"
+#include "mean_reversion.hpp"
+#include "protocol.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::atomic<uint64_t> heap_allocations{0};
+
+void *operator new(size_t bytes) {
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(bytes ? bytes : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// Random walk per symbol, so the bands are crossed and trades happen. The
+// first ticks visit every symbol once, then symbols are picked at random.
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = seq < symbols ? seq : pick(rng);
+    prices[s] += step(rng);
+    protocol::TickPacket &tick = stream[seq];
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      tick.symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    tick.price = prices[s];
+    tick.sequence_num = seq;
+  }
+  return stream;
+}
+
+template <size_t Period>
+void run(const std::vector<protocol::TickPacket> &warmup,
+         const std::vector<protocol::TickPacket> &stream) {
+  using Strategy = strategy::MeanReversion<Period, 1 << 14>;
+  auto strat = std::make_unique<Strategy>();
+  for (const auto &tick : warmup) {
+    strat->on_tick(tick);
+  }
+
+  uint64_t allocs_before = heap_allocations.load();
+  uint64_t start = bench::now_ns();
+  for (const auto &tick : stream) {
+    strat->on_tick(tick);
+  }
+  uint64_t elapsed = bench::now_ns() - start;
+  uint64_t allocs = heap_allocations.load() - allocs_before;
+
+  bench::print_rate("MeanReversion<" + std::to_string(Period) + ">",
+                    stream.size(), elapsed);
+  std::printf("  state %5zu bytes/symbol, %llu heap allocations, "
+              "session PnL $%.2f\n",
+              Strategy::Store::BYTES_PER_SYMBOL,
+              static_cast<unsigned long long>(allocs), strat->session_pnl());
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+  const size_t symbols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+
+  // Warm up so every table entry already exists
+  auto warmup = make_stream(symbols, symbols);
+  auto stream = make_stream(ticks, symbols);
+
+  std::printf("%zu ticks over %zu symbols\n", ticks, symbols);
+
+  run<20>(warmup, stream);
+  run<50>(warmup, stream);
+  run<100>(warmup, stream);
+  run<200>(warmup, stream);
+  return 0;
+}
@@ -0,0 +1,128 @@
+// Per-tick cost of a compile-time StrategySet with 1, 4 and 16 mean-reversion
+// strategies (distinct windows), against the same strategies behind a
+// virtual interface. Every strategy sees every tick of a random-symbol
+// stream.
+//
+// Usage: strategy_set_bench [ticks] [symbols]
+
+#include "bench_utils.hpp"
+#include "mean_reversion.hpp"
+#include "protocol.hpp"
+#include "strategy.hpp"
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr size_t MAX_SYMBOLS = 1 << 12;
+
+template <size_t... Periods>
+using Set = strategy::StrategySet<
+    strategy::MeanReversion<Periods, MAX_SYMBOLS>...>;
+
+using One = Set<100>;
+using Four = Set<20, 50, 100, 200>;
+using Sixteen = Set<10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130,
+                    140, 150, 160>;
+
+// Baseline: the same strategies held through a base class pointer
+struct VirtualStrategy {
+  virtual ~VirtualStrategy() = default;
+  virtual void on_tick(const protocol::TickPacket &tick) = 0;
+  virtual double session_pnl() const = 0;
+};
+
+template <typename S> struct VirtualAdapter final : VirtualStrategy {
+  S strategy{strategy::StrategyConfig{}};
+  void on_tick(const protocol::TickPacket &tick) override {
+    strategy.on_tick(tick);
+  }
+  double session_pnl() const override { return strategy.session_pnl(); }
+};
+
+using VirtualList = std::vector<std::unique_ptr<VirtualStrategy>>;
+
+template <size_t... Periods> VirtualList make_virtual(const Set<Periods...> *) {
+  VirtualList list;
+  (list.push_back(std::make_unique<VirtualAdapter<
+                      strategy::MeanReversion<Periods, MAX_SYMBOLS>>>()),
+   ...);
+  return list;
+}
+
+static std::vector<protocol::TickPacket> make_stream(size_t ticks,
+                                                     size_t symbols) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+  std::normal_distribution<double> step(0.0, 0.05);
+  std::vector<double> prices(symbols, 150.0);
+  std::vector<protocol::TickPacket> stream(ticks);
+  for (size_t seq = 0; seq < ticks; seq++) {
+    size_t s = pick(rng);
+    prices[s] += step(rng);
+    size_t n = s;
+    for (int c = 3; c >= 0; c--) {
+      stream[seq].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+    stream[seq].price = prices[s];
+    stream[seq].sequence_num = seq;
+  }
+  return stream;
+}
+
+template <typename S>
+void run(const std::vector<protocol::TickPacket> &stream) {
+  std::string count = std::to_string(S::size());
+
+  // Fused handler: one call per tick
+  {
+    auto set = std::make_unique<S>();
+    uint64_t start = bench::now_ns();
+    for (const auto &tick : stream) {
+      set->on_tick(tick);
+    }
+    uint64_t elapsed = bench::now_ns() - start;
+    bench::print_rate("StrategySet x" + count, stream.size(), elapsed);
+    std::printf("%-32s %.2f ns per strategy per tick, PnL $%.2f\n", "",
+                static_cast<double>(elapsed) /
+                    static_cast<double>(stream.size() * S::size()),
+                set->session_pnl());
+  }
+
+  // Virtual dispatch over the same strategies
+  {
+    auto list = make_virtual(static_cast<const S *>(nullptr));
+    uint64_t start = bench::now_ns();
+    for (const auto &tick : stream) {
+      for (auto &strat : list) {
+        strat->on_tick(tick);
+      }
+    }
+    uint64_t elapsed = bench::now_ns() - start;
+    double pnl = 0.0;
+    for (auto &strat : list) {
+      pnl += strat->session_pnl();
+    }
+    bench::print_rate("virtual x" + count, stream.size(), elapsed);
+    std::printf("%-32s %.2f ns per strategy per tick, PnL $%.2f\n", "",
+                static_cast<double>(elapsed) /
+                    static_cast<double>(stream.size() * S::size()),
+                pnl);
+  }
+}
+
+int main(int argc, char **argv) {
+  const size_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+  const size_t symbols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+
+  std::printf("%zu ticks over %zu symbols\n", ticks, symbols);
+  auto stream = make_stream(ticks, symbols);
+
+  run<One>(stream);
+  run<Four>(stream);
+  run<Sixteen>(stream);
+  return 0;
+}
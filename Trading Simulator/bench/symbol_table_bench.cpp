@@ -0,0 +1,76 @@
+// Per-tick symbol lookup cost: the original std::string +
+// std::unordered_map path versus the flat SymbolTable, at 50, 5k and 100k
+// symbols under a uniformly random symbol stream.
+//
+// Usage: symbol_table_bench [lookups]
+
+#include "bench_utils.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Counter {
+  uint64_t ticks = 0;
+};
+
+// Distinct 4-letter symbols: AAAA, AAAB, ...
+static std::vector<protocol::TickPacket> make_universe(size_t symbols) {
+  std::vector<protocol::TickPacket> universe(symbols);
+  for (size_t i = 0; i < symbols; i++) {
+    size_t n = i;
+    for (int c = 3; c >= 0; c--) {
+      universe[i].symbol[c] = static_cast<char>('A' + n % 26);
+      n /= 26;
+    }
+  }
+  return universe;
+}
+
+int main(int argc, char **argv) {
+  const size_t lookups =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+
+  for (size_t symbols : {50, 5000, 100000}) {
+    auto universe = make_universe(symbols);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, symbols - 1);
+    std::vector<uint32_t> stream(lookups);
+    for (auto &i : stream) {
+      i = static_cast<uint32_t>(pick(rng));
+    }
+
+    std::printf("\n%zu symbols, %zu random lookups\n", symbols, lookups);
+
+    // Original path: std::string per tick + node-based hash map
+    {
+      std::unordered_map<std::string, Counter> map;
+      uint64_t start = bench::now_ns();
+      for (uint32_t i : stream) {
+        const protocol::TickPacket &tick = universe[i];
+        std::string sym(tick.symbol, strnlen(tick.symbol, 4));
+        map[sym].ticks++;
+      }
+      bench::print_rate("unordered_map<std::string>", lookups,
+                        bench::now_ns() - start);
+      bench::do_not_optimize(map.size());
+    }
+
+    // Flat table keyed by the raw 4 bytes
+    {
+      auto table = std::make_unique<core::SymbolTable<Counter, 1 << 17>>();
+      uint64_t start = bench::now_ns();
+      for (uint32_t i : stream) {
+        table->find_or_insert(core::symbol_key(universe[i].symbol)).ticks++;
+      }
+      bench::print_rate("core::SymbolTable", lookups,
+                        bench::now_ns() - start);
+      bench::do_not_optimize(table->size());
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+// Publisher tick rates for live generation against a precomputed tick file,
+// with the network taken out:
+//   live      MarketGenerator moves traded through the matching engine by a
+//             requoting market maker and a crossing taker, as the Publisher
+//             does per timer event
+//   generate  the same moves written to a tick file (--generate)
+//   replay    the file memory-mapped and every tick stamped and pushed to
+//             the recovery RingBuffer, as --replay does before the send
+// The file must hold exactly the ticks the live engine printed (symbol,
+// price, quantity, in order), and a second file from the same seed must be
+// byte-identical to the first.
+//
+// Usage: tick_replay_bench [ticks] [directory]
+
+#include "bench_utils.hpp"
+#include "market_generator.hpp"
+#include "matching_engine.hpp"
+#include "protocol.hpp"
+#include "ring_buffer.hpp"
+#include "tick_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+constexpr uint64_t SEED = 2024;
+constexpr uint64_t TICKS_PER_MS = 10;
+constexpr size_t BATCH = 4096;
+using Ring = core::RingBuffer<protocol::TickPacket, 50000>;
+
+// Executions as the Publisher turns them into ticks
+struct TickRecorder {
+  std::vector<protocol::TickPacket> ticks;
+
+  void on_execution(const exchange::Execution &exec) {
+    protocol::TickPacket tick{};
+    std::memcpy(tick.symbol, exec.symbol, sizeof(tick.symbol));
+    tick.price = protocol::to_price(exec.price);
+    tick.quantity = exec.quantity;
+    ticks.push_back(tick);
+  }
+  void on_book_update(const protocol::BookUpdate &update) {
+    bench::do_not_optimize(update);
+  }
+};
+
+using Engine = exchange::MatchingEngine<TickRecorder>;
+
+// The Publisher's generated liquidity: quotes one tick either side of the
+// price, replaced per move, and an IOC taker crossing the spread
+static void live_run(uint64_t ticks, TickRecorder &recorder) {
+  constexpr uint32_t QUOTE_OWNER = 0xFFFFFF, TAKER_OWNER = 0xFFFFFE;
+  auto engine = std::make_unique<Engine>(recorder, 1 << 20);
+  exchange::MarketGenerator<> generator(SEED);
+  std::vector<uint64_t> bid(generator.symbols()), ask(generator.symbols());
+  uint64_t next_id = 1;
+  std::vector<exchange::GeneratedTick> moves(BATCH);
+  for (uint64_t done = 0; done < ticks; done += BATCH) {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(BATCH, ticks - done));
+    generator.generate(std::span(moves.data(), n));
+    for (size_t i = 0; i < n; i++) {
+      const exchange::GeneratedTick &move = moves[i];
+      const char (&symbol)[4] = generator.name(move.symbol);
+      int64_t fair = protocol::to_ticks(move.price);
+      engine->cancel(QUOTE_OWNER, bid[move.symbol]);
+      engine->cancel(QUOTE_OWNER, ask[move.symbol]);
+      bid[move.symbol] = next_id++;
+      ask[move.symbol] = next_id++;
+      engine->add(QUOTE_OWNER, bid[move.symbol], symbol, protocol::Side::Buy,
+                  fair - 1, 1000);
+      engine->add(QUOTE_OWNER, ask[move.symbol], symbol, protocol::Side::Sell,
+                  fair + 1, 1000);
+      uint64_t seq = recorder.ticks.size() + 1;
+      int64_t limit = move.side == protocol::Side::Buy ? fair + 1 : fair - 1;
+      engine->add(TAKER_OWNER, next_id++, symbol, move.side, limit,
+                  100 + static_cast<uint32_t>(seq % 50), true);
+    }
+  }
+}
+
+// What the Publisher's --generate writes
+static void write_file(const std::string &path, uint64_t ticks) {
+  exchange::MarketGenerator<> generator(SEED);
+  core::TickFileWriter file(path, SEED, TICKS_PER_MS);
+  std::vector<exchange::GeneratedTick> moves(BATCH);
+  std::vector<protocol::TickPacket> out(BATCH);
+  for (uint64_t done = 0; done < ticks;) {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(BATCH, ticks - done));
+    generator.generate(std::span(moves.data(), n));
+    for (size_t i = 0; i < n; i++, done++) {
+      const uint64_t seq = done + 1;
+      out[i] = exchange::generated_trade(
+          moves[i], generator.name(moves[i].symbol),
+          100 + static_cast<uint32_t>(seq % 50));
+      out[i].sequence_num = seq;
+      out[i].timestamp = done / TICKS_PER_MS * 1000000;
+    }
+    file.append(std::span(out.data(), n));
+  }
+  file.finish();
+}
+
+int main(int argc, char **argv) {
+  const uint64_t ticks =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+  const std::string dir = argc > 2 ? argv[2] : "/tmp";
+  const std::string path = dir + "/tick_replay_bench.ticks";
+  const std::string again = dir + "/tick_replay_bench_2.ticks";
+  std::printf("%llu ticks over %zu symbols, %.1f MB of file\n",
+              static_cast<unsigned long long>(ticks),
+              std::size(exchange::DEFAULT_SYMBOLS),
+              ticks * sizeof(protocol::TickPacket) / 1048576.0);
+
+  TickRecorder live;
+  live.ticks.reserve(ticks);
+  uint64_t start = bench::now_ns();
+  live_run(ticks, live);
+  bench::print_rate("live (generator + engine)", ticks,
+                    bench::now_ns() - start);
+
+  start = bench::now_ns();
+  write_file(path, ticks);
+  bench::print_rate("generate to file", ticks, bench::now_ns() - start);
+  write_file(again, ticks);
+
+  bool same_file = false, same_ticks = false;
+  {
+    core::MappedTickFile file(path);
+    start = bench::now_ns();
+    bench::do_not_optimize(file.prefault());
+    std::printf("%-32s %.3f ms\n", "prefault mapped file",
+                (bench::now_ns() - start) / 1e6);
+
+    // Replay: stamp and push, no random numbers
+    auto ring = std::make_unique<Ring>();
+    const std::span<const protocol::TickPacket> recorded = file.ticks();
+    start = bench::now_ns();
+    uint64_t seq = 1;
+    for (protocol::TickPacket tick : recorded) {
+      tick.sequence_num = seq;
+      tick.timestamp = bench::now_ns();
+      ring->push(seq++, tick);
+    }
+    bench::print_rate("replay from mmap", recorded.size(),
+                      bench::now_ns() - start);
+
+    core::MappedTickFile second(again);
+    same_file = file.bytes() == second.bytes() &&
+                std::memcmp(&file.header(), &second.header(), file.bytes()) ==
+                    0;
+    same_ticks = recorded.size() == live.ticks.size();
+    for (size_t i = 0; same_ticks && i < recorded.size(); i++) {
+      const protocol::TickPacket &a = recorded[i], &b = live.ticks[i];
+      same_ticks = a.price == b.price && a.quantity == b.quantity &&
+                   std::memcmp(a.symbol, b.symbol, sizeof(a.symbol)) == 0 &&
+                   a.sequence_num == i + 1;
+    }
+  }
+  std::printf("%-32s %s (%zu live ticks)\n", "file vs live engine check",
+              same_ticks ? "match" : "MISMATCH", live.ticks.size());
+  std::printf("%-32s %s\n", "same seed, same file check",
+              same_file ? "match" : "MISMATCH");
+  unlink(path.c_str());
+  unlink(again.c_str());
+  return same_ticks && same_file ? 0 : 1;
+}
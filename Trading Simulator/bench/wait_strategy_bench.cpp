@@ -0,0 +1,81 @@
+// Wakeup latency and consumer CPU use of each wait strategy. A producer posts
+// timestamped ticks into an SPSCQueue at a fixed interval (an idle-ish market)
+// and the consumer waits for each one through the strategy under test.
+//
+// Usage: wait_strategy_bench [events_per_run]
+
+#include "bench_utils.hpp"
+#include "protocol.hpp"
+#include "spsc_queue.hpp"
+#include "wait_strategy.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Queue = SPSCQueue<protocol::TickPacket, 1024>;
+
+static uint64_t thread_cpu_ns() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+template <typename Wait> void run(uint64_t events, uint64_t interval_ns) {
+  auto queue = std::make_unique<Queue>();
+  Wait data_ready;
+  std::vector<uint64_t> samples;
+  samples.reserve(events);
+  uint64_t consumer_cpu = 0;
+
+  std::thread consumer([&] {
+    bench::pin_thread(1);
+    uint64_t cpu_start = thread_cpu_ns();
+    for (uint64_t i = 0; i < events; i++) {
+      const protocol::TickPacket *tick = nullptr;
+      data_ready.wait_until([&] { return (tick = queue->front()) != nullptr; });
+      samples.push_back(bench::now_ns() - tick->timestamp);
+      queue->pop();
+    }
+    consumer_cpu = thread_cpu_ns() - cpu_start;
+  });
+
+  bench::pin_thread(0);
+  uint64_t start = bench::now_ns();
+  for (uint64_t i = 0; i < events; i++) {
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::nanoseconds(start + i * interval_ns)));
+    protocol::TickPacket *slot;
+    while (!(slot = queue->claim_write())) {
+    }
+    slot->sequence_num = i;
+    slot->timestamp = bench::now_ns();
+    queue->commit_write();
+    data_ready.notify();
+  }
+  consumer.join();
+  uint64_t wall = bench::now_ns() - start;
+
+  bench::print_latency(std::string(Wait::name) + " wakeup", samples);
+  std::printf("%-32s consumer CPU %.1f%% of one core\n", "",
+              100.0 * consumer_cpu / wall);
+}
+
+int main(int argc, char **argv) {
+  const uint64_t events =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+
+  for (uint64_t interval_us : {10, 100, 1000}) {
+    std::printf("\n%llu events, one every %lluus\n",
+                static_cast<unsigned long long>(events),
+                static_cast<unsigned long long>(interval_us));
+    run<core::BusySpinWait>(events, interval_us * 1000);
+    run<core::SpinPauseWait>(events, interval_us * 1000);
+    run<core::SpinYieldWait>(events, interval_us * 1000);
+    run<core::BlockingWait>(events, interval_us * 1000);
+  }
+  return 0;
+}
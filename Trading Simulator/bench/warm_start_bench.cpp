@@ -0,0 +1,209 @@
+// Time-to-ready per symbol for a fresh subscriber, with and without a
+// warm-start history load, in two markets:
+//   uniform    50 symbols at 200 ticks/sec each, as the Publisher's
+//              generator sends at its default rate
+//   long tail  symbols at log-uniform rates from 0.2 to 100 ticks/sec, so
+//              slow names dominate the cold warmup
+// The Publisher's RingBuffer holds the last 50000 ticks before the
+// subscriber starts:
+//   cold  an SMA100 window fills from live ticks only; a symbol is ready
+//         at its 100th live tick
+//   warm  the last 100 ticks per symbol are collected from the RingBuffer
+//         (as the Publisher serves a history request) and loaded with
+//         warm_up; a symbol with a full window is ready once the load is
+//         done, the rest after the live ticks they still miss
+// Times are market seconds from subscriber start, by percentile over all
+// symbols and by rate band. The collected history is checked against a
+// brute-force search of the ring's ticks, and warm_up must fill exactly the
+// symbols with 100 ticks of history and send no orders.
+//
+// Usage: warm_start_bench [long tail symbols]
+
+#include "bench_utils.hpp"
+#include "mean_reversion.hpp"
+#include "order_sink.hpp"
+#include "protocol.hpp"
+#include "ring_buffer.hpp"
+#include "strategy.hpp"
+#include "tick_history.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+constexpr size_t RING_SIZE = 50000;
+constexpr uint32_t PERIOD = 100;
+constexpr double MIN_RATE = 0.2;
+constexpr double MAX_RATE = 100.0;
+constexpr double PRESTART_SECS = 20.0;
+
+using Ring = core::RingBuffer<protocol::TickPacket, RING_SIZE>;
+using Strategies =
+    strategy::StrategySet<strategy::MeanReversion<PERIOD, 1 << 12>>;
+
+struct Arrival {
+  double time;
+  uint32_t symbol;
+};
+
+static void name_of(uint32_t symbol, char (&out)[4]) {
+  uint32_t n = symbol;
+  for (int c = 3; c >= 0; c--) {
+    out[c] = static_cast<char>('A' + n % 26);
+    n /= 26;
+  }
+}
+
+// Seconds from start to the n-th live tick of a symbol ticking at rate
+static double nth_arrival(std::mt19937_64 &rng, double rate, uint32_t n) {
+  std::exponential_distribution<double> gap(rate);
+  double t = 0.0;
+  for (uint32_t i = 0; i < n; i++)
+    t += gap(rng);
+  return t;
+}
+
+static double percentile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(p * (values.size() - 1))];
+}
+
+static bool run(const char *market, const std::vector<double> &rates) {
+  const size_t symbols = rates.size();
+  std::mt19937_64 rng(5);
+  double total_rate = 0.0;
+  for (double rate : rates)
+    total_rate += rate;
+
+  // Ticks before the subscriber starts (t < 0), in time order, into the ring
+  std::vector<Arrival> past;
+  for (uint32_t s = 0; s < symbols; s++) {
+    std::exponential_distribution<double> gap(rates[s]);
+    for (double t = -PRESTART_SECS + gap(rng); t < 0.0; t += gap(rng))
+      past.push_back({t, s});
+  }
+  std::sort(past.begin(), past.end(),
+            [](const Arrival &a, const Arrival &b) { return a.time < b.time; });
+  auto ring = std::make_unique<Ring>();
+  std::vector<protocol::TickPacket> sent(past.size());
+  for (size_t i = 0; i < past.size(); i++) {
+    protocol::TickPacket &tick = sent[i];
+    tick.sequence_num = i + 1;
+    tick.timestamp = i;
+    tick.price = 100.0 + 0.01 * static_cast<double>(i % 97);
+    tick.quantity = 100;
+    name_of(past[i].symbol, tick.symbol);
+    ring->push(tick.sequence_num, tick);
+  }
+  std::printf("--- %s: %zu symbols, %.0f ticks/sec in total, RingBuffer of "
+              "%zu ticks (%.1f s) ---\n",
+              market, symbols, total_rate, RING_SIZE, RING_SIZE / total_rate);
+
+  // History load, as a fresh subscriber does it
+  strategy::OrderQueue queue;
+  strategy::OrderSink sink(queue);
+  strategy::StrategyConfig config;
+  config.orders = &sink;
+  auto set = std::make_unique<Strategies>(config);
+  std::vector<protocol::TickPacket> history;
+  uint64_t start = bench::now_ns();
+  uint64_t last = core::collect_history(*ring, PERIOD, {}, history);
+  uint64_t collected = bench::now_ns();
+  set->warm_up(history);
+  uint64_t loaded = bench::now_ns();
+  const double load_secs = (loaded - start) / 1e9;
+  size_t ready_at_start = 0;
+  set->for_each([&](const auto &s) { ready_at_start = s.ready_symbols(); });
+  std::printf("%-32s %zu ticks (%zu KB) up to seq %llu: collected in "
+              "%.0f us, loaded in %.0f us\n",
+              "history", history.size(),
+              history.size() * sizeof(protocol::TickPacket) / 1024,
+              static_cast<unsigned long long>(last),
+              (collected - start) / 1e3, (loaded - collected) / 1e3);
+
+  // Reference: the last PERIOD ticks of each symbol among the ring's ticks
+  const size_t ring_first = sent.size() > RING_SIZE ? sent.size() - RING_SIZE
+                                                    : 0;
+  std::vector<uint32_t> have(symbols, 0);
+  std::vector<protocol::TickPacket> expected;
+  for (size_t i = sent.size(); i-- > ring_first;) {
+    uint32_t s = past[i].symbol;
+    if (have[s] < PERIOD) {
+      have[s]++;
+      expected.push_back(sent[i]);
+    }
+  }
+  std::reverse(expected.begin(), expected.end());
+  size_t full = static_cast<size_t>(
+      std::count(have.begin(), have.end(), PERIOD));
+  bool match =
+      expected.size() == history.size() &&
+      std::equal(expected.begin(), expected.end(), history.begin(),
+                 [](const protocol::TickPacket &a,
+                    const protocol::TickPacket &b) {
+                   return a.sequence_num == b.sequence_num;
+                 }) &&
+      ready_at_start == full && queue.front() == nullptr;
+
+  // Time to ready per symbol: live arrivals drawn once, shared by both runs
+  std::vector<double> cold(symbols), warm(symbols);
+  for (uint32_t s = 0; s < symbols; s++) {
+    std::mt19937_64 live(1000 + s);
+    cold[s] = nth_arrival(live, rates[s], PERIOD);
+    std::mt19937_64 again(1000 + s);
+    warm[s] = have[s] == PERIOD
+                  ? load_secs
+                  : load_secs + nth_arrival(again, rates[s], PERIOD - have[s]);
+  }
+  std::printf("%-32s cold 0, warm %zu of %zu symbols\n", "ready at start",
+              ready_at_start, symbols);
+  std::printf("%-32s %9s %9s %9s %9s %9s\n", "time to ready (market s)",
+              "p10", "p50", "p90", "p99", "max");
+  for (auto [label, times] : {std::pair{"cold", &cold}, {"warm", &warm}}) {
+    std::printf("  %-30s %9.3f %9.3f %9.3f %9.3f %9.3f\n", label,
+                percentile(*times, 0.10), percentile(*times, 0.50),
+                percentile(*times, 0.90), percentile(*times, 0.99),
+                percentile(*times, 1.0));
+  }
+
+  std::printf("%-32s %9s %9s %9s\n", "median by rate (ticks/sec)", "symbols",
+              "cold", "warm");
+  const double bands[] = {0.0, 1.0, 10.0, 30.0, 1000.0};
+  for (size_t b = 0; b + 1 < std::size(bands); b++) {
+    std::vector<double> c, w;
+    for (size_t s = 0; s < symbols; s++) {
+      if (rates[s] >= bands[b] && rates[s] < bands[b + 1]) {
+        c.push_back(cold[s]);
+        w.push_back(warm[s]);
+      }
+    }
+    if (c.empty())
+      continue;
+    std::printf("  %5.0f-%-24.0f %9zu %9.3f %9.3f\n", bands[b], bands[b + 1],
+                c.size(), percentile(c, 0.5), percentile(w, 0.5));
+  }
+
+  std::printf("%-32s %s\n", "history check", match ? "match" : "MISMATCH");
+  return match;
+}
+
+int main(int argc, char **argv) {
+  const size_t symbols = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+  if (symbols == 0 || symbols > (1 << 12)) {
+    std::fprintf(stderr, "Need 1-4096 symbols\n");
+    return 1;
+  }
+  std::mt19937_64 rng(9);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<double> long_tail(symbols);
+  for (double &rate : long_tail)
+    rate = MIN_RATE * std::pow(MAX_RATE / MIN_RATE, unit(rng));
+
+  bool ok = run("uniform", std::vector<double>(50, 200.0));
+  ok = run("long tail", long_tail) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "log_formats.hpp"
+#include "spsc_queue.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core {
+
+// Asynchronous binary logger. A hot-path log call stamps the time and copies
+// its LogId and raw arguments into a 64-byte record in the calling thread's
+// own SPSCQueue: no formatting, no locks, no syscalls. One background thread
+// drains every queue, formats the text for the terminal and optionally
+// appends the raw records to a file for log_decoder. When a queue is full
+// the record is dropped and counted rather than stalling the caller.
+
+struct alignas(64) LogRecord {
+  uint64_t timestamp; // ns since the epoch (same clock as TickPacket)
+  uint16_t id;        // LogId
+  uint16_t thread;    // registration order of the logging thread
+  uint32_t reserved;
+  uint64_t args[MAX_LOG_ARGS];
+};
+
+static_assert(sizeof(LogRecord) == 64, "LogRecord must fill one cache line");
+
+// Header at the start of a binary log file
+struct LogFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+constexpr char LOG_FILE_MAGIC[8] = {'H', 'F', 'T', 'L', 'O', 'G', '\0', '\0'};
+constexpr uint32_t LOG_FILE_VERSION = 1;
+
+// A 4-byte wire symbol as a log argument
+struct LogSymbol {
+  uint32_t key;
+  explicit LogSymbol(const char (&symbol)[4]) {
+    std::memcpy(&key, symbol, sizeof(key));
+  }
+};
+
+template <typename T> constexpr LogArg log_arg_kind() {
+  if constexpr (std::is_same_v<T, LogSymbol>)
+    return LogArg::Symbol;
+  else if constexpr (std::is_floating_point_v<T>)
+    return LogArg::Double;
+  else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    return LogArg::Int;
+  else if constexpr (std::is_integral_v<T>)
+    return LogArg::UInt;
+  else
+    return LogArg::None;
+}
+
+template <typename T> inline uint64_t log_slot(T value) {
+  if constexpr (std::is_same_v<T, LogSymbol>)
+    return value.key;
+  else if constexpr (std::is_floating_point_v<T>)
+    return std::bit_cast<uint64_t>(static_cast<double>(value));
+  else
+    return static_cast<uint64_t>(value);
+}
+
+template <LogId Id, typename... Args> constexpr bool log_args_match() {
+  constexpr const LogFormat &format = log_format(Id);
+  if (sizeof...(Args) != format.arity())
+    return false;
+  size_t i = 0;
+  return ((log_arg_kind<Args>() == format.args[i++]) && ...);
+}
+
+// Appends the text of record to out. color adds the format's ANSI colour.
+inline void format_log_record(const LogRecord &record, std::string &out,
+                              bool color) {
+  if (record.id >= static_cast<uint16_t>(LogId::Count)) {
+    out += "[LOG] unknown record id " + std::to_string(record.id);
+    return;
+  }
+  const LogFormat &format = log_format(static_cast<LogId>(record.id));
+  if (color && format.color)
+    out += format.color;
+
+  size_t arg = 0;
+  char number[32];
+  for (const char *c = format.text; *c != '\0'; c++) {
+    if (c[0] != '{' || c[1] != '}') {
+      out += *c;
+      continue;
+    }
+    uint64_t slot = record.args[arg];
+    switch (format.args[arg]) {
+    case LogArg::Int:
+      std::snprintf(number, sizeof(number), "%" PRId64,
+                    static_cast<int64_t>(slot));
+      out += number;
+      break;
+    case LogArg::UInt:
+      std::snprintf(number, sizeof(number), "%" PRIu64, slot);
+      out += number;
+      break;
+    case LogArg::Double:
+      // %g matches the default std::ostream formatting of the old prints
+      std::snprintf(number, sizeof(number), "%g",
+                    std::bit_cast<double>(slot));
+      out += number;
+      break;
+    case LogArg::Symbol: {
+      char chars[4];
+      uint32_t key = static_cast<uint32_t>(slot);
+      std::memcpy(chars, &key, sizeof(chars));
+      out.append(chars, strnlen(chars, sizeof(chars)));
+      break;
+    }
+    case LogArg::None:
+      break;
+    }
+    arg++;
+    c++;
+  }
+
+  if (color && format.color)
+    out += "\033[0m";
+}
+
+class Logger {
+public:
+  static constexpr size_t MAX_THREADS = 64;
+  static constexpr size_t QUEUE_CAPACITY = 8192;
+
+  using Queue = SPSCQueue<LogRecord, QUEUE_CAPACITY>;
+
+  struct Options {
+    FILE *text = stdout; // Formatted output (errors go to stderr); nullptr
+                         // disables it
+    std::string binary_path; // Raw records for log_decoder, if not empty
+  };
+
+  static Logger &instance() {
+    static Logger logger;
+    return logger;
+  }
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  ~Logger() { stop(); }
+
+  void start(const Options &options) {
+    if (enabled_.load(std::memory_order_relaxed))
+      throw std::runtime_error("Logger already started");
+    options_ = options;
+    if (!options_.binary_path.empty()) {
+      binary_ = std::fopen(options_.binary_path.c_str(), "wb");
+      if (!binary_)
+        throw std::runtime_error("Cannot open log file " +
+                                 options_.binary_path);
+      LogFileHeader header{};
+      std::memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+      header.version = LOG_FILE_VERSION;
+      header.record_size = sizeof(LogRecord);
+      std::fwrite(&header, sizeof(header), 1, binary_);
+    }
+    running_.store(true, std::memory_order_relaxed);
+    writer_ = std::thread([this] { run(); });
+    enabled_.store(true, std::memory_order_release);
+  }
+
+  // Stops accepting records, writes out everything queued and joins the
+  // background thread
+  void stop() {
+    if (!enabled_.exchange(false, std::memory_order_acq_rel))
+      return;
+    running_.store(false, std::memory_order_release);
+    writer_.join();
+    if (binary_) {
+      std::fclose(binary_);
+      binary_ = nullptr;
+    }
+  }
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Records dropped on full queues so far
+  uint64_t dropped() const {
+    uint64_t total = 0;
+    size_t count = registered_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+      total += threads_[i]->dropped.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  // The calling thread's queue, registered on its first log call. nullptr
+  // once MAX_THREADS threads have registered.
+  static Queue *thread_queue(uint16_t &thread) {
+    thread_local ThreadLog *log = instance().register_thread();
+    if (!log)
+      return nullptr;
+    thread = log->thread;
+    return &log->queue;
+  }
+
+  static void count_drop() {
+    uint16_t thread;
+    if (thread_queue(thread))
+      instance().threads_[thread]->dropped.fetch_add(
+          1, std::memory_order_relaxed);
+  }
+
+private:
+  struct ThreadLog {
+    Queue queue;
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    uint16_t thread = 0;
+  };
+
+  Logger() = default;
+
+  // Cold path: once per thread
+  ThreadLog *register_thread() {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    size_t count = registered_.load(std::memory_order_relaxed);
+    if (count == MAX_THREADS)
+      return nullptr;
+    threads_[count] = std::make_unique<ThreadLog>();
+    threads_[count]->thread = static_cast<uint16_t>(count);
+    registered_.store(count + 1, std::memory_order_release);
+    return threads_[count].get();
+  }
+
+  // Background thread: round-robin over the per-thread queues
+  void run() {
+    std::string text;
+    while (true) {
+      bool stopping = !running_.load(std::memory_order_acquire);
+      size_t drained = 0;
+      size_t count = registered_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < count; i++) {
+        Queue &queue = threads_[i]->queue;
+        std::span<const LogRecord> records;
+        while (!(records = queue.front_n(256)).empty()) {
+          write(records, text);
+          queue.pop_n(records.size());
+          drained += records.size();
+        }
+      }
+      if (drained == 0) {
+        if (stopping)
+          break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+
+    uint64_t lost = dropped();
+    if (lost != 0 && options_.text)
+      std::fprintf(stderr, "[LOG] %" PRIu64 " records dropped (queue full)\n",
+                   lost);
+    if (options_.text)
+      std::fflush(options_.text);
+  }
+
+  void write(std::span<const LogRecord> records, std::string &text) {
+    if (binary_)
+      std::fwrite(records.data(), sizeof(LogRecord), records.size(), binary_);
+    if (!options_.text)
+      return;
+    for (const LogRecord &record : records) {
+      text.clear();
+      format_log_record(record, text, true);
+      text += '\n';
+      bool error = log_format(static_cast<LogId>(record.id)).error;
+      std::fwrite(text.data(), 1, text.size(),
+                  error ? stderr : options_.text);
+    }
+  }
+
+  Options options_;
+  FILE *binary_ = nullptr;
+  std::thread writer_;
+  std::atomic<bool> enabled_{false};
+  std::atomic<bool> running_{false};
+  std::mutex register_mutex_;
+  std::atomic<size_t> registered_{0};
+  std::array<std::unique_ptr<ThreadLog>, MAX_THREADS> threads_;
+};
+
+// Hot-path entry point. The argument types are checked against the LogId's
+// catalogue entry at compile time. A no-op until Logger::start().
+template <LogId Id, typename... Args> inline void log(Args... args) {
+  static_assert(log_args_match<Id, Args...>(),
+                "log arguments do not match the LOG_FORMATS entry");
+  if (!Logger::instance().enabled())
+    return;
+
+  uint16_t thread = 0;
+  Logger::Queue *queue = Logger::thread_queue(thread);
+  LogRecord *record = queue ? queue->claim_write() : nullptr;
+  if (!record) {
+    Logger::count_drop();
+    return;
+  }
+  record->timestamp = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::high_resolution_clock::now().time_since_epoch())
+          .count());
+  record->id = static_cast<uint16_t>(Id);
+  record->thread = thread;
+  size_t i = 0;
+  ((record->args[i++] = log_slot(args)), ...);
+  queue->commit_write();
+}
+
+} // namespace core
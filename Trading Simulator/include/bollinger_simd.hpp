@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOLLINGER_X86 1
+#endif
+
+namespace strategy {
+
+// Bollinger band inputs and outputs for up to BAND_BATCH ticks, one lane per
+// tick. The strategy fills price/mean/m2 (the rolling statistics after that
+// tick's update) and a kernel fills the rest.
+constexpr size_t BAND_BATCH = 64;
+
+struct BandBatch {
+  alignas(64) double price[BAND_BATCH] = {};
+  alignas(64) double mean[BAND_BATCH] = {};
+  alignas(64) double m2[BAND_BATCH] = {};
+  alignas(64) double sma[BAND_BATCH] = {};
+  alignas(64) double std_dev[BAND_BATCH] = {};
+  uint64_t below_band = 0; // Bit i: price <= sma - 2 sigma (buy signal)
+  uint64_t above_sma = 0;  // Bit i: price >= sma (take profit)
+  uint32_t id[BAND_BATCH] = {};
+  uint32_t tick[BAND_BATCH] = {}; // Position of the tick in the caller's span
+};
+
+// One tick's SMA and floored standard deviation. This is the per-tick path's
+// arithmetic; every kernel below performs the same IEEE operations in the
+// same order, so with FP contraction off (see CMakeLists.txt) the batch
+// results are bit-identical to it.
+inline void bollinger_bands(double mean, double m2, double period,
+                            double &sma, double &std_dev) {
+  sma = mean;
+
+  // Population variance of the window
+  double variance = m2 / period;
+
+  // Rounding in the rolling update can leave M2 a hair below zero when the
+  // window is flat
+  if (variance < 0.0) {
+    variance = 0.0;
+  }
+
+  std_dev = std::sqrt(variance);
+
+  // Round the standard deviation so it doesn't get too small
+  // in completely silent markets
+  if (std_dev < 0.10)
+    std_dev = 0.10;
+}
+
+enum class SimdLevel { Scalar, Avx2, Avx512 };
+
+inline const char *simd_name(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return "scalar";
+  case SimdLevel::Avx2:
+    return "AVX2";
+  case SimdLevel::Avx512:
+    return "AVX-512";
+  }
+  return "?";
+}
+
+// Widest kernel this CPU runs
+inline SimdLevel detect_simd() {
+#ifdef BOLLINGER_X86
+  if (__builtin_cpu_supports("avx512f"))
+    return SimdLevel::Avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::Avx2;
+#endif
+  return SimdLevel::Scalar;
+}
+
+// "auto", "avx512", "avx2" or "scalar". Requests above what the CPU supports
+// fall back to the widest available kernel.
+inline SimdLevel parse_simd_level(const std::string &name) {
+  SimdLevel best = detect_simd();
+  SimdLevel wanted;
+  if (name == "auto")
+    return best;
+  if (name == "avx512")
+    wanted = SimdLevel::Avx512;
+  else if (name == "avx2")
+    wanted = SimdLevel::Avx2;
+  else if (name == "scalar")
+    wanted = SimdLevel::Scalar;
+  else
+    throw std::runtime_error("Unknown SIMD level: " + name);
+  return static_cast<int>(wanted) < static_cast<int>(best) ? wanted : best;
+}
+
+inline void bollinger_scalar(BandBatch &batch, size_t n, double period) {
+  batch.below_band = 0;
+  batch.above_sma = 0;
+  for (size_t i = 0; i < n; i++) {
+    bollinger_bands(batch.mean[i], batch.m2[i], period, batch.sma[i],
+                    batch.std_dev[i]);
+    double price = batch.price[i];
+    if (price <= batch.sma[i] - (2.0 * batch.std_dev[i]))
+      batch.below_band |= uint64_t{1} << i;
+    if (price >= batch.sma[i])
+      batch.above_sma |= uint64_t{1} << i;
+  }
+}
+
+#ifdef BOLLINGER_X86
+// Lanes past n are computed on stale data and masked out of the signals
+__attribute__((target("avx2"))) inline void
+bollinger_avx2(BandBatch &batch, size_t n, double period) {
+  const __m256d vperiod = _mm256_set1_pd(period);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d min_std_dev = _mm256_set1_pd(0.10);
+  const __m256d two = _mm256_set1_pd(2.0);
+  uint64_t below = 0;
+  uint64_t above = 0;
+
+  for (size_t i = 0; i < n; i += 4) {
+    __m256d sma = _mm256_load_pd(batch.mean + i);
+    __m256d variance = _mm256_div_pd(_mm256_load_pd(batch.m2 + i), vperiod);
+    // max(x, c) returns c when x < c (or x is -0.0), like the scalar clamps
+    variance = _mm256_max_pd(variance, zero);
+    __m256d std_dev = _mm256_max_pd(_mm256_sqrt_pd(variance), min_std_dev);
+    _mm256_store_pd(batch.sma + i, sma);
+    _mm256_store_pd(batch.std_dev + i, std_dev);
+
+    __m256d price = _mm256_load_pd(batch.price + i);
+    __m256d band = _mm256_sub_pd(sma, _mm256_mul_pd(two, std_dev));
+    uint64_t le = static_cast<uint64_t>(
+        _mm256_movemask_pd(_mm256_cmp_pd(price, band, _CMP_LE_OQ)));
+    uint64_t ge = static_cast<uint64_t>(
+        _mm256_movemask_pd(_mm256_cmp_pd(price, sma, _CMP_GE_OQ)));
+    below |= le << i;
+    above |= ge << i;
+  }
+
+  uint64_t valid = n == BAND_BATCH ? ~uint64_t{0} : (uint64_t{1} << n) - 1;
+  batch.below_band = below & valid;
+  batch.above_sma = above & valid;
+}
+
+__attribute__((target("avx512f"))) inline void
+bollinger_avx512(BandBatch &batch, size_t n, double period) {
+  const __m512d vperiod = _mm512_set1_pd(period);
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d min_std_dev = _mm512_set1_pd(0.10);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __mmask8 ALL = 0xFF;
+  uint64_t below = 0;
+  uint64_t above = 0;
+
+  for (size_t i = 0; i < n; i += 8) {
+    __m512d sma = _mm512_load_pd(batch.mean + i);
+    __m512d variance = _mm512_div_pd(_mm512_load_pd(batch.m2 + i), vperiod);
+    // Zero-masked forms with every lane enabled: same result, but GCC 12's
+    // unmasked max/sqrt trip -Wmaybe-uninitialized inside its own headers
+    variance = _mm512_maskz_max_pd(ALL, variance, zero);
+    __m512d std_dev =
+        _mm512_maskz_max_pd(ALL, _mm512_maskz_sqrt_pd(ALL, variance),
+                            min_std_dev);
+    _mm512_store_pd(batch.sma + i, sma);
+    _mm512_store_pd(batch.std_dev + i, std_dev);
+
+    __m512d price = _mm512_load_pd(batch.price + i);
+    __m512d band = _mm512_sub_pd(sma, _mm512_mul_pd(two, std_dev));
+    uint64_t le = _mm512_cmp_pd_mask(price, band, _CMP_LE_OQ);
+    uint64_t ge = _mm512_cmp_pd_mask(price, sma, _CMP_GE_OQ);
+    below |= le << i;
+    above |= ge << i;
+  }
+
+  uint64_t valid = n == BAND_BATCH ? ~uint64_t{0} : (uint64_t{1} << n) - 1;
+  batch.below_band = below & valid;
+  batch.above_sma = above & valid;
+}
+#endif
+
+// Fills sma, std_dev and the signal masks for lanes [0, n)
+inline void bollinger_batch(SimdLevel level, BandBatch &batch, size_t n,
+                            double period) {
+#ifdef BOLLINGER_X86
+  if (level == SimdLevel::Avx512) {
+    bollinger_avx512(batch, n, period);
+    return;
+  }
+  if (level == SimdLevel::Avx2) {
+    bollinger_avx2(batch, n, period);
+    return;
+  }
+#else
+  (void)level;
+#endif
+  bollinger_scalar(batch, n, period);
+}
+
+} // namespace strategy
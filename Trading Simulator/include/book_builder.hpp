@@ -0,0 +1,485 @@
+#pragma once
+
+#include "flat_id_map.hpp"
+#include "index_pool.hpp"
+#include "price_ladder.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace core {
+
+// Top of book in ticks; an empty side is NO_BID / NO_ASK with no quantity
+struct Bbo {
+  int64_t bid_price = NO_BID;
+  uint64_t bid_quantity = 0;
+  int64_t ask_price = NO_ASK;
+  uint64_t ask_quantity = 0;
+};
+
+struct DepthLevel {
+  uint64_t quantity = 0;
+  uint32_t orders = 0;
+};
+
+struct LevelView {
+  int64_t price;
+  uint64_t quantity;
+  uint32_t orders;
+};
+
+// One symbol's market-by-price depth, aggregated from order events
+class DepthBook {
+public:
+  using Ladder = PriceLadder<DepthLevel>;
+
+  explicit DepthBook(uint32_t key) : key_(key) {}
+
+  uint32_t key() const { return key_; }
+  int64_t best_bid() const { return ladder_.best_bid(); }
+  int64_t best_ask() const { return ladder_.best_ask(); }
+  const DepthLevel &level(int64_t price) const { return ladder_.level(price); }
+  bool can_hold(int64_t price) const { return ladder_.can_hold(price); }
+
+  // O(1): the cached best prices and their levels
+  Bbo bbo() const {
+    Bbo top;
+    top.bid_price = ladder_.best_bid();
+    if (top.bid_price != NO_BID)
+      top.bid_quantity = ladder_.level(top.bid_price).quantity;
+    top.ask_price = ladder_.best_ask();
+    if (top.ask_price != NO_ASK)
+      top.ask_quantity = ladder_.level(top.ask_price).quantity;
+    return top;
+  }
+
+  // Copies up to out.size() levels of side, best first; returns the count
+  size_t depth(protocol::Side side, std::span<LevelView> out) const {
+    size_t n = 0;
+    return ladder_.for_each_level(
+        side, out.size(), [&](int64_t price, const DepthLevel &lvl) {
+          out[n++] = {price, lvl.quantity, lvl.orders};
+        });
+  }
+
+  void add(int64_t price, protocol::Side side, uint32_t quantity) {
+    DepthLevel &lvl = ladder_.level(price);
+    if (lvl.orders++ == 0)
+      ladder_.occupy(price, side);
+    lvl.quantity += quantity;
+  }
+
+  // Takes quantity off one order at price; gone once the order has none left
+  void reduce(int64_t price, protocol::Side side, uint32_t quantity,
+              bool gone) {
+    DepthLevel &lvl = ladder_.level(price);
+    lvl.quantity -= quantity;
+    if (gone && --lvl.orders == 0)
+      ladder_.vacate(price, side);
+  }
+
+private:
+  uint32_t key_;
+  Ladder ladder_;
+};
+
+// Builds per-symbol depth from the Publisher's L3 book feed. Live orders
+// sit in a fixed node pool found through a flat order ID map; depth lives in
+// each symbol's PriceLadder, so an event is a hash probe plus one or two
+// array writes, and nothing is allocated after construction apart from the
+// first event seen for a new symbol. Single-threaded: share top of book
+// with other threads through a BboBoard.
+//
+// A book is only in step with the Publisher from a Clear on. An update that
+// does not fit a book empties it, and it then holds nothing and ignores its
+// updates until its next Clear. A book in step ignores the periodic
+// refresh: its Clear, and the Adds of orders it already holds.
+template <size_t MaxSymbols = 1024> class BookBuilder {
+public:
+  explicit BookBuilder(uint32_t max_orders)
+      : orders_(max_orders), ids_(max_orders) {}
+
+  BookBuilder(const BookBuilder &) = delete;
+  BookBuilder &operator=(const BookBuilder &) = delete;
+
+  // Applies one event and returns the book it was for, or nullptr if the
+  // event does not fit the book as built (unknown order ID, pool full,
+  // price outside the ladder span), which empties the book until its next
+  // Clear
+  DepthBook *apply(const protocol::BookUpdate &update) {
+    if (update.action == protocol::BookAction::Clear) {
+      // A book out of step already holds nothing
+      Slot &slot = slot_of(update.symbol);
+      slot.synced = true;
+      return &slot.book;
+    }
+
+    if (update.action == protocol::BookAction::Add) {
+      Slot &slot = slot_of(update.symbol);
+      if (!slot.synced)
+        return &slot.book;
+      DepthBook &book = slot.book;
+      if (orders_.full() || !book.can_hold(update.price) ||
+          update.quantity == 0)
+        return drop(slot);
+      uint32_t index = orders_.acquire();
+      if (!ids_.insert(update.order_id, index)) {
+        orders_.release(index);
+        uint32_t held = ids_.find(update.order_id);
+        // Held already: a refresh
+        return orders_[held].slot == &slot ? &book : drop(slot);
+      }
+      orders_[index] = {update.price, update.order_id, &slot, update.quantity,
+                        update.side};
+      book.add(update.price, update.side, update.quantity);
+      return &book;
+    }
+
+    uint32_t index = ids_.find(update.order_id);
+    if (index == FlatIdMap::NOT_FOUND) {
+      // Expected for a book waiting for its Clear, which holds no orders
+      Slot &slot = slot_of(update.symbol);
+      return slot.synced ? drop(slot) : &slot.book;
+    }
+    OrderNode &node = orders_[index];
+    // A cancel always removes the whole order
+    uint32_t quantity = update.action == protocol::BookAction::Cancel
+                            ? node.quantity
+                            : std::min(update.quantity, node.quantity);
+    node.quantity -= quantity;
+    bool gone = node.quantity == 0;
+    DepthBook &book = node.slot->book;
+    book.reduce(node.price, node.side, quantity, gone);
+    if (gone) {
+      ids_.erase(update.order_id);
+      orders_.release(index);
+    }
+    return &book;
+  }
+
+  DepthBook *book(const char (&symbol)[4]) {
+    Slot *slot = books_.find(symbol_key(symbol));
+    return slot ? &slot->book : nullptr;
+  }
+
+  // The book holds the Publisher's orders, not nothing for want of a Clear
+  bool synced(const DepthBook &book) const {
+    const Slot *slot = books_.find(book.key());
+    return slot && slot->synced;
+  }
+
+  // After a gap in the feed: any book may have missed an update, so every
+  // one is emptied until its next Clear
+  void desync() {
+    empty(nullptr);
+    books_.for_each([](uint32_t, Slot &slot) { slot.synced = false; });
+  }
+
+  size_t orders() const { return orders_.live(); }
+  size_t books() const { return books_.size(); }
+
+private:
+  struct Slot {
+    explicit Slot(uint32_t key) : book(key) {}
+    DepthBook book;
+    bool synced = false;
+  };
+
+  // Free nodes keep their contents with no quantity left
+  struct OrderNode {
+    int64_t price;
+    uint64_t id;
+    Slot *slot;
+    uint32_t quantity;
+    protocol::Side side;
+  };
+
+  Slot &slot_of(const char (&symbol)[4]) {
+    uint32_t key = symbol_key(symbol);
+    return books_.find_or_insert(key, key);
+  }
+
+  DepthBook *drop(Slot &slot) {
+    empty(&slot);
+    slot.synced = false;
+    return nullptr;
+  }
+
+  // Takes every order of slot (of every book for nullptr) off its book.
+  // A scan of the whole pool, which is why only a lost update empties one.
+  void empty(const Slot *slot) {
+    for (uint32_t index = 0; index < orders_.capacity(); index++) {
+      OrderNode &node = orders_[index];
+      if (node.quantity == 0 || (slot != nullptr && node.slot != slot))
+        continue;
+      node.slot->book.reduce(node.price, node.side, node.quantity, true);
+      node.quantity = 0;
+      ids_.erase(node.id);
+      orders_.release(index);
+    }
+  }
+
+  IndexPool<OrderNode> orders_;
+  FlatIdMap ids_;
+  SymbolTable<Slot, MaxSymbols> books_;
+};
+
+// A fixed-depth market-by-price book, maintained by index from the L2
+// feed: the consumer's copy of the top Depth levels of each side
+template <size_t Depth> class MbpBook {
+  static_assert(Depth > 0 && Depth <= 255, "L2 level indexes are 8-bit");
+
+public:
+  struct Level {
+    int64_t price;
+    uint64_t quantity;
+  };
+
+  explicit MbpBook(uint32_t key = 0) : key_(key) {}
+
+  uint32_t key() const { return key_; }
+  size_t levels(protocol::Side side) const { return counts_[slot(side)]; }
+  const Level &level(protocol::Side side, size_t index) const {
+    return sides_[slot(side)][index];
+  }
+
+  // O(1): level 0 of each side
+  Bbo bbo() const {
+    Bbo top;
+    if (counts_[0] != 0) {
+      top.bid_price = sides_[0][0].price;
+      top.bid_quantity = sides_[0][0].quantity;
+    }
+    if (counts_[1] != 0) {
+      top.ask_price = sides_[1][0].price;
+      top.ask_quantity = sides_[1][0].quantity;
+    }
+    return top;
+  }
+
+  // False (and unchanged) if the update does not fit the book as held
+  bool apply(const protocol::LevelUpdate &update) {
+    auto &levels = sides_[slot(update.side)];
+    size_t &count = counts_[slot(update.side)];
+    size_t index = update.level;
+    switch (update.action) {
+    case protocol::LevelAction::Insert:
+      if (index > count || index >= Depth)
+        return false;
+      count = std::min(count + 1, Depth);
+      std::copy_backward(levels.begin() + index, levels.begin() + count - 1,
+                         levels.begin() + count);
+      levels[index] = {update.price, update.quantity};
+      return true;
+    case protocol::LevelAction::Update:
+      if (index >= count || levels[index].price != update.price)
+        return false;
+      levels[index].quantity = update.quantity;
+      return true;
+    case protocol::LevelAction::Delete:
+      if (index >= count || levels[index].price != update.price)
+        return false;
+      std::copy(levels.begin() + index + 1, levels.begin() + count,
+                levels.begin() + index);
+      count--;
+      return true;
+    case protocol::LevelAction::Clear:
+      clear();
+      return true;
+    }
+    return false;
+  }
+
+  void clear() { counts_ = {}; }
+
+private:
+  static size_t slot(protocol::Side side) {
+    return side == protocol::Side::Buy ? 0 : 1;
+  }
+
+  uint32_t key_;
+  std::array<std::array<Level, Depth>, 2> sides_{};
+  std::array<size_t, 2> counts_{};
+};
+
+// Per-symbol MbpBooks built from the L2 feed. Single-threaded, like
+// BookBuilder. A book is only in step with the Publisher from a Clear on:
+// until its symbol's next Clear, a book that has not seen one, or that an
+// update did not fit, holds nothing and ignores its updates.
+template <size_t Depth, size_t MaxSymbols = 1024> class MbpBuilder {
+public:
+  using Book = MbpBook<Depth>;
+
+  // Returns the book the update was for, or nullptr if it did not fit,
+  // which empties the book until the next Clear
+  Book *apply(const protocol::LevelUpdate &update) {
+    uint32_t key = symbol_key(update.symbol);
+    Slot &slot = books_.find_or_insert(key, key);
+    if (update.action == protocol::LevelAction::Clear)
+      slot.synced = true;
+    else if (!slot.synced)
+      return &slot.book;
+    if (slot.book.apply(update))
+      return &slot.book;
+    slot.book.clear();
+    slot.synced = false;
+    return nullptr;
+  }
+
+  Book *book(const char (&symbol)[4]) {
+    Slot *slot = books_.find(symbol_key(symbol));
+    return slot ? &slot->book : nullptr;
+  }
+
+  // The book holds the Publisher's levels, not nothing for want of a Clear
+  bool synced(const Book &book) const {
+    const Slot *slot = books_.find(book.key());
+    return slot && slot->synced;
+  }
+
+  // After a gap in the feed: any book may have missed an update, so every
+  // one is emptied until its next Clear
+  void desync() {
+    books_.for_each([](uint32_t, Slot &slot) {
+      slot.book.clear();
+      slot.synced = false;
+    });
+  }
+
+  size_t books() const { return books_.size(); }
+
+private:
+  struct Slot {
+    explicit Slot(uint32_t key) : book(key) {}
+    Book book;
+    bool synced = false;
+  };
+
+  SymbolTable<Slot, MaxSymbols> books_;
+};
+
+// Latest top of book per symbol for readers on other threads. The book
+// builder's thread publishes; any thread reads a consistent copy through a
+// per-symbol SeqLock, as in RingBuffer. Symbols are only ever added and a
+// slot's key is published last, so lookups need no lock either. A symbol
+// whose book is out of step with the feed is invalidated until its next
+// publish, and reads as nothing published.
+class BboBoard {
+public:
+  explicit BboBoard(size_t max_symbols)
+      : slots_(std::make_unique<Slot[]>(std::bit_ceil(max_symbols * 2))),
+        mask_(std::bit_ceil(max_symbols * 2) - 1),
+        shift_(32 - static_cast<unsigned>(std::countr_zero(mask_ + 1))),
+        max_symbols_(max_symbols) {}
+
+  // Writer thread only. False if the board is already full of other symbols.
+  bool publish(uint32_t key, const Bbo &top) {
+    size_t pos = home(key);
+    while (true) {
+      uint32_t held = slots_[pos].key.load(std::memory_order_relaxed);
+      if (held == key)
+        break;
+      if (held == EMPTY) {
+        if (size_ == max_symbols_)
+          return false;
+        slots_[pos].bbo = top;
+        slots_[pos].valid = true;
+        slots_[pos].key.store(key, std::memory_order_release);
+        size_++;
+        return true;
+      }
+      pos = (pos + 1) & mask_;
+    }
+
+    write(slots_[pos], top, true);
+    return true;
+  }
+
+  // Writer thread only: key reads as unpublished until its next publish
+  void invalidate(uint32_t key) {
+    size_t pos = home(key);
+    while (true) {
+      uint32_t held = slots_[pos].key.load(std::memory_order_relaxed);
+      if (held == key)
+        break;
+      if (held == EMPTY)
+        return;
+      pos = (pos + 1) & mask_;
+    }
+    write(slots_[pos], Bbo{}, false);
+  }
+
+  // Writer thread only: every symbol, after a gap in the feed
+  void invalidate_all() {
+    for (size_t pos = 0; pos <= mask_; pos++) {
+      if (slots_[pos].key.load(std::memory_order_relaxed) != EMPTY)
+        write(slots_[pos], Bbo{}, false);
+    }
+  }
+
+  // Any thread. False if nothing has been published for key yet, or it
+  // was invalidated since.
+  bool read(uint32_t key, Bbo &out) const {
+    size_t pos = home(key);
+    while (true) {
+      uint32_t held = slots_[pos].key.load(std::memory_order_acquire);
+      if (held == key)
+        break;
+      if (held == EMPTY)
+        return false;
+      pos = (pos + 1) & mask_;
+    }
+
+    const Slot &slot = slots_[pos];
+    while (true) {
+      uint32_t v1 = slot.version.load(std::memory_order_acquire);
+      if (v1 & 1)
+        continue; // Writer is mid-write, retry
+      out = slot.bbo;
+      bool valid = slot.valid;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.version.load(std::memory_order_relaxed) == v1)
+        return valid;
+    }
+  }
+
+private:
+  static constexpr uint32_t EMPTY = 0;
+
+  struct alignas(64) Slot {
+    std::atomic<uint32_t> key{EMPTY};
+    std::atomic<uint32_t> version{0};
+    Bbo bbo;
+    bool valid = false;
+  };
+
+  static void write(Slot &slot, const Bbo &top, bool valid) {
+    // SeqLock: odd while the write is in progress
+    uint32_t v = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.bbo = top;
+    slot.valid = valid;
+    slot.version.store(v + 2, std::memory_order_release);
+  }
+
+  // Fibonacci hashing: the top bits of key * 2^32/phi
+  size_t home(uint32_t key) const {
+    return static_cast<uint32_t>(key * 0x9E3779B1u) >> shift_;
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  unsigned shift_;
+  size_t max_symbols_;
+  size_t size_ = 0;
+};
+
+} // namespace core
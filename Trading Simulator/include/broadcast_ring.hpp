@@ -0,0 +1,233 @@
+#pragma once
+
+#include "shared_memory.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace core {
+
+enum class BroadcastReadStatus { Ok, Empty, Overrun };
+
+// Single-Producer Multi-Consumer broadcast ring (Disruptor style) designed to
+// live in shared memory. One feed handler publishes, every consumer process
+// walks the ring with its own private cursor. The producer never waits on
+// consumers: a reader that falls a full lap behind detects the overwrite via
+// the slot's SeqLock stamp and reports an overrun instead of stalling anyone.
+template <typename T, size_t Capacity, size_t MaxConsumers = 16>
+class BroadcastRing {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "BroadcastRing items are copied as raw bytes");
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "Cross-process atomics must be lock-free");
+
+public:
+  using value_type = T;
+
+  static constexpr uint64_t MAGIC = 0x42524f4144524e47; // "BROADRNG"
+  static constexpr size_t MASK = Capacity - 1;
+
+  // SeqLock slot: the version doubles as the sequence stamp. Writing item k
+  // moves the version to 2k+1 (odd = write in progress), then to 2k+2.
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> version;
+    T item;
+  };
+
+  // Registry entry for one consumer, padded to its own cache line
+  struct alignas(64) ConsumerSlot {
+    std::atomic<uint32_t> active;
+    std::atomic<uint64_t> cursor;   // Next sequence the consumer will read
+    std::atomic<uint64_t> overruns; // Items lost to being lapped
+  };
+
+  BroadcastRing() {
+    for (size_t i = 0; i < Capacity; i++) {
+      slots_[i].version.store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < MaxConsumers; i++) {
+      consumers_[i].active.store(0, std::memory_order_relaxed);
+      consumers_[i].cursor.store(0, std::memory_order_relaxed);
+      consumers_[i].overruns.store(0, std::memory_order_relaxed);
+    }
+    item_size_ = sizeof(T);
+    capacity_ = Capacity;
+    // Magic goes last so attachers never see a half-built ring
+    std::atomic_thread_fence(std::memory_order_release);
+    magic_ = MAGIC;
+  }
+
+  // Called by the feed-handler process: builds the ring inside a new segment
+  static BroadcastRing *create_in(SharedMemory &shm) {
+    if (shm.size() < sizeof(BroadcastRing))
+      throw std::runtime_error("Shared memory too small for BroadcastRing");
+    return new (shm.data()) BroadcastRing();
+  }
+
+  // Called by consumer processes: validates the layout of an existing ring
+  static BroadcastRing *attach_to(SharedMemory &shm) {
+    if (shm.size() < sizeof(BroadcastRing))
+      throw std::runtime_error("Shared memory too small for BroadcastRing");
+    auto *ring = std::launder(static_cast<BroadcastRing *>(shm.data()));
+    if (ring->magic_ != MAGIC || ring->capacity_ != Capacity ||
+        ring->item_size_ != sizeof(T)) {
+      throw std::runtime_error("Shared memory does not hold a matching ring");
+    }
+    return ring;
+  }
+
+  // Called by the producer: overwrites the oldest slot, never blocks
+  void publish(const T &item) {
+    uint64_t seq = published_.load(std::memory_order_relaxed);
+    Slot &slot = slots_[seq & MASK];
+
+    // SeqLock: set version to odd (write in progress)
+    slot.version.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&slot.item, &item, sizeof(T));
+
+    // SeqLock: set version to even (write complete)
+    slot.version.store(2 * seq + 2, std::memory_order_release);
+    published_.store(seq + 1, std::memory_order_release);
+  }
+
+  // Total number of items ever published
+  uint64_t published() const {
+    return published_.load(std::memory_order_acquire);
+  }
+
+  // Claims a registry entry starting at the current head, returns -1 if full
+  int register_consumer(uint64_t &start_cursor) {
+    for (size_t i = 0; i < MaxConsumers; i++) {
+      uint32_t expected = 0;
+      if (consumers_[i].active.compare_exchange_strong(
+              expected, 1, std::memory_order_acq_rel)) {
+        start_cursor = published();
+        consumers_[i].cursor.store(start_cursor, std::memory_order_relaxed);
+        consumers_[i].overruns.store(0, std::memory_order_relaxed);
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  void unregister_consumer(int id) {
+    consumers_[id].active.store(0, std::memory_order_release);
+  }
+
+  // Called by the producer's monitoring path (not the publish path): reports
+  // every registered consumer lagging more than max_lag items behind the head.
+  // Returns the number of slow consumers found.
+  template <typename F>
+  size_t check_consumers(uint64_t max_lag, F &&on_slow) const {
+    uint64_t head = published();
+    size_t slow = 0;
+    for (size_t i = 0; i < MaxConsumers; i++) {
+      const ConsumerSlot &c = consumers_[i];
+      if (!c.active.load(std::memory_order_acquire))
+        continue;
+      uint64_t cursor = c.cursor.load(std::memory_order_relaxed);
+      uint64_t lag = head > cursor ? head - cursor : 0;
+      if (lag > max_lag) {
+        on_slow(static_cast<int>(i), lag,
+                c.overruns.load(std::memory_order_relaxed));
+        slow++;
+      }
+    }
+    return slow;
+  }
+
+  // Reads item seq. Either returns a clean copy, Empty if it has not been
+  // published yet, or Overrun if the producer lapped the reader.
+  BroadcastReadStatus read(uint64_t seq, T &out) const {
+    if (seq >= published_.load(std::memory_order_acquire)) {
+      return BroadcastReadStatus::Empty;
+    }
+
+    const Slot &slot = slots_[seq & MASK];
+    uint64_t expected = 2 * seq + 2;
+
+    uint64_t v1 = slot.version.load(std::memory_order_acquire);
+    if (v1 != expected) {
+      return BroadcastReadStatus::Overrun; // Slot already reused
+    }
+
+    std::memcpy(&out, &slot.item, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    uint64_t v2 = slot.version.load(std::memory_order_relaxed);
+    if (v1 != v2) {
+      return BroadcastReadStatus::Overrun; // Overwritten during the copy
+    }
+    return BroadcastReadStatus::Ok;
+  }
+
+  ConsumerSlot &consumer(int id) { return consumers_[id]; }
+
+private:
+  uint64_t magic_ = 0;
+  uint64_t capacity_ = 0;
+  uint64_t item_size_ = 0;
+
+  alignas(64) std::atomic<uint64_t> published_{0};
+  alignas(64) ConsumerSlot consumers_[MaxConsumers];
+  Slot slots_[Capacity];
+};
+
+// A consumer's private view of a BroadcastRing. The cursor lives in this
+// process and is mirrored into the consumer's own registry line so the
+// producer can spot slow consumers.
+template <typename Ring> class BroadcastReader {
+public:
+  explicit BroadcastReader(Ring &ring) : ring_(&ring) {
+    id_ = ring_->register_consumer(next_);
+    if (id_ < 0)
+      throw std::runtime_error("BroadcastRing has no free consumer slots");
+  }
+
+  BroadcastReader(const BroadcastReader &) = delete;
+  BroadcastReader &operator=(const BroadcastReader &) = delete;
+
+  ~BroadcastReader() { ring_->unregister_consumer(id_); }
+
+  // Copies the next item into out. On Overrun the cursor jumps forward to the
+  // oldest item still in the ring and lost() grows by the skipped count.
+  BroadcastReadStatus read(typename Ring::value_type &out) {
+    BroadcastReadStatus status = ring_->read(next_, out);
+    if (status == BroadcastReadStatus::Ok) {
+      next_++;
+      ring_->consumer(id_).cursor.store(next_, std::memory_order_relaxed);
+    } else if (status == BroadcastReadStatus::Overrun) {
+      uint64_t head = ring_->published();
+      // Leave one slot of headroom: the slot at head - Capacity may be the
+      // one the producer is currently rewriting
+      uint64_t oldest = head > Ring::MASK ? head - Ring::MASK : 0;
+      uint64_t resume = oldest > next_ ? oldest : next_ + 1;
+      lost_ += resume - next_;
+      ring_->consumer(id_).overruns.fetch_add(resume - next_,
+                                              std::memory_order_relaxed);
+      next_ = resume;
+      ring_->consumer(id_).cursor.store(next_, std::memory_order_relaxed);
+    }
+    return status;
+  }
+
+  uint64_t cursor() const { return next_; }
+  uint64_t lost() const { return lost_; }
+  int id() const { return id_; }
+
+private:
+  Ring *ring_;
+  int id_ = -1;
+  uint64_t next_ = 0;
+  uint64_t lost_ = 0;
+};
+
+} // namespace core
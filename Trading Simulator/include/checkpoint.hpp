@@ -0,0 +1,341 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace core {
+
+// Serialises into a checkpoint slot. Writes past the end are dropped and
+// mark the checkpoint as overflowed instead of throwing, so the strategy
+// thread can simply skip it.
+class CheckpointWriter {
+public:
+  explicit CheckpointWriter(std::span<std::byte> out) : out_(out) {}
+
+  void put_bytes(const void *data, size_t bytes) {
+    if (bytes > out_.size() - size_) {
+      overflow_ = true;
+      return;
+    }
+    std::memcpy(out_.data() + size_, data, bytes);
+    size_ += bytes;
+  }
+
+  template <typename T> void put(const T &value) {
+    put_bytes(&value, sizeof(T));
+  }
+
+  // Overwrites a value put earlier at offset, e.g. a length prefix
+  template <typename T> void patch(size_t offset, const T &value) {
+    if (offset + sizeof(T) <= size_)
+      std::memcpy(out_.data() + offset, &value, sizeof(T));
+  }
+
+  size_t size() const { return size_; }
+  bool overflow() const { return overflow_; }
+
+private:
+  std::span<std::byte> out_;
+  size_t size_ = 0;
+  bool overflow_ = false;
+};
+
+// Reads back what a CheckpointWriter wrote; false once the data runs out
+class CheckpointReader {
+public:
+  explicit CheckpointReader(std::span<const std::byte> in) : in_(in) {}
+
+  bool get_bytes(void *data, size_t bytes) {
+    if (bytes > remaining())
+      return false;
+    std::memcpy(data, in_.data() + pos_, bytes);
+    pos_ += bytes;
+    return true;
+  }
+
+  template <typename T> bool get(T &value) {
+    return get_bytes(&value, sizeof(T));
+  }
+
+  // The next bytes as a reader of their own
+  std::optional<CheckpointReader> sub(size_t bytes) {
+    if (bytes > remaining())
+      return std::nullopt;
+    CheckpointReader reader(in_.subspan(pos_, bytes));
+    pos_ += bytes;
+    return reader;
+  }
+
+  size_t remaining() const { return in_.size() - pos_; }
+
+private:
+  std::span<const std::byte> in_;
+  size_t pos_ = 0;
+};
+
+// A checkpoint file: a header page and two data slots, mapped into memory.
+// A checkpoint is written into the slot not holding the newest one, synced,
+// and only then made current by its slot header (generation, sequence,
+// size, checksum), so a crash mid-write leaves the previous checkpoint
+// intact. The checksum catches a header that reached disk before its data.
+class CheckpointFile {
+public:
+  struct Snapshot {
+    uint64_t sequence; // Last tick applied to the saved state
+    std::span<const std::byte> data;
+  };
+
+  // Opens path, or creates it with two slots of slot_bytes. An existing
+  // file keeps its own slot size.
+  CheckpointFile(const std::string &path, size_t slot_bytes) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+      throw std::runtime_error("Failed to open checkpoint " + path);
+
+    FileHeader existing{};
+    bool valid = pread(fd, &existing, sizeof(existing), 0) ==
+                     static_cast<ssize_t>(sizeof(existing)) &&
+                 existing.magic == MAGIC && existing.slot_bytes % PAGE == 0;
+    slot_bytes_ =
+        valid ? existing.slot_bytes : (slot_bytes + PAGE - 1) / PAGE * PAGE;
+    size_ = PAGE + 2 * slot_bytes_;
+
+    struct stat st {};
+    if (fstat(fd, &st) < 0 ||
+        (static_cast<size_t>(st.st_size) < size_ &&
+         ftruncate(fd, static_cast<off_t>(size_)) < 0)) {
+      close(fd);
+      throw std::runtime_error("Failed to size checkpoint " + path);
+    }
+    void *addr =
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+      throw std::runtime_error("Failed to map checkpoint " + path);
+    base_ = static_cast<std::byte *>(addr);
+
+    if (!valid) {
+      FileHeader fresh{};
+      fresh.magic = MAGIC;
+      fresh.slot_bytes = slot_bytes_;
+      std::memcpy(base_, &fresh, sizeof(fresh));
+      msync(base_, PAGE, MS_SYNC);
+    }
+    newest_ = find_newest();
+  }
+
+  CheckpointFile(const CheckpointFile &) = delete;
+  CheckpointFile &operator=(const CheckpointFile &) = delete;
+
+  ~CheckpointFile() { munmap(base_, size_); }
+
+  size_t slot_bytes() const { return slot_bytes_; }
+
+  // The newest checkpoint whose data matches its checksum
+  std::optional<Snapshot> latest() const {
+    if (newest_ < 0)
+      return std::nullopt;
+    const SlotHeader &h = header().slots[newest_];
+    return Snapshot{h.sequence, {data(newest_), h.bytes}};
+  }
+
+  // Where the next checkpoint goes: never the newest valid one
+  std::span<std::byte> slot_for_write() {
+    return {data(write_slot()), slot_bytes_};
+  }
+
+  // Syncs the bytes written to slot_for_write() and makes them current
+  void commit(size_t bytes, uint64_t sequence) {
+    int slot = write_slot();
+    SlotHeader h;
+    h.generation = newest_ < 0 ? 1 : header().slots[newest_].generation + 1;
+    h.sequence = sequence;
+    h.bytes = bytes;
+    h.checksum = checksum(data(slot), bytes);
+    msync(data(slot), (bytes + PAGE - 1) / PAGE * PAGE, MS_SYNC);
+    std::memcpy(&header().slots[slot], &h, sizeof(h));
+    msync(base_, PAGE, MS_SYNC);
+    newest_ = slot;
+  }
+
+private:
+  static constexpr uint64_t MAGIC = 0x31544B4348545348; // "HSTHCKT1"
+  static constexpr size_t PAGE = 4096;
+
+  struct SlotHeader {
+    uint64_t generation; // 0 = never written
+    uint64_t sequence;
+    uint64_t bytes;
+    uint64_t checksum;
+  };
+
+  struct FileHeader {
+    uint64_t magic;
+    uint64_t slot_bytes;
+    SlotHeader slots[2];
+  };
+
+  // 8 bytes per step (FNV-1a style), then the tail
+  static uint64_t checksum(const std::byte *p, size_t bytes) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+      uint64_t word;
+      std::memcpy(&word, p + i, 8);
+      h = (h ^ word) * 0x100000001b3ull;
+    }
+    for (; i < bytes; i++)
+      h = (h ^ static_cast<uint64_t>(p[i])) * 0x100000001b3ull;
+    return h;
+  }
+
+  FileHeader &header() const { return *reinterpret_cast<FileHeader *>(base_); }
+  std::byte *data(int slot) const {
+    return base_ + PAGE + static_cast<size_t>(slot) * slot_bytes_;
+  }
+
+  bool slot_valid(int slot) const {
+    const SlotHeader &h = header().slots[slot];
+    return h.generation != 0 && h.bytes <= slot_bytes_ &&
+           checksum(data(slot), h.bytes) == h.checksum;
+  }
+
+  // Verified once on open; afterwards the slot last committed
+  int find_newest() const {
+    const FileHeader &f = header();
+    int order[2] = {0, 1};
+    if (f.slots[1].generation > f.slots[0].generation)
+      std::swap(order[0], order[1]);
+    for (int slot : order) {
+      if (slot_valid(slot))
+        return slot;
+    }
+    return -1;
+  }
+
+  int write_slot() const { return newest_ < 0 ? 0 : 1 - newest_; }
+
+  std::byte *base_ = nullptr;
+  size_t size_ = 0;
+  size_t slot_bytes_ = 0;
+  int newest_ = -1;
+};
+
+// Periodic checkpoints off the strategy thread's critical path. The
+// strategy thread serialises its state into a staging buffer of its own
+// (plain stores: no syscalls, and no faults on file pages that writeback
+// has write-protected) and hands it over; a background thread copies it
+// into the mapped slot, checksums, syncs and commits it. While a checkpoint
+// is still being flushed, begin() returns an empty span and that checkpoint
+// is skipped, so a slow disk costs checkpoint frequency, never strategy
+// time.
+class Checkpointer {
+public:
+  Checkpointer(const std::string &path, size_t slot_bytes)
+      : file_(path, slot_bytes),
+        staging_(static_cast<std::byte *>(huge_allocate(file_.slot_bytes()))) {
+    thread_ = std::thread([this] { run(); });
+  }
+
+  Checkpointer(const Checkpointer &) = delete;
+  Checkpointer &operator=(const Checkpointer &) = delete;
+
+  ~Checkpointer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    huge_deallocate(staging_, file_.slot_bytes());
+  }
+
+  // Read at startup, before the first checkpoint is submitted
+  std::optional<CheckpointFile::Snapshot> latest() const {
+    return file_.latest();
+  }
+
+  // Strategy thread: where to serialise, or empty if busy
+  std::span<std::byte> begin() {
+    if (busy_.load(std::memory_order_acquire))
+      return {};
+    return {staging_, file_.slot_bytes()};
+  }
+
+  // Strategy thread: bytes from begin() hold the state after tick sequence
+  void submit(size_t bytes, uint64_t sequence) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_bytes_ = bytes;
+      pending_sequence_ = sequence;
+      busy_.store(true, std::memory_order_release);
+    }
+    wake_.notify_one();
+  }
+
+  uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+  uint64_t last_sequence() const {
+    return last_sequence_.load(std::memory_order_relaxed);
+  }
+  uint64_t last_flush_ns() const {
+    return last_flush_ns_.load(std::memory_order_relaxed);
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [&] { return stopping_ || busy_.load(); });
+      if (busy_.load()) {
+        size_t bytes = pending_bytes_;
+        uint64_t sequence = pending_sequence_;
+        lock.unlock();
+        auto start = std::chrono::steady_clock::now();
+        std::memcpy(file_.slot_for_write().data(), staging_, bytes);
+        file_.commit(bytes, sequence);
+        last_flush_ns_.store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count(),
+            std::memory_order_relaxed);
+        last_sequence_.store(sequence, std::memory_order_relaxed);
+        written_.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+        busy_.store(false, std::memory_order_release);
+      }
+      if (stopping_)
+        return;
+    }
+  }
+
+  CheckpointFile file_;
+  std::byte *staging_; // Owned by the flusher while busy_
+  std::atomic<bool> busy_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  size_t pending_bytes_ = 0;
+  uint64_t pending_sequence_ = 0;
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> last_sequence_{0};
+  std::atomic<uint64_t> last_flush_ns_{0};
+  std::thread thread_;
+};
+
+} // namespace core
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// Append-only array grown in chunks that each fill one 2 MB huge page.
+// Elements never move, so references stay valid, and memory tracks the
+// number of elements actually used rather than a worst-case reservation.
+// Indexing is a shift and a mask.
+template <typename T> class ChunkedVector {
+  static_assert(alignof(T) <= 64, "Chunks are 64-byte aligned");
+
+  static constexpr size_t floor_log2(size_t n) {
+    size_t bits = 0;
+    while ((n >> (bits + 1)) != 0)
+      bits++;
+    return bits;
+  }
+
+  // huge_allocate() keeps a 64-byte header, leave room for it
+  static constexpr size_t FIT = (HUGE_PAGE_2M - 64) / sizeof(T);
+
+public:
+  static constexpr size_t SHIFT = FIT == 0 ? 0 : floor_log2(FIT);
+  static constexpr size_t CHUNK = size_t{1} << SHIFT;
+  static constexpr size_t MASK = CHUNK - 1;
+
+  // Reserving the chunk directory up front keeps appends allocation-free
+  // except when a new chunk is started
+  explicit ChunkedVector(size_t expected_max = CHUNK) {
+    chunks_.reserve((expected_max + CHUNK - 1) / CHUNK);
+  }
+
+  ChunkedVector(const ChunkedVector &) = delete;
+  ChunkedVector &operator=(const ChunkedVector &) = delete;
+
+  ~ChunkedVector() {
+    for (size_t i = 0; i < size_; i++) {
+      (*this)[i].~T();
+    }
+    for (T *chunk : chunks_) {
+      huge_deallocate(chunk, CHUNK * sizeof(T));
+    }
+  }
+
+  T &operator[](size_t i) { return chunks_[i >> SHIFT][i & MASK]; }
+  const T &operator[](size_t i) const { return chunks_[i >> SHIFT][i & MASK]; }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if ((size_ & MASK) == 0 && (size_ >> SHIFT) == chunks_.size()) {
+      chunks_.push_back(static_cast<T *>(huge_allocate(CHUNK * sizeof(T))));
+    }
+    T *slot = &chunks_[size_ >> SHIFT][size_ & MASK];
+    new (slot) T(std::forward<Args>(args)...);
+    size_++;
+    return *slot;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  std::vector<T *> chunks_;
+  size_t size_ = 0;
+};
+
+} // namespace core
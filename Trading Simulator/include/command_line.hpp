@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+namespace core {
+
+// Minimal "--name=value" / "--flag" argument reader for the executables
+class CommandLine {
+public:
+  CommandLine(int argc, char **argv) : argc_(argc), argv_(argv) {}
+
+  bool has(std::string_view name) const { return find(name) != nullptr; }
+
+  std::string get(std::string_view name, const std::string &fallback) const {
+    const char *value = find(name);
+    return (value && *value) ? std::string(value) : fallback;
+  }
+
+  long get_int(std::string_view name, long fallback) const {
+    const char *value = find(name);
+    return (value && *value) ? std::strtol(value, nullptr, 10) : fallback;
+  }
+
+  double get_double(std::string_view name, double fallback) const {
+    const char *value = find(name);
+    return (value && *value) ? std::strtod(value, nullptr) : fallback;
+  }
+
+private:
+  // Returns the text after "--name=" ("" for a bare "--name"), or nullptr
+  const char *find(std::string_view name) const {
+    for (int i = 1; i < argc_; i++) {
+      std::string_view arg(argv_[i]);
+      if (arg.size() < 2 || arg.substr(0, 2) != "--")
+        continue;
+      arg.remove_prefix(2);
+      if (arg == name)
+        return argv_[i] + 2 + name.size();
+      if (arg.size() > name.size() && arg.substr(0, name.size()) == name &&
+          arg[name.size()] == '=')
+        return argv_[i] + 2 + name.size() + 1;
+    }
+    return nullptr;
+  }
+
+  int argc_;
+  char **argv_;
+};
+
+} // namespace core
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// Lock-free Multi-Producer Single-Consumer fan-in built from one SPSCQueue per
+// producer. Producers never share a cache line, so adding feed-handler threads
+// (partitions, A/B lines) adds no contention on the write path.
+//
+// The consumer polls the queues round-robin, taking a bounded burst from each
+// one. The burst keeps reads contiguous within a queue (cache friendly) and
+// the bound plus a rotating start position keeps a busy producer from
+// starving the others (fair).
+template <typename T, size_t Capacity> class FanInQueue {
+public:
+  using Queue = SPSCQueue<T, Capacity>;
+
+  explicit FanInQueue(size_t producers)
+      : queues_(std::make_unique<Queue[]>(producers)),
+        num_queues_(producers) {
+    if (producers == 0)
+      throw std::invalid_argument("FanInQueue needs at least one producer");
+  }
+
+  // Called once per producer thread: the queue it alone writes to
+  Queue &producer(size_t index) { return queues_[index]; }
+
+  size_t producers() const { return num_queues_; }
+
+  // Called by the Strategy Thread: hands up to `burst` items from each queue
+  // to handle(const T&), visiting every queue once. Returns the item count.
+  template <typename F> size_t drain(F &&handle, size_t burst = 32) {
+    size_t handled = 0;
+    size_t index = start_;
+    for (size_t visited = 0; visited < num_queues_; visited++) {
+      Queue &queue = queues_[index];
+      auto items = queue.front_n(burst);
+      for (const T &item : items) {
+        handle(item);
+      }
+      queue.pop_n(items.size());
+      handled += items.size();
+
+      if (++index == num_queues_)
+        index = 0;
+    }
+    // Next drain starts one queue later, so no producer is always first
+    if (++start_ == num_queues_)
+      start_ = 0;
+    return handled;
+  }
+
+  // Approximate items waiting across all producers (metrics only)
+  size_t size_approx() const {
+    size_t total = 0;
+    for (size_t i = 0; i < num_queues_; i++) {
+      total += queues_[i].size_approx();
+    }
+    return total;
+  }
+
+private:
+  std::unique_ptr<Queue[]> queues_;
+  size_t num_queues_;
+  size_t start_ = 0; // Consumer-owned
+};
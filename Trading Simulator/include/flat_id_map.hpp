@@ -0,0 +1,95 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+
+// Order ID -> dense index map for order books. Open addressing with linear
+// probing over 16-byte slots, sized up front for max_entries at a load
+// factor <= 0.5, so it never rehashes or allocates after construction.
+// Erase shifts the following run back instead of leaving tombstones, so
+// probe lengths stay short under constant add/cancel churn.
+class FlatIdMap {
+public:
+  static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+  explicit FlatIdMap(size_t max_entries)
+      : slots_(std::bit_ceil(max_entries * 2)),
+        mask_(slots_.size() - 1),
+        shift_(64 - static_cast<unsigned>(std::countr_zero(slots_.size()))),
+        max_entries_(max_entries) {}
+
+  // False if key is already present or the map is full
+  bool insert(uint64_t key, uint32_t value) {
+    if (size_ == max_entries_)
+      return false;
+    size_t pos = home(key);
+    while (slots_[pos].key != EMPTY) {
+      if (slots_[pos].key == key)
+        return false;
+      pos = (pos + 1) & mask_;
+    }
+    slots_[pos] = {key, value};
+    size_++;
+    return true;
+  }
+
+  uint32_t find(uint64_t key) const {
+    size_t pos = home(key);
+    while (slots_[pos].key != EMPTY) {
+      if (slots_[pos].key == key)
+        return slots_[pos].value;
+      pos = (pos + 1) & mask_;
+    }
+    return NOT_FOUND;
+  }
+
+  bool erase(uint64_t key) {
+    size_t hole = home(key);
+    while (slots_[hole].key != key) {
+      if (slots_[hole].key == EMPTY)
+        return false;
+      hole = (hole + 1) & mask_;
+    }
+    // Backward shift: pull later entries of the run into the hole unless
+    // that would move them before their home slot
+    for (size_t pos = (hole + 1) & mask_; slots_[pos].key != EMPTY;
+         pos = (pos + 1) & mask_) {
+      size_t want = home(slots_[pos].key);
+      if (((pos - want) & mask_) >= ((pos - hole) & mask_)) {
+        slots_[hole] = slots_[pos];
+        hole = pos;
+      }
+    }
+    slots_[hole].key = EMPTY;
+    size_--;
+    return true;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+
+  struct Slot {
+    uint64_t key = EMPTY;
+    uint32_t value = 0;
+  };
+
+  // Fibonacci hashing: the top bits of key * 2^64/phi
+  size_t home(uint64_t key) const {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+  }
+
+  std::vector<Slot, HugePageAllocator<Slot>> slots_;
+  size_t mask_;
+  unsigned shift_;
+  size_t max_entries_;
+  size_t size_ = 0;
+};
+
+} // namespace core
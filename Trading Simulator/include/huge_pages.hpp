@@ -0,0 +1,238 @@
+#pragma once
+
+#include "command_line.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+namespace core {
+
+// Huge-page allocation layer for the large, randomly accessed structures
+// (RingBuffer, SPSCQueue storage, strategy state). One 2 MB page covers what
+// would otherwise take 512 TLB entries.
+//
+// Each mapping tries, in order: explicit huge pages (hugetlbfs via
+// MAP_HUGETLB on Linux, 1 GB then 2 MB pages; superpages on macOS), then
+// transparent huge pages (THP, via madvise), then regular pages. Small
+// requests skip all of this and use operator new, since a huge page would
+// be mostly empty.
+
+constexpr size_t HUGE_PAGE_2M = size_t{2} << 20;
+constexpr size_t HUGE_PAGE_1G = size_t{1} << 30;
+constexpr size_t HUGE_PAGE_MIN_BYTES = size_t{256} << 10;
+
+enum class PageBacking { HugeTlb1G, HugeTlb2M, TransparentHuge, Regular };
+
+inline const char *backing_name(PageBacking backing) {
+  switch (backing) {
+  case PageBacking::HugeTlb1G:
+    return "1GB hugetlb";
+  case PageBacking::HugeTlb2M:
+    return "2MB hugetlb";
+  case PageBacking::TransparentHuge:
+    return "THP";
+  case PageBacking::Regular:
+    return "4KB";
+  }
+  return "?";
+}
+
+// Process-wide settings. Set them in main() before anything is allocated:
+// deallocation recomputes the mapping size from these.
+struct HugePageOptions {
+  bool enabled = true;
+  bool allow_1g = false; // Use 1 GB pages for allocations of 512 MB or more
+  int numa_node = -1;    // Bind mappings to this node (-1 = no binding)
+};
+
+inline HugePageOptions &huge_page_options() {
+  static HugePageOptions options;
+  return options;
+}
+
+// Applies --hugepages=off, --huge-1g and --numa-node=N from the command line
+inline void configure_huge_pages(const CommandLine &args) {
+  HugePageOptions &options = huge_page_options();
+  options.enabled = args.get("hugepages", "on") != "off";
+  options.allow_1g = args.has("huge-1g");
+  options.numa_node = static_cast<int>(args.get_int("numa-node", -1));
+}
+
+// Bytes currently mapped per backing, for the startup report
+inline std::atomic<size_t> &huge_page_bytes(PageBacking backing) {
+  static std::atomic<size_t> bytes[4];
+  return bytes[static_cast<int>(backing)];
+}
+
+// One-line summary of mapped bytes per backing, e.g. "2MB hugetlb: 4 MB"
+inline std::string huge_page_summary() {
+  std::string summary;
+  for (PageBacking backing :
+       {PageBacking::HugeTlb1G, PageBacking::HugeTlb2M,
+        PageBacking::TransparentHuge, PageBacking::Regular}) {
+    size_t bytes = huge_page_bytes(backing).load(std::memory_order_relaxed);
+    if (bytes == 0)
+      continue;
+    if (!summary.empty())
+      summary += ", ";
+    summary += std::string(backing_name(backing)) + ": " +
+               std::to_string(bytes >> 20) + " MB";
+  }
+  return summary.empty() ? "nothing mapped" : summary;
+}
+
+inline size_t huge_mapping_size(size_t bytes) {
+  const HugePageOptions &options = huge_page_options();
+  size_t page = (options.allow_1g && bytes >= HUGE_PAGE_1G / 2)
+                    ? HUGE_PAGE_1G
+                    : HUGE_PAGE_2M;
+  return (bytes + page - 1) & ~(page - 1);
+}
+
+inline void bind_numa_node(void *addr, size_t len, int node) {
+#ifdef __linux__
+  if (node < 0 || node >= 64)
+    return;
+  unsigned long nodemask = 1ul << node;
+  const int MPOL_BIND = 2;
+  const unsigned MPOL_MF_MOVE = 2;
+  // Best effort: a failed bind (no NUMA, no permission) still leaves memory
+  syscall(SYS_mbind, addr, len, MPOL_BIND, &nodemask, 64, MPOL_MF_MOVE);
+#else
+  (void)addr;
+  (void)len;
+  (void)node;
+#endif
+}
+
+// Maps len bytes (a multiple of huge_mapping_size) and reports the backing
+inline void *huge_map(size_t len, PageBacking &backing) {
+  const HugePageOptions &options = huge_page_options();
+  void *addr = MAP_FAILED;
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+  if (options.enabled) {
+    // No 1 GB pages reserved still leaves 2 MB ones, which fit any length
+    // huge_mapping_size returns
+    for (PageBacking tlb : {PageBacking::HugeTlb1G, PageBacking::HugeTlb2M}) {
+      bool one_gig = tlb == PageBacking::HugeTlb1G;
+      if (one_gig && !(options.allow_1g && len % HUGE_PAGE_1G == 0))
+        continue;
+      int size_flag = one_gig ? (30 << 26) : (21 << 26); // MAP_HUGE_1GB / 2MB
+      addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1,
+                  0);
+      if (addr != MAP_FAILED) {
+        backing = tlb;
+        break;
+      }
+    }
+  }
+#elif defined(__APPLE__) && defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+  if (options.enabled) {
+    addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON,
+                VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+    if (addr != MAP_FAILED)
+      backing = PageBacking::HugeTlb2M;
+  }
+#endif
+
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+      throw std::bad_alloc();
+    backing = PageBacking::Regular;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (options.enabled && madvise(addr, len, MADV_HUGEPAGE) == 0)
+      backing = PageBacking::TransparentHuge;
+#endif
+  }
+
+  bind_numa_node(addr, len, options.numa_node);
+  huge_page_bytes(backing).fetch_add(len, std::memory_order_relaxed);
+  return addr;
+}
+
+inline void huge_unmap(void *addr, size_t len, PageBacking backing) {
+  huge_page_bytes(backing).fetch_sub(len, std::memory_order_relaxed);
+  munmap(addr, len);
+}
+
+// Allocates bytes on huge pages, or with operator new when too small to
+// benefit. The backing is recovered on free from a header in front of the
+// block, so the mapping size is the only thing recomputed.
+inline void *huge_allocate(size_t bytes) {
+  if (bytes < HUGE_PAGE_MIN_BYTES)
+    return ::operator new(bytes, std::align_val_t{64});
+
+  // One cache line in front of the block records how it was mapped
+  size_t len = huge_mapping_size(bytes + 64);
+  PageBacking backing;
+  auto *base = static_cast<std::byte *>(huge_map(len, backing));
+  *reinterpret_cast<PageBacking *>(base) = backing;
+  return base + 64;
+}
+
+inline void huge_deallocate(void *ptr, size_t bytes) {
+  if (bytes < HUGE_PAGE_MIN_BYTES) {
+    ::operator delete(ptr, std::align_val_t{64});
+    return;
+  }
+  auto *base = static_cast<std::byte *>(ptr) - 64;
+  huge_unmap(base, huge_mapping_size(bytes + 64),
+             *reinterpret_cast<PageBacking *>(base));
+}
+
+// Standard allocator for containers (e.g. SPSCQueue storage)
+template <typename T> struct HugePageAllocator {
+  using value_type = T;
+
+  HugePageAllocator() = default;
+  template <typename U> HugePageAllocator(const HugePageAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(huge_allocate(n * sizeof(T)));
+  }
+  void deallocate(T *ptr, size_t n) { huge_deallocate(ptr, n * sizeof(T)); }
+
+  template <typename U> bool operator==(const HugePageAllocator<U> &) const {
+    return true;
+  }
+};
+
+// unique_ptr for a single object placed on huge pages (e.g. the RingBuffer)
+template <typename T> struct HugePageDeleter {
+  void operator()(T *ptr) const {
+    ptr->~T();
+    huge_deallocate(ptr, sizeof(T));
+  }
+};
+
+template <typename T> using HugePtr = std::unique_ptr<T, HugePageDeleter<T>>;
+
+template <typename T, typename... Args> HugePtr<T> make_huge(Args &&...args) {
+  static_assert(alignof(T) <= 64, "make_huge supports up to 64-byte alignment");
+  void *mem = huge_allocate(sizeof(T));
+  try {
+    return HugePtr<T>(new (mem) T(std::forward<Args>(args)...));
+  } catch (...) {
+    huge_deallocate(mem, sizeof(T));
+    throw;
+  }
+}
+
+} // namespace core
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+
+// Fixed pool of T addressed by 32-bit index, so pooled objects can link to
+// each other in half the space of pointers. Free slots are a LIFO stack:
+// the most recently freed (cache-warm) slot is reused first. Released slots
+// keep their contents; owners mark them dead themselves if they scan.
+template <typename T> class IndexPool {
+public:
+  explicit IndexPool(uint32_t capacity) : items_(capacity) {
+    free_.reserve(capacity);
+    for (uint32_t i = capacity; i-- > 0;)
+      free_.push_back(i);
+  }
+
+  bool full() const { return free_.empty(); }
+  size_t live() const { return items_.size() - free_.size(); }
+  size_t capacity() const { return items_.size(); }
+
+  // Caller checks full() first
+  uint32_t acquire() {
+    uint32_t index = free_.back();
+    free_.pop_back();
+    return index;
+  }
+
+  void release(uint32_t index) { free_.push_back(index); }
+
+  T &operator[](uint32_t index) { return items_[index]; }
+  const T &operator[](uint32_t index) const { return items_[index]; }
+
+private:
+  std::vector<T, HugePageAllocator<T>> items_;
+  std::vector<uint32_t> free_;
+};
+
+} // namespace core
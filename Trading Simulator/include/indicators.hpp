@@ -0,0 +1,267 @@
+#pragma once
+
+#include "bollinger_simd.hpp"
+#include "flat_id_map.hpp"
+#include "huge_pages.hpp"
+#include "protocol.hpp"
+#include "rolling_stats.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace strategy {
+
+enum class IndicatorKind : uint8_t {
+  Sma,  // Rolling window mean; std_dev and zscore derive from it
+  Ema,  // Exponential moving average, alpha = 2 / (period + 1)
+  Vwap, // Session volume-weighted average price
+};
+
+// A declared indicator: what it is and where its state sits in each
+// symbol's block. Strategies keep these from construction.
+struct Indicator {
+  IndicatorKind kind;
+  uint32_t period;
+  uint32_t offset;
+  double alpha; // EMA smoothing factor
+};
+
+// Per-symbol indicators shared by every strategy of a StrategySet.
+// Strategies declare what they need at construction; identical
+// declarations share one indicator, so it is updated once per tick however
+// many strategies read it. on_tick only advances the incremental state
+// (window sums, EMA, VWAP sums); values that need a sqrt or a division
+// (standard deviation, z-score, VWAP) are computed when a strategy reads
+// them, and the standard deviation is kept for later readers of the same
+// tick. Each symbol's state for all indicators is one contiguous block,
+// allocated on first sight. Single-threaded.
+class IndicatorEngine {
+public:
+  explicit IndicatorEngine(size_t max_symbols) : max_symbols_(max_symbols) {}
+
+  IndicatorEngine(const IndicatorEngine &) = delete;
+  IndicatorEngine &operator=(const IndicatorEngine &) = delete;
+
+  ~IndicatorEngine() {
+    for (std::byte *chunk : chunks_)
+      core::huge_deallocate(chunk, chunk_bytes());
+  }
+
+  // The existing indicator if another strategy declared the same one.
+  // Declarations must come before the first tick.
+  Indicator declare(IndicatorKind kind, uint32_t period = 0) {
+    if (kind == IndicatorKind::Vwap)
+      period = 0;
+    else if (period == 0)
+      throw std::runtime_error("Indicator period must be positive");
+    for (const Indicator &ind : indicators_) {
+      if (ind.kind == kind && ind.period == period)
+        return ind;
+    }
+    if (!blocks_.empty())
+      throw std::runtime_error("Indicators must be declared before ticks");
+    Indicator ind{kind, period, static_cast<uint32_t>(stride_),
+                  2.0 / (period + 1.0)};
+    stride_ += state_bytes(ind);
+    indicators_.push_back(ind);
+    return ind;
+  }
+
+  Indicator sma(uint32_t period) { return declare(IndicatorKind::Sma, period); }
+  Indicator ema(uint32_t period) { return declare(IndicatorKind::Ema, period); }
+  Indicator vwap() { return declare(IndicatorKind::Vwap); }
+
+  // Longest declared period: history that fills every window
+  uint32_t max_period() const {
+    uint32_t period = 0;
+    for (const Indicator &ind : indicators_)
+      period = std::max(period, ind.period);
+    return period;
+  }
+
+  bool empty() const { return indicators_.empty(); }
+  size_t size() const { return indicators_.size(); }
+  size_t symbols() const { return blocks_.size(); }
+
+  // Advances every indicator of the tick's symbol. Reads below refer to
+  // that symbol until the next call.
+  void on_tick(const protocol::TickPacket &tick) {
+    std::byte *block = block_for(core::symbol_key(tick.symbol));
+    Header &header = at<Header>(block, 0);
+    header.ticks++;
+    header.price = tick.price;
+    for (const Indicator &ind : indicators_) {
+      switch (ind.kind) {
+      case IndicatorKind::Sma:
+        update_sma(block, ind, tick.price);
+        break;
+      case IndicatorKind::Ema: {
+        EmaState &ema = at<EmaState>(block, ind.offset);
+        ema.value = ema.seeded
+                        ? ema.value + ind.alpha * (tick.price - ema.value)
+                        : tick.price;
+        ema.seeded = 1;
+        break;
+      }
+      case IndicatorKind::Vwap: {
+        VwapState &vwap = at<VwapState>(block, ind.offset);
+        vwap.notional += tick.price * tick.quantity;
+        vwap.volume += tick.quantity;
+        break;
+      }
+      }
+    }
+    current_ = block;
+  }
+
+  // Last price of the current symbol
+  double price() const { return at<Header>(current_, 0).price; }
+
+  // SMA: window full; EMA: one price seen; VWAP: any volume traded
+  bool ready(const Indicator &ind) const {
+    switch (ind.kind) {
+    case IndicatorKind::Sma:
+      return at<SmaState>(current_, ind.offset).count == ind.period;
+    case IndicatorKind::Ema:
+      return at<EmaState>(current_, ind.offset).seeded != 0;
+    case IndicatorKind::Vwap:
+      return at<VwapState>(current_, ind.offset).volume > 0.0;
+    }
+    return false;
+  }
+
+  // SMA mean, EMA value or VWAP (divided here, on read)
+  double value(const Indicator &ind) const {
+    switch (ind.kind) {
+    case IndicatorKind::Sma:
+      return at<SmaState>(current_, ind.offset).mean;
+    case IndicatorKind::Ema:
+      return at<EmaState>(current_, ind.offset).value;
+    case IndicatorKind::Vwap: {
+      const VwapState &vwap = at<VwapState>(current_, ind.offset);
+      return vwap.notional / vwap.volume;
+    }
+    }
+    return 0.0;
+  }
+
+  // Floored population standard deviation of an SMA window, as in
+  // bollinger_bands(); computed on the first read after each tick
+  double std_dev(const Indicator &sma) const {
+    SmaState &state = at<SmaState>(current_, sma.offset);
+    uint64_t ticks = at<Header>(current_, 0).ticks;
+    if (state.std_dev_tick != ticks) {
+      double mean;
+      bollinger_bands(state.mean, state.m2, sma.period, mean, state.std_dev);
+      state.std_dev_tick = ticks;
+    }
+    return state.std_dev;
+  }
+
+  // (price - SMA) / std_dev for the current symbol
+  double zscore(const Indicator &sma) const {
+    return (price() - value(sma)) / std_dev(sma);
+  }
+
+private:
+  struct Header {
+    uint64_t ticks; // Updates applied to this symbol
+    double price;
+  };
+
+  // Followed by the period prices of the window
+  struct SmaState {
+    double mean;
+    double mean_comp;
+    double m2;
+    uint32_t count; // Prices collected (warmup until == period)
+    uint32_t idx;   // Oldest price once the window is full
+    uint64_t std_dev_tick; // Header::ticks when std_dev was computed
+    double std_dev;
+  };
+
+  struct EmaState {
+    double value;
+    uint64_t seeded;
+  };
+
+  struct VwapState {
+    double notional;
+    double volume;
+  };
+
+  static size_t state_bytes(const Indicator &ind) {
+    switch (ind.kind) {
+    case IndicatorKind::Sma:
+      return sizeof(SmaState) + ind.period * sizeof(double);
+    case IndicatorKind::Ema:
+      return sizeof(EmaState);
+    case IndicatorKind::Vwap:
+      return sizeof(VwapState);
+    }
+    return 0;
+  }
+
+  template <typename T> static T &at(std::byte *block, size_t offset) {
+    return *reinterpret_cast<T *>(block + offset);
+  }
+
+  static void update_sma(std::byte *block, const Indicator &ind,
+                         double price) {
+    SmaState &s = at<SmaState>(block, ind.offset);
+    double *window =
+        reinterpret_cast<double *>(block + ind.offset + sizeof(SmaState));
+    if (s.count < ind.period) {
+      window[s.count++] = price;
+      rolling_add(s.mean, s.mean_comp, s.m2, price, s.count);
+      return;
+    }
+    double old_price = window[s.idx];
+    window[s.idx] = price;
+    rolling_replace(s.mean, s.mean_comp, s.m2, old_price, price, ind.period);
+    s.idx = s.idx + 1 == ind.period ? 0 : s.idx + 1;
+  }
+
+  // Whole blocks per 2 MB chunk, or one block per chunk if larger
+  size_t block_bytes() const { return (stride_ + 63) / 64 * 64; }
+  size_t blocks_per_chunk() const {
+    size_t fit = (core::HUGE_PAGE_2M - 64) / block_bytes();
+    return fit == 0 ? 1 : fit;
+  }
+  size_t chunk_bytes() const { return blocks_per_chunk() * block_bytes(); }
+
+  std::byte *block_for(uint32_t key) {
+    if (!ids_)
+      ids_.emplace(max_symbols_);
+    uint32_t id = ids_->find(key);
+    if (id != core::FlatIdMap::NOT_FOUND)
+      return blocks_[id];
+
+    if (blocks_.size() == max_symbols_)
+      throw std::length_error("IndicatorEngine is full");
+    size_t slot = blocks_.size() % blocks_per_chunk();
+    if (slot == 0)
+      chunks_.push_back(
+          static_cast<std::byte *>(core::huge_allocate(chunk_bytes())));
+    std::byte *block = chunks_.back() + slot * block_bytes();
+    std::memset(block, 0, block_bytes());
+    ids_->insert(key, static_cast<uint32_t>(blocks_.size()));
+    blocks_.push_back(block);
+    return block;
+  }
+
+  size_t max_symbols_;
+  std::vector<Indicator> indicators_;
+  size_t stride_ = sizeof(Header);
+  std::optional<core::FlatIdMap> ids_;
+  std::vector<std::byte *> blocks_; // By dense symbol ID
+  std::vector<std::byte *> chunks_;
+  std::byte *current_ = nullptr;
+};
+
+} // namespace strategy
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace core {
+
+// Runs on_signal(signum) on a thread of its own at the first SIGINT, so
+// shutdown code may lock, join threads and write files, none of which is
+// safe inside a signal handler. Call it at the top of main, before any
+// other thread starts: SIGINT is blocked in the caller and in every thread
+// it spawns from then on, so only the waiting thread ever takes it.
+template <typename OnSignal> void on_interrupt(OnSignal on_signal) {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  if (pthread_sigmask(SIG_BLOCK, &set, nullptr) != 0)
+    throw std::runtime_error("Failed to block SIGINT");
+  std::thread([set, on_signal = std::move(on_signal)]() mutable {
+    int signum = 0;
+    if (sigwait(&set, &signum) == 0)
+      on_signal(signum);
+  }).detach();
+}
+
+} // namespace core
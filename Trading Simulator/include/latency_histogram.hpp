@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace core {
+
+// Fixed-size latency histogram for long-running measurements: log2 buckets
+// split into 8 linear sub-buckets, so any value is within 12.5% of its
+// bucket's lower bound. Recording is an index computation and one counter
+// bump, with no allocation and no sorting. One thread records; any thread
+// may read (counters are relaxed atomics, so a report taken mid-run is
+// approximate but never torn).
+class LatencyHistogram {
+public:
+  static constexpr unsigned SUB_BITS = 3;
+  static constexpr size_t SUB = size_t{1} << SUB_BITS;
+  static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+  static constexpr size_t index_of(uint64_t ns) {
+    if (ns < SUB)
+      return static_cast<size_t>(ns);
+    unsigned msb = 63 - static_cast<unsigned>(std::countl_zero(ns));
+    unsigned shift = msb - SUB_BITS;
+    return (shift + 1) * SUB + ((ns >> shift) & (SUB - 1));
+  }
+
+  static constexpr uint64_t lower_bound(size_t index) {
+    if (index < SUB)
+      return index;
+    size_t shift = index / SUB - 1;
+    return static_cast<uint64_t>(SUB + index % SUB) << shift;
+  }
+
+  // Single writer
+  void record(uint64_t ns) {
+    bump(counts_[index_of(ns)], 1);
+    bump(total_, 1);
+    if (ns > max_.load(std::memory_order_relaxed))
+      max_.store(ns, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  // Lower bound of the bucket holding the p-th quantile (0 <= p <= 1)
+  uint64_t percentile(double p) const {
+    uint64_t total = count();
+    if (total == 0)
+      return 0;
+    uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen > rank)
+        return lower_bound(i);
+    }
+    return max();
+  }
+
+  // Same layout as bench::print_latency
+  void print(const std::string &label, FILE *out = stdout) const {
+    if (count() == 0) {
+      std::fprintf(out, "%-32s no samples\n", label.c_str());
+      return;
+    }
+    std::fprintf(out,
+                 "%-32s n=%llu p50=%llu p99=%llu p99.9=%llu max=%llu ns\n",
+                 label.c_str(), static_cast<unsigned long long>(count()),
+                 static_cast<unsigned long long>(percentile(0.50)),
+                 static_cast<unsigned long long>(percentile(0.99)),
+                 static_cast<unsigned long long>(percentile(0.999)),
+                 static_cast<unsigned long long>(max()));
+  }
+
+private:
+  static void bump(std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+  std::atomic<uint64_t> total_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+} // namespace core
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace core {
+
+// Catalogue of every message the binary logger can record. A record carries
+// only the LogId and its raw arguments; the text below is applied later by
+// the background formatter or by log_decoder. Append new entries at the end
+// so existing log files still decode.
+
+constexpr size_t MAX_LOG_ARGS = 6;
+
+enum class LogArg : uint8_t { None, Int, UInt, Double, Symbol };
+
+enum class LogId : uint16_t {
+  StrategyBuy,
+  StrategyTakeProfit,
+  StrategyStopLoss,
+  StrategyTimeStop,
+  GapDetected,
+  Recovered,
+  RecoveryExpired,
+  RecoveryBroken,
+  SimulatedDrop,
+  RetransmitMissing,
+  OrderRejected,
+  BookGap,
+  VwapBuy,
+  VwapExit,
+  CheckpointOverflow,
+  RecoverySkipped,
+  Count
+};
+
+struct LogFormat {
+  LogId id;
+  const char *color; // ANSI colour for terminals, or nullptr
+  const char *text;  // "{}" marks each argument in order
+  std::array<LogArg, MAX_LOG_ARGS> args;
+  bool error; // stderr instead of stdout
+
+  constexpr size_t arity() const {
+    size_t n = 0;
+    while (n < MAX_LOG_ARGS && args[n] != LogArg::None)
+      n++;
+    return n;
+  }
+
+  constexpr size_t placeholders() const {
+    size_t n = 0;
+    for (const char *c = text; *c != '\0'; c++) {
+      if (c[0] == '{' && c[1] == '}')
+        n++;
+    }
+    return n;
+  }
+};
+
+namespace log_arg {
+constexpr LogArg I = LogArg::Int;
+constexpr LogArg U = LogArg::UInt;
+constexpr LogArg D = LogArg::Double;
+constexpr LogArg S = LogArg::Symbol;
+} // namespace log_arg
+
+inline constexpr LogFormat LOG_FORMATS[] = {
+    {LogId::StrategyBuy, "\033[1;32m",
+     "[STRATEGY SMA{}] BUY 100 {} @ ${} (SMA: ${}, 2\u03c3: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D, log_arg::D},
+     false},
+    {LogId::StrategyTakeProfit, "\033[1;36m",
+     "[STRATEGY SMA{}] SELL (TAKE PROFIT) 100 {} @ ${} (Profit: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D},
+     false},
+    {LogId::StrategyStopLoss, "\033[1;31m",
+     "[STRATEGY SMA{}] SELL (STOP LOSS) 100 {} @ ${} (Loss: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D},
+     false},
+    {LogId::StrategyTimeStop, "\033[1;33m",
+     "[STRATEGY SMA{}] SELL (TIME STOP) 100 {} @ ${} (PnL: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D},
+     false},
+    {LogId::GapDetected, nullptr, "\n[!] GAP DETECTED! Expected {}, got {}",
+     {log_arg::U, log_arg::U},
+     false},
+    {LogId::Recovered, nullptr, "[TCP] Successfully RECOVERED seq={} price={}",
+     {log_arg::U, log_arg::D},
+     false},
+    {LogId::RecoveryExpired, nullptr,
+     "[TCP] Failed to recover seq={} (Expired from Publisher's RingBuffer)",
+     {log_arg::U},
+     true},
+    {LogId::RecoveryBroken, nullptr,
+     "[TCP] Connection broken while recovering seq={}",
+     {log_arg::U},
+     true},
+    {LogId::SimulatedDrop, nullptr,
+     "[SIMULATION] Dropped Broadcast for TICK seq={}",
+     {log_arg::U},
+     false},
+    {LogId::RetransmitMissing, nullptr,
+     "[TCP] Requested packet seq={} no longer in ring buffer!",
+     {log_arg::U},
+     true},
+    {LogId::OrderRejected, nullptr, "[ORDERS] Order {} rejected (reason {})",
+     {log_arg::U, log_arg::U},
+     true},
+    {LogId::BookGap, nullptr, "[BOOK] Book feed gap: expected {}, got {}",
+     {log_arg::U, log_arg::U},
+     true},
+    {LogId::VwapBuy, "\033[1;32m",
+     "[STRATEGY VWAP{}] BUY 100 {} @ ${} (z: {}, VWAP: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D, log_arg::D},
+     false},
+    {LogId::VwapExit, "\033[1;36m",
+     "[STRATEGY VWAP{}] SELL 100 {} @ ${} (PnL: ${})",
+     {log_arg::U, log_arg::S, log_arg::D, log_arg::D},
+     false},
+    {LogId::CheckpointOverflow, nullptr,
+     "[CHECKPOINT] State outgrew the {} byte slot, checkpoint skipped",
+     {log_arg::U},
+     true},
+    {LogId::RecoverySkipped, nullptr,
+     "[TCP] Not requesting seq={}..{} (older than the Publisher's RingBuffer)",
+     {log_arg::U, log_arg::U},
+     true},
+};
+
+constexpr bool log_formats_valid() {
+  if (std::size(LOG_FORMATS) != static_cast<size_t>(LogId::Count))
+    return false;
+  for (size_t i = 0; i < std::size(LOG_FORMATS); i++) {
+    const LogFormat &format = LOG_FORMATS[i];
+    if (static_cast<size_t>(format.id) != i ||
+        format.arity() != format.placeholders())
+      return false;
+  }
+  return true;
+}
+
+static_assert(log_formats_valid(),
+              "LOG_FORMATS must follow LogId order with one {} per argument");
+
+constexpr const LogFormat &log_format(LogId id) {
+  return LOG_FORMATS[static_cast<size_t>(id)];
+}
+
+} // namespace core
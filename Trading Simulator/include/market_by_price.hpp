@@ -0,0 +1,160 @@
+#pragma once
+
+#include "book_builder.hpp"
+#include "matching_engine.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace exchange {
+
+// Conflated market-by-price (L2) publishing from the matching engine's
+// books. Changes during a window only mark their book; flush() diffs each
+// marked book's top Depth levels against the consumers' copy and emits the
+// Insert/Update/Delete messages that bring it level with the book. The
+// consumers' copy is an MbpBook kept here by applying those same messages,
+// so the two cannot drift apart. States inside a window are never sent.
+// A book's first flush opens with a Clear, and refresh() re-sends every
+// held book from a Clear, for consumers that joined late or lost updates.
+template <size_t Depth = 10, size_t MaxBooks = 1024> class MarketByPrice {
+public:
+  void mark(const char (&symbol)[4]) {
+    uint32_t key = core::symbol_key(symbol);
+    Entry &entry = entries_.find_or_insert(key, key);
+    if (!entry.dirty) {
+      entry.dirty = true;
+      dirty_.push_back(&entry);
+    }
+  }
+
+  // emit(const protocol::LevelUpdate &) per message; the caller stamps
+  // sequence_num. Returns how many were emitted.
+  template <typename Engine, typename Emit>
+  size_t flush(Engine &engine, Emit &&emit) {
+    size_t emitted = 0;
+    for (Entry *entry : dirty_) {
+      char symbol[4];
+      uint32_t key = entry->held.key();
+      std::memcpy(symbol, &key, sizeof(symbol));
+      if (!entry->opened) {
+        emit(clear_message(symbol));
+        emitted++;
+        entry->opened = true;
+      }
+      const OrderBook *book = engine.book(symbol);
+      for (protocol::Side side : {protocol::Side::Buy, protocol::Side::Sell})
+        emitted += diff(*entry, book, side, symbol, emit);
+      entry->dirty = false;
+    }
+    dirty_.clear();
+    return emitted;
+  }
+
+  // Every book as the consumers should hold it: a Clear, then an Insert per
+  // level from the top. Changes still pending go out with the next flush.
+  // Returns how many were emitted.
+  template <typename Emit> size_t refresh(Emit &&emit) const {
+    size_t emitted = 0;
+    entries_.for_each([&](uint32_t key, const Entry &entry) {
+      if (!entry.opened)
+        return;
+      char symbol[4];
+      std::memcpy(symbol, &key, sizeof(symbol));
+      emit(clear_message(symbol));
+      emitted++;
+      for (protocol::Side side : {protocol::Side::Buy, protocol::Side::Sell}) {
+        for (size_t i = 0; i < entry.held.levels(side); i++) {
+          protocol::LevelUpdate update = clear_message(symbol);
+          update.action = protocol::LevelAction::Insert;
+          update.side = side;
+          update.level = static_cast<uint8_t>(i);
+          update.price = static_cast<int32_t>(entry.held.level(side, i).price);
+          update.quantity = entry.held.level(side, i).quantity;
+          emit(update);
+          emitted++;
+        }
+      }
+    });
+    return emitted;
+  }
+
+  size_t pending() const { return dirty_.size(); }
+
+private:
+  using Held = core::MbpBook<Depth>;
+
+  struct Entry {
+    explicit Entry(uint32_t key) : held(key) {}
+    Held held;
+    bool dirty = false;
+    bool opened = false; // Its Clear has been sent
+  };
+
+  static protocol::LevelUpdate clear_message(const char (&symbol)[4]) {
+    protocol::LevelUpdate update{};
+    std::memcpy(update.symbol, symbol, sizeof(update.symbol));
+    update.action = protocol::LevelAction::Clear;
+    update.side = protocol::Side::Buy;
+    return update;
+  }
+
+  template <typename Emit>
+  static size_t diff(Entry &entry, const OrderBook *book, protocol::Side side,
+                     const char (&symbol)[4], Emit &emit) {
+    std::array<typename Held::Level, Depth> next;
+    size_t count = 0;
+    if (book) {
+      book->for_each_level(side, Depth,
+                           [&](int64_t price, const PriceLevel &lvl) {
+                             next[count++] = {price, lvl.quantity};
+                           });
+    }
+
+    const bool buy = side == protocol::Side::Buy;
+    auto better = [buy](int64_t a, int64_t b) { return buy ? a > b : a < b; };
+    Held &held = entry.held;
+    size_t emitted = 0;
+    size_t i = 0;
+    while (i < count || i < held.levels(side)) {
+      protocol::LevelUpdate update{};
+      std::memcpy(update.symbol, symbol, sizeof(update.symbol));
+      update.level = static_cast<uint8_t>(i);
+      update.side = side;
+
+      if (i < held.levels(side) &&
+          (i >= count || better(held.level(side, i).price, next[i].price))) {
+        // The held level is gone from the book
+        update.action = protocol::LevelAction::Delete;
+        update.price = static_cast<int32_t>(held.level(side, i).price);
+        update.quantity = 0;
+      } else if (i >= held.levels(side) ||
+                 better(next[i].price, held.level(side, i).price)) {
+        update.action = protocol::LevelAction::Insert;
+        update.price = static_cast<int32_t>(next[i].price);
+        update.quantity = next[i].quantity;
+        i++;
+      } else if (held.level(side, i).quantity != next[i].quantity) {
+        update.action = protocol::LevelAction::Update;
+        update.price = static_cast<int32_t>(next[i].price);
+        update.quantity = next[i].quantity;
+        i++;
+      } else {
+        i++;
+        continue;
+      }
+      held.apply(update);
+      emit(update);
+      emitted++;
+    }
+    return emitted;
+  }
+
+  core::SymbolTable<Entry, MaxBooks> entries_;
+  std::vector<Entry *> dirty_;
+};
+
+} // namespace exchange
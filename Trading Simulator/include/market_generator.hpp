@@ -0,0 +1,199 @@
+#pragma once
+
+#include "protocol.hpp"
+#include "random_blocks.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace exchange {
+
+// The Publisher's 50 names. They go out as 3 letters and a NUL, as the
+// feed has always carried them (AAPL is AAP on the wire).
+inline constexpr const char *DEFAULT_SYMBOLS[] = {
+    "AAPL", "MSFT", "GOOG", "AMZN", "META", "TSLA", "NVDA", "JPM",  "JNJ",
+    "V",    "UNH",  "PG",   "HD",   "DIS",  "MA",   "BAC",  "VZ",   "CRM",
+    "XOM",  "PFE",  "NKE",  "INTC", "T",    "KO",   "MRK",  "PEP",  "ABT",
+    "WMT",  "CVX",  "CSCO", "MCD",  "ABBV", "MDT",  "BMY",  "ACN",  "AVGO",
+    "TXN",  "COST", "NEE",  "QCOM", "DHR",  "LIN",  "PM",   "UNP",  "LOW",
+    "HON",  "UPS",  "IBM",  "SBUX", "CAT"};
+
+struct GeneratedTick {
+  double price;
+  uint32_t symbol; // Index into the generator's symbols
+  protocol::Side side;
+};
+
+// The tick the exchange prints for a generated move: the generator's taker
+// crosses the market maker's quote one tick from the price, so a buy trades
+// at the ask and a sell at the bid
+inline protocol::TickPacket generated_trade(const GeneratedTick &move,
+                                            const char (&symbol)[4],
+                                            uint32_t quantity) {
+  protocol::TickPacket tick{};
+  int64_t fair = protocol::to_ticks(move.price);
+  tick.price = protocol::to_price(move.side == protocol::Side::Buy ? fair + 1
+                                                                   : fair - 1);
+  tick.quantity = quantity;
+  std::memcpy(tick.symbol, symbol, sizeof(tick.symbol));
+  return tick;
+}
+
+// Price generation for the Publisher: a log-normal random walk per symbol
+// with momentary flash crashes and spikes (published, not kept) and
+// permanent drops and surges. Per-symbol state is a price array. Random
+// bits come a block at a time from RandomBlocks, and each block of Block
+// ticks is turned into per-tick factors (symbol, walk step, permanent and
+// published multipliers, side) by plain loops over arrays; walk steps are
+// ziggurat normals. Only the price update is sequential, since a symbol
+// can repeat within a block.
+// The output depends on the seed alone, not on how it is requested.
+template <size_t Block = 256> class MarketGenerator {
+public:
+  static constexpr double STEP_SIGMA = 0.01; // Per-tick walk, as a fraction
+  static constexpr double MIN_PRICE = 1.0;
+
+  // The first symbols are DEFAULT_SYMBOLS at 100.00, 107.00, 114.00, ...;
+  // any more take the unused names out of AAA, AAB, ..., ZZZ
+  MarketGenerator(uint64_t seed, size_t symbols = std::size(DEFAULT_SYMBOLS))
+      : random_(seed), prices_(symbols), names_(symbols) {
+    if (symbols == 0)
+      throw std::runtime_error("MarketGenerator: no symbols");
+    const size_t named = std::min(symbols, std::size(DEFAULT_SYMBOLS));
+    for (size_t i = 0; i < named; i++)
+      std::strncpy(names_[i].symbol, DEFAULT_SYMBOLS[i], 3);
+    size_t n = 0;
+    for (size_t i = named; i < symbols; i++) {
+      do {
+        if (n == 26 * 26 * 26)
+          throw std::runtime_error("MarketGenerator: too many symbols");
+        for (int c = 2, v = static_cast<int>(n++); c >= 0; c--, v /= 26)
+          names_[i].symbol[c] = static_cast<char>('A' + v % 26);
+      } while (std::any_of(names_.begin(), names_.begin() + named,
+                           [&](const Name &taken) {
+                             return std::memcmp(taken.symbol,
+                                                names_[i].symbol, 4) == 0;
+                           }));
+    }
+    for (size_t i = 0; i < symbols; i++)
+      prices_[i] = 100.0 + static_cast<double>(i % 1000) * 7;
+  }
+
+  size_t symbols() const { return prices_.size(); }
+  const char (&name(size_t symbol) const)[4] { return names_[symbol].symbol; }
+  // The symbol's current (permanent) price
+  double price(size_t symbol) const { return prices_[symbol]; }
+
+  void generate(std::span<GeneratedTick> out) {
+    size_t done = 0;
+    while (done < out.size()) {
+      if (next_ == Block)
+        refill();
+      size_t n = std::min(out.size() - done, Block - next_);
+      for (size_t i = 0; i < n; i++, next_++) {
+        uint32_t sym = sym_[next_];
+        double p = prices_[sym] * step_[next_];
+        p = p < MIN_PRICE ? MIN_PRICE : p;
+        p *= keep_[next_];
+        p = p < MIN_PRICE ? MIN_PRICE : p;
+        prices_[sym] = p;
+        out[done + i] = {p * show_[next_], sym, side_[next_]};
+      }
+      done += n;
+    }
+  }
+
+private:
+  using Random = core::RandomBlocks<>;
+  struct Name {
+    char symbol[4] = {};
+  };
+
+  static_assert(Block % Random::LANES == 0,
+                "Block must be a multiple of the lane count");
+
+  // Event odds, as the original generator drew them one after another: a
+  // permanent drop (1 in 500), else a surge (1 in 1000), else a flash crash
+  // (1 in 100), else a flash spike (1 in 200). Each is a band of a 31-bit
+  // roll; the position inside the band is the event's depth.
+  static constexpr double ROLL = 2147483648.0; // 2^31
+  static constexpr double P_DROP = 1.0 / 500;
+  static constexpr double P_SURGE = (1 - P_DROP) / 1000;
+  static constexpr double P_CRASH = (1 - P_DROP - P_SURGE) / 100;
+  static constexpr double P_SPIKE =
+      (1 - P_DROP - P_SURGE - P_CRASH) / 200;
+  static constexpr uint32_t DROP_END = static_cast<uint32_t>(ROLL * P_DROP);
+  static constexpr uint32_t SURGE_END =
+      static_cast<uint32_t>(ROLL * (P_DROP + P_SURGE));
+  static constexpr uint32_t CRASH_END =
+      static_cast<uint32_t>(ROLL * (P_DROP + P_SURGE + P_CRASH));
+  static constexpr uint32_t SPIKE_END =
+      static_cast<uint32_t>(ROLL * (P_DROP + P_SURGE + P_CRASH + P_SPIKE));
+
+  // lo to hi across the band [begin, end), with the division folded away
+  template <uint32_t Begin, uint32_t End>
+  static double depth(uint32_t roll, double lo, double hi) {
+    constexpr double scale = 1.0 / (End - Begin);
+    return lo + (hi - lo) * scale * (roll - Begin);
+  }
+
+  // Word a of a tick: symbol (low 32 bits), event roll (bits 32-62), side
+  // (bit 63). Word b: its walk step. The ziggurat's rare extra words come
+  // from a spare block.
+  void refill() {
+    random_.fill(bits_);
+    const uint64_t *a = bits_.data();
+    const uint64_t *b = bits_.data() + Block;
+    const uint64_t n = prices_.size();
+    for (size_t i = 0; i < Block; i++) {
+      sym_[i] = static_cast<uint32_t>(((a[i] & 0xFFFFFFFF) * n) >> 32);
+      side_[i] = (a[i] >> 63) ? protocol::Side::Buy : protocol::Side::Sell;
+      const uint32_t roll = static_cast<uint32_t>(a[i] >> 32) & 0x7FFFFFFF;
+      double keep = 1.0, show = 1.0;
+      if (roll < DROP_END)
+        keep = 1.0 - depth<0, DROP_END>(roll, 0.06, 0.09);
+      else if (roll < SURGE_END)
+        keep = 1.0 + depth<DROP_END, SURGE_END>(roll, 0.06, 0.09);
+      else if (roll < CRASH_END)
+        show = 1.0 - depth<SURGE_END, CRASH_END>(roll, 0.025, 0.05);
+      else if (roll < SPIKE_END)
+        show = 1.0 + depth<CRASH_END, SPIKE_END>(roll, 0.025, 0.05);
+      keep_[i] = keep;
+      show_[i] = show;
+    }
+    auto spare = [this] {
+      if (spare_next_ == spare_.size()) {
+        random_.fill(spare_);
+        spare_next_ = 0;
+      }
+      return spare_[spare_next_++];
+    };
+    for (size_t i = 0; i < Block; i++)
+      step_[i] = 1.0 + STEP_SIGMA * normal_.sample(b[i], spare);
+    next_ = 0;
+  }
+
+  Random random_;
+  core::Ziggurat normal_;
+  std::array<uint64_t, Random::LANES> spare_;
+  size_t spare_next_ = Random::LANES;
+  std::vector<double> prices_;
+  std::vector<Name> names_;
+
+  // The current block, consumed from next_
+  alignas(64) std::array<uint64_t, 2 * Block> bits_;
+  alignas(64) std::array<double, Block> step_;
+  alignas(64) std::array<double, Block> keep_;
+  alignas(64) std::array<double, Block> show_;
+  alignas(64) std::array<uint32_t, Block> sym_;
+  std::array<protocol::Side, Block> side_;
+  size_t next_ = Block;
+};
+
+} // namespace exchange
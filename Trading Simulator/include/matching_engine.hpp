@@ -0,0 +1,359 @@
+#pragma once
+
+#include "flat_id_map.hpp"
+#include "index_pool.hpp"
+#include "price_ladder.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace exchange {
+
+constexpr uint32_t NO_ORDER = UINT32_MAX;
+
+class OrderBook;
+
+// A resting order. Orders live in an OrderPool and are linked into their
+// price level's FIFO by pool index (intrusive, no per-order allocation).
+struct Order {
+  uint64_t id;        // Exchange order id (book feed)
+  uint64_t client_id; // Owner's order id (order entry)
+  int64_t price;      // Ticks
+  OrderBook *book;
+  uint32_t owner;
+  uint32_t quantity; // Open quantity; 0 while the slot is free
+  uint32_t prev;
+  uint32_t next;
+  protocol::Side side;
+};
+
+using OrderPool = core::IndexPool<Order>;
+
+struct PriceLevel {
+  uint32_t head = NO_ORDER; // Oldest order: next to trade
+  uint32_t tail = NO_ORDER;
+  uint64_t quantity = 0; // Total open quantity at this price
+};
+
+// One symbol's book: a PriceLadder of FIFO levels. All resting prices must
+// span fewer than LEVELS ticks.
+class OrderBook {
+public:
+  using Ladder = core::PriceLadder<PriceLevel>;
+  static constexpr size_t LEVELS = Ladder::LEVELS; // $163.84 of ticks
+
+  explicit OrderBook(uint32_t key) : key_(key) {}
+
+  uint32_t key() const { return key_; }
+  int64_t best_bid() const { return ladder_.best_bid(); }
+  int64_t best_ask() const { return ladder_.best_ask(); }
+  bool empty() const { return ladder_.empty(); }
+
+  const PriceLevel &level(int64_t price) const { return ladder_.level(price); }
+
+  // Whether an order at price can rest without breaking the span limit
+  bool can_rest(int64_t price) const { return ladder_.can_hold(price); }
+
+  // Visits up to max levels of side, best first, as visit(price, level)
+  template <typename Visit>
+  size_t for_each_level(protocol::Side side, size_t max,
+                        Visit &&visit) const {
+    return ladder_.for_each_level(side, max, visit);
+  }
+
+  // Appends pool[index] to the back of its price level
+  void append(OrderPool &pool, uint32_t index) {
+    Order &order = pool[index];
+    PriceLevel &lvl = ladder_.level(order.price);
+    order.prev = lvl.tail;
+    order.next = NO_ORDER;
+    if (lvl.tail == NO_ORDER) {
+      lvl.head = index;
+      ladder_.occupy(order.price, order.side);
+    } else {
+      pool[lvl.tail].next = index;
+    }
+    lvl.tail = index;
+    lvl.quantity += order.quantity;
+  }
+
+  // Partial execution of a resting order
+  void reduce(OrderPool &pool, uint32_t index, uint32_t quantity) {
+    Order &order = pool[index];
+    order.quantity -= quantity;
+    ladder_.level(order.price).quantity -= quantity;
+  }
+
+  // Removes pool[index] from its level
+  void unlink(OrderPool &pool, uint32_t index) {
+    Order &order = pool[index];
+    PriceLevel &lvl = ladder_.level(order.price);
+    if (order.prev == NO_ORDER)
+      lvl.head = order.next;
+    else
+      pool[order.prev].next = order.next;
+    if (order.next == NO_ORDER)
+      lvl.tail = order.prev;
+    else
+      pool[order.next].prev = order.prev;
+    lvl.quantity -= order.quantity;
+    if (lvl.head == NO_ORDER)
+      ladder_.vacate(order.price, order.side);
+  }
+
+private:
+  uint32_t key_;
+  Ladder ladder_;
+};
+
+// One trade between a resting (maker) and an incoming (taker) order
+struct Execution {
+  char symbol[4];
+  int64_t price; // Ticks; always the maker's price
+  uint32_t quantity;
+  protocol::Side taker_side;
+  uint32_t maker_owner;
+  uint64_t maker_client_id;
+  uint32_t maker_leaves;
+  uint32_t taker_owner;
+  uint64_t taker_client_id;
+  uint32_t taker_leaves;
+};
+
+// Price-time priority matching over per-symbol OrderBooks. Orders are
+// keyed by (owner, client_id), so each order entry session has its own id
+// space of client IDs below MAX_CLIENT_ID. Output goes to the Listener as
+// it happens:
+//   on_execution(const Execution &)              every trade
+//   on_book_update(const protocol::BookUpdate &) every L3 book change
+// (sequence_num is left for the listener to stamp). Listeners must not
+// call back into the engine. Single-threaded, no allocation after
+// construction apart from the first order seen for a new symbol.
+template <typename Listener, size_t MaxBooks = 1024> class MatchingEngine {
+public:
+  // Client IDs share the 64-bit order key with the owner (see order_key)
+  static constexpr uint64_t MAX_CLIENT_ID = uint64_t{1} << 40;
+
+  MatchingEngine(Listener &listener, uint32_t max_orders)
+      : listener_(listener), pool_(max_orders), ids_(max_orders) {}
+
+  MatchingEngine(const MatchingEngine &) = delete;
+  MatchingEngine &operator=(const MatchingEngine &) = delete;
+
+  // Checks a New without side effects, so the caller can ack before any
+  // fills go out. A resting order must fit its book's price span, and an
+  // order for a new symbol needs one of the MaxBooks books to be free.
+  protocol::RejectReason validate(uint32_t owner, uint64_t client_id,
+                                  const char (&symbol)[4], int64_t price,
+                                  uint32_t quantity, bool ioc = false) {
+    if (quantity == 0)
+      return protocol::RejectReason::BadQuantity;
+    if (price <= 0 || price > std::numeric_limits<int32_t>::max())
+      return protocol::RejectReason::BadPrice;
+    OrderBook *book = books_.find(core::symbol_key(symbol));
+    if (book == nullptr && books_.full())
+      return protocol::RejectReason::BookFull;
+    if (ioc)
+      return protocol::RejectReason::None;
+    if (client_id >= MAX_CLIENT_ID)
+      return protocol::RejectReason::BadOrderId;
+    if (ids_.find(order_key(owner, client_id)) != core::FlatIdMap::NOT_FOUND)
+      return protocol::RejectReason::DuplicateOrder;
+    if (pool_.full())
+      return protocol::RejectReason::BookFull;
+    if (book && !book->can_rest(price))
+      return protocol::RejectReason::BadPrice;
+    return protocol::RejectReason::None;
+  }
+
+  // Limit order: trades against the opposite side while it crosses, then
+  // rests the remainder (unless ioc, which discards it)
+  protocol::RejectReason add(uint32_t owner, uint64_t client_id,
+                             const char (&symbol)[4], protocol::Side side,
+                             int64_t price, uint32_t quantity,
+                             bool ioc = false) {
+    protocol::RejectReason reason =
+        validate(owner, client_id, symbol, price, quantity, ioc);
+    if (reason != protocol::RejectReason::None)
+      return reason;
+
+    uint32_t key = core::symbol_key(symbol);
+    size_t books = books_.size();
+    OrderBook &book = books_.find_or_insert(key, key);
+    if (books_.size() != books)
+      publish_clear(key); // A new book opens with a Clear
+
+    uint32_t leaves = match(book, owner, client_id, side, price, quantity);
+    if (leaves == 0 || ioc)
+      return protocol::RejectReason::None;
+
+    uint32_t index = pool_.acquire();
+    Order &order = pool_[index];
+    order.id = next_order_id_++;
+    order.client_id = client_id;
+    order.price = price;
+    order.owner = owner;
+    order.quantity = leaves;
+    order.book = &book;
+    order.side = side;
+    ids_.insert(order_key(owner, client_id), index);
+    book.append(pool_, index);
+    publish(order, protocol::BookAction::Add, leaves);
+    return protocol::RejectReason::None;
+  }
+
+  // False if the order is not resting (unknown, filled or cancelled)
+  bool cancel(uint32_t owner, uint64_t client_id) {
+    if (client_id >= MAX_CLIENT_ID)
+      return false;
+    uint64_t key = order_key(owner, client_id);
+    uint32_t index = ids_.find(key);
+    if (index == core::FlatIdMap::NOT_FOUND)
+      return false;
+    remove(index, key, protocol::BookAction::Cancel);
+    return true;
+  }
+
+  // Cancels every resting order of owner (e.g. when its session closes)
+  size_t cancel_all(uint32_t owner) {
+    size_t cancelled = 0;
+    for (uint32_t index = 0; index < pool_.capacity(); index++) {
+      const Order &order = pool_[index];
+      if (order.quantity != 0 && order.owner == owner) {
+        remove(index, order_key(owner, order.client_id),
+               protocol::BookAction::Cancel);
+        cancelled++;
+      }
+    }
+    return cancelled;
+  }
+
+  const OrderBook *book(const char (&symbol)[4]) {
+    return books_.find(core::symbol_key(symbol));
+  }
+
+  size_t resting() const { return pool_.live(); }
+
+  // Every book in full, as emit(const protocol::BookUpdate &): a Clear, then
+  // an Add per resting order, best price first and oldest first within a
+  // level. For a periodic refresh of the L3 feed; the Listener sees none of
+  // it. Returns how many updates were emitted.
+  template <typename Emit> size_t snapshot(Emit &&emit) const {
+    size_t emitted = 0;
+    books_.for_each([&](uint32_t key, const OrderBook &book) {
+      emit(clear_update(key));
+      emitted++;
+      for (protocol::Side side : {protocol::Side::Buy, protocol::Side::Sell}) {
+        book.for_each_level(side, OrderBook::LEVELS,
+                            [&](int64_t, const PriceLevel &lvl) {
+                              for (uint32_t i = lvl.head; i != NO_ORDER;
+                                   i = pool_[i].next) {
+                                emit(book_update(pool_[i],
+                                                 protocol::BookAction::Add,
+                                                 pool_[i].quantity));
+                                emitted++;
+                              }
+                            });
+      }
+    });
+    return emitted;
+  }
+
+private:
+  // Owner in the top 24 bits, so sessions cannot collide. client_id is
+  // below MAX_CLIENT_ID for every order that rests.
+  static uint64_t order_key(uint32_t owner, uint64_t client_id) {
+    return (static_cast<uint64_t>(owner) << 40) | client_id;
+  }
+
+  uint32_t match(OrderBook &book, uint32_t owner, uint64_t client_id,
+                 protocol::Side side, int64_t limit, uint32_t quantity) {
+    const bool buy = side == protocol::Side::Buy;
+    while (quantity > 0) {
+      int64_t best = buy ? book.best_ask() : book.best_bid();
+      if (buy ? (best == core::NO_ASK || best > limit)
+              : (best == core::NO_BID || best < limit))
+        break;
+
+      uint32_t maker_index = book.level(best).head;
+      Order &maker = pool_[maker_index];
+      uint32_t traded = std::min(quantity, maker.quantity);
+      quantity -= traded;
+      book.reduce(pool_, maker_index, traded);
+
+      Execution exec;
+      uint32_t key = book.key();
+      std::memcpy(exec.symbol, &key, sizeof(exec.symbol));
+      exec.price = maker.price;
+      exec.quantity = traded;
+      exec.taker_side = side;
+      exec.maker_owner = maker.owner;
+      exec.maker_client_id = maker.client_id;
+      exec.maker_leaves = maker.quantity;
+      exec.taker_owner = owner;
+      exec.taker_client_id = client_id;
+      exec.taker_leaves = quantity;
+      listener_.on_execution(exec);
+      publish(maker, protocol::BookAction::Execute, traded);
+
+      if (maker.quantity == 0) {
+        book.unlink(pool_, maker_index);
+        ids_.erase(order_key(maker.owner, maker.client_id));
+        pool_.release(maker_index);
+      }
+    }
+    return quantity;
+  }
+
+  void remove(uint32_t index, uint64_t key, protocol::BookAction action) {
+    Order &order = pool_[index];
+    publish(order, action, order.quantity);
+    order.book->unlink(pool_, index);
+    ids_.erase(key);
+    order.quantity = 0; // Marks the slot free for cancel_all
+    pool_.release(index);
+  }
+
+  void publish(const Order &order, protocol::BookAction action,
+               uint32_t quantity) {
+    listener_.on_book_update(book_update(order, action, quantity));
+  }
+
+  void publish_clear(uint32_t key) {
+    listener_.on_book_update(clear_update(key));
+  }
+
+  static protocol::BookUpdate book_update(const Order &order,
+                                          protocol::BookAction action,
+                                          uint32_t quantity) {
+    protocol::BookUpdate update{};
+    update.order_id = order.id;
+    update.price = static_cast<int32_t>(order.price);
+    update.quantity = quantity;
+    uint32_t key = order.book->key();
+    std::memcpy(update.symbol, &key, sizeof(update.symbol));
+    update.action = action;
+    update.side = order.side;
+    return update;
+  }
+
+  static protocol::BookUpdate clear_update(uint32_t key) {
+    protocol::BookUpdate update{};
+    std::memcpy(update.symbol, &key, sizeof(update.symbol));
+    update.action = protocol::BookAction::Clear;
+    update.side = protocol::Side::Buy;
+    return update;
+  }
+
+  Listener &listener_;
+  OrderPool pool_;
+  core::FlatIdMap ids_;
+  core::SymbolTable<OrderBook, MaxBooks> books_;
+  uint64_t next_order_id_ = 1;
+};
+
+} // namespace exchange
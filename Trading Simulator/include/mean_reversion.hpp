@@ -0,0 +1,291 @@
+#pragma once
+
+#include "binary_log.hpp"
+#include "bollinger_simd.hpp"
+#include "protocol.hpp"
+#include "risk_gate.hpp"
+#include "rolling_stats.hpp"
+#include "strategy.hpp"
+#include "strategy_state.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+
+namespace strategy {
+
+// Advances a ring index. Power-of-two periods use a mask. Other periods use a
+// compare instead of a runtime modulo.
+template <size_t Period> constexpr uint32_t next_index(uint32_t idx) {
+  if constexpr ((Period & (Period - 1)) == 0) {
+    return (idx + 1) & (Period - 1);
+  } else {
+    return idx + 1 == Period ? 0 : idx + 1;
+  }
+}
+
+// Trading strat: statistical arbitrage (mean reversion) on 2 sigma Bollinger
+// Bands. Period is a compile-time constant, so differently sized variants
+// (20/50/100/200 ticks) can run side by side in one process.
+template <size_t Period, size_t MaxSymbols = MAX_SYMBOLS> class MeanReversion {
+public:
+  static constexpr uint32_t LOT_SIZE = 100;
+
+  using Store = StateStore<Period, MaxSymbols>;
+
+  explicit MeanReversion(const StrategyConfig &config = {})
+      : simd_(config.simd), orders_(config.orders), risk_(config.risk) {}
+
+  std::string name() const { return "SMA" + std::to_string(Period); }
+
+  void on_tick(const protocol::TickPacket &tick) {
+    // Flat table keyed by the raw 4-byte symbol: no string, no allocation
+    uint32_t id = store_.id_for(core::symbol_key(tick.symbol));
+    if (!update(id, tick.price))
+      return;
+
+    double current_sma, std_dev;
+    bollinger_bands(store_.mean[id], store_.m2[id], Period, current_sma,
+                    std_dev);
+    evaluate(id, tick, current_sma, std_dev,
+             tick.price <= current_sma - (2.0 * std_dev),
+             tick.price >= current_sma);
+  }
+
+  // Same decisions as calling on_tick for each tick in order. Window updates
+  // stay sequential; the band maths for up to BAND_BATCH ticks then runs in
+  // one SIMD kernel, and positions are walked in tick order.
+  void on_batch(std::span<const protocol::TickPacket> ticks) {
+    for (size_t start = 0; start < ticks.size(); start += BAND_BATCH) {
+      size_t end = std::min(ticks.size(), start + BAND_BATCH);
+      size_t n = 0;
+      for (size_t t = start; t < end; t++) {
+        uint32_t id = store_.id_for(core::symbol_key(ticks[t].symbol));
+        if (!update(id, ticks[t].price))
+          continue;
+        // Snapshot the statistics now: a later tick in the batch may move
+        // them
+        batch_.price[n] = ticks[t].price;
+        batch_.mean[n] = store_.mean[id];
+        batch_.m2[n] = store_.m2[id];
+        batch_.id[n] = id;
+        batch_.tick[n] = static_cast<uint32_t>(t);
+        n++;
+      }
+
+      bollinger_batch(simd_, batch_, n, Period);
+
+      for (size_t i = 0; i < n; i++) {
+        evaluate(batch_.id[i], ticks[batch_.tick[i]], batch_.sma[i],
+                 batch_.std_dev[i], (batch_.below_band >> i) & 1,
+                 (batch_.above_sma >> i) & 1);
+      }
+    }
+  }
+
+  SimdLevel simd() const { return simd_; }
+
+  double session_pnl() const { return session_pnl_; }
+
+  // Final report lines for open positions, marked to the last price.
+  // Returns the unrealised PnL.
+  double report_open_positions(std::ostream &out) const {
+    double mtm_pnl = 0.0;
+    for (uint32_t id = 0; id < store_.size(); id++) {
+      if (store_.position[id] == 1) {
+        double current_market_price = store_.last_price(id);
+        double unrealised_profit =
+            (current_market_price - store_.entry_price[id]) * 100.0;
+        mtm_pnl += unrealised_profit;
+
+        out << "  Open Position: " << core::symbol_name(store_.index.key_of(id))
+            << " (Bought @ $" << store_.entry_price[id] << ", Current @ $"
+            << current_market_price << ") -> Unrealised: $"
+            << unrealised_profit << "\n";
+      }
+    }
+    return mtm_pnl;
+  }
+
+  // Fills the windows from history before going live, without trading
+  void warm_up(std::span<const protocol::TickPacket> ticks) {
+    for (const protocol::TickPacket &tick : ticks)
+      update(store_.id_for(core::symbol_key(tick.symbol)), tick.price);
+  }
+
+  size_t warmup_ticks() const { return Period; }
+
+  // Symbols with a full window, which are evaluated on their next tick
+  size_t ready_symbols() const {
+    size_t ready = 0;
+    for (uint32_t id = 0; id < store_.size(); id++)
+      ready += store_.cursor[id].count == Period;
+    return ready;
+  }
+
+  size_t symbols() const { return store_.size(); }
+
+  // Period, session PnL, then one record per symbol in ID order
+  void save_checkpoint(core::CheckpointWriter &out) const {
+    out.put(uint64_t{Period});
+    out.put(session_pnl_);
+    out.put(static_cast<uint64_t>(store_.size()));
+    for (uint32_t id = 0; id < store_.size(); id++) {
+      out.put(store_.index.key_of(id));
+      out.put(store_.mean[id]);
+      out.put(store_.mean_comp[id]);
+      out.put(store_.m2[id]);
+      out.put(store_.entry_price[id]);
+      out.put(store_.cursor[id]);
+      out.put(store_.position[id]);
+      out.put(store_.ticks_held[id]);
+      out.put(store_.windows[id]);
+      out.put(store_.report[id]);
+    }
+  }
+
+  // Only into an empty store, and only once the whole layout checks out
+  bool restore_checkpoint(core::CheckpointReader &in) {
+    uint64_t period, count;
+    double session_pnl;
+    if (store_.size() != 0 || !in.get(period) || period != Period ||
+        !in.get(session_pnl) || !in.get(count) || count > MaxSymbols ||
+        in.remaining() != count * CHECKPOINT_RECORD)
+      return false;
+    for (uint64_t i = 0; i < count; i++) {
+      uint32_t key = 0;
+      in.get(key);
+      uint32_t id = store_.id_for(key);
+      in.get(store_.mean[id]);
+      in.get(store_.mean_comp[id]);
+      in.get(store_.m2[id]);
+      in.get(store_.entry_price[id]);
+      in.get(store_.cursor[id]);
+      in.get(store_.position[id]);
+      in.get(store_.ticks_held[id]);
+      in.get(store_.windows[id]);
+      in.get(store_.report[id]);
+    }
+    session_pnl_ = session_pnl;
+    return true;
+  }
+
+private:
+  static constexpr size_t CHECKPOINT_RECORD =
+      sizeof(uint32_t) + 4 * sizeof(double) + sizeof(WindowCursor) +
+      sizeof(int8_t) + sizeof(uint16_t) + sizeof(typename Store::Window) +
+      sizeof(SymbolReport);
+
+  // Pushes price into the symbol's window. Returns true once the window is
+  // full and the tick should be evaluated.
+  bool update(uint32_t id, double price) {
+    WindowCursor &cursor = store_.cursor[id];
+    typename Store::Window &prices = store_.windows[id];
+    double &mean = store_.mean[id];
+    double &mean_comp = store_.mean_comp[id];
+    double &m2 = store_.m2[id];
+
+    // Maintain the moving average and variance for the stock in O(1)
+    if (cursor.count < Period) {
+      prices[cursor.count++] = price;
+      rolling_add(mean, mean_comp, m2, price, cursor.count);
+      return cursor.count == Period;
+    }
+
+    double old_price = prices[cursor.idx];
+    prices[cursor.idx] = price;
+    rolling_replace(mean, mean_comp, m2, old_price, price, Period);
+    cursor.idx = static_cast<uint16_t>(next_index<Period>(cursor.idx));
+    return true;
+  }
+
+  // below_band: price <= sma - 2 sigma, above_sma: price >= sma
+  void evaluate(uint32_t id, const protocol::TickPacket &tick,
+                double current_sma, double std_dev, bool below_band,
+                bool above_sma) {
+    core::LogSymbol sym(tick.symbol);
+    int8_t &position = store_.position[id];
+    double &entry_price = store_.entry_price[id];
+    uint16_t &ticks_held = store_.ticks_held[id];
+
+    // If we have no position, look for a dip below the Bollinger Band (-2
+    // Standard Deviations)
+    if (position == 0 && below_band) {
+      if (!approve(protocol::Side::Buy, tick, current_sma))
+        return;
+      position = 1;
+      entry_price = tick.price;
+      ticks_held = 0;
+      send_order(protocol::Side::Buy, tick);
+      core::log<core::LogId::StrategyBuy>(Period, sym, tick.price,
+                                          current_sma, 2.0 * std_dev);
+    }
+    // If we have stock, manage the open position
+    else if (position == 1) {
+      ticks_held++;
+
+      // Exit 1: take profit (mean reversion)
+      // Exit 2: hard stop loss (The price just keeps plummeting)
+      // Exit 3: time stop loss (stock is not rising back to mean)
+      // A rejected exit keeps the position and is retried on the next tick
+      bool stop_loss =
+          tick.price <= entry_price - (3.0 * std_dev) && ticks_held > 2;
+      bool time_stop = ticks_held > 50;
+      if (!(above_sma || stop_loss || time_stop) ||
+          !approve(protocol::Side::Sell, tick, current_sma))
+        return;
+      double pnl = close_position(id, tick);
+      if (above_sma)
+        core::log<core::LogId::StrategyTakeProfit>(Period, sym, tick.price,
+                                                   pnl);
+      else if (stop_loss)
+        core::log<core::LogId::StrategyStopLoss>(Period, sym, tick.price,
+                                                 pnl);
+      else
+        core::log<core::LogId::StrategyTimeStop>(Period, sym, tick.price,
+                                                 pnl);
+    }
+  }
+
+  // Pre-trade checks against the SMA as reference price, timed by the
+  // tick's timestamp so replayed ticks are limited as they were sent
+  bool approve(protocol::Side side, const protocol::TickPacket &tick,
+               double current_sma) {
+    return risk_ == nullptr ||
+           risk_->check(tick.symbol, side, tick.price, LOT_SIZE, current_sma,
+                        static_cast<int64_t>(tick.timestamp)) == RISK_OK;
+  }
+
+  // Orders go out before the log call, so logging stays off tick-to-order
+  void send_order(protocol::Side side, const protocol::TickPacket &tick) {
+    if (orders_)
+      orders_->submit(side, tick.symbol, tick.price, LOT_SIZE,
+                      tick.timestamp);
+  }
+
+  double close_position(uint32_t id, const protocol::TickPacket &tick) {
+    send_order(protocol::Side::Sell, tick);
+    double pnl = (tick.price - store_.entry_price[id]) * 100.0;
+    store_.report[id].pnl += pnl;
+    store_.report[id].trades++;
+    session_pnl_ += pnl;
+    store_.position[id] = 0;
+    return pnl;
+  }
+
+  Store store_;
+  double session_pnl_ = 0.0;
+  SimdLevel simd_;
+  OrderSink *orders_;
+  RiskGate *risk_;
+  BandBatch batch_;
+};
+
+static_assert(TickStrategy<MeanReversion<100>>);
+static_assert(Checkpointable<MeanReversion<100>>);
+static_assert(WarmStartable<MeanReversion<100>>);
+
+} // namespace strategy
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
 #include <iostream>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdexcept>
 #include <string>
 #include <sys/socket.h>
@@ -121,4 +124,42 @@ inline int connect_tcp_client(const std::string &ip, int port) {
   return sock;
 }
 
+// Order entry sockets: no Nagle batching, and never raise SIGPIPE on a
+// dropped peer (send reports EPIPE instead)
+inline void set_tcp_low_latency(int sock) {
+  int opt = 1;
+  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0)
+    throw std::runtime_error("Failed to set TCP_NODELAY");
+#ifdef SO_NOSIGPIPE
+  setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &opt, sizeof(opt));
+#endif
+}
+
+inline void set_nonblocking(int sock) {
+  int flags = fcntl(sock, F_GETFL, 0);
+  if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0)
+    throw std::runtime_error("Failed to make socket non-blocking");
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0; // SO_NOSIGPIPE covers macOS
+#endif
+
+// Blocking send of the whole buffer. Returns false if the peer is gone.
+inline bool send_all(int sock, const void *data, size_t len) {
+  const char *bytes = static_cast<const char *>(data);
+  while (len > 0) {
+    ssize_t sent = send(sock, bytes, len, SEND_FLAGS);
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent <= 0)
+      return false;
+    bytes += sent;
+    len -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
 } // namespace networking
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "binary_log.hpp"
+#include "fan_in_queue.hpp"
+#include "latency_histogram.hpp"
+#include "networking.hpp"
+#include "order_sink.hpp"
+#include "protocol.hpp"
+#include "wait_strategy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace networking {
+
+inline uint64_t order_clock_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::high_resolution_clock::now().time_since_epoch())
+          .count());
+}
+
+// Client side of order entry. Strategy threads submit through their own
+// OrderSink; a dedicated gateway thread drains the sinks, encodes New
+// orders onto a non-blocking TCP session and reads back acks, fills and
+// rejects. When idle it waits by the subscriber's --wait strategy: spin,
+// pause and yield poll the socket and sinks, block parks in poll() until
+// either has work. At most MAX_PENDING_BYTES of encoded orders wait for
+// the socket; past that, intents stay in the sinks, which drop and count
+// them once full. Latency is measured on the shared host clock:
+//   tick-to-order: publisher tick timestamp -> order handed to the socket
+//   order-to-ack / order-to-fill: order sent -> response read
+class OrderGateway {
+public:
+  OrderGateway(const std::string &ip, int port, size_t producers,
+               core::WaitKind wait = core::WaitKind::BusySpin)
+      : intents_(producers), wait_(wait) {
+    sock_ = connect_tcp_client(ip, port);
+    try {
+      set_tcp_low_latency(sock_);
+      set_nonblocking(sock_);
+    } catch (...) {
+      close(sock_);
+      throw;
+    }
+    for (size_t p = 0; p < producers; p++)
+      sinks_.push_back(std::make_unique<strategy::OrderSink>(
+          intents_.producer(p),
+          wait == core::WaitKind::Blocking ? &wake_ : nullptr));
+    thread_ = std::thread([this] { run(); });
+  }
+
+  OrderGateway(const OrderGateway &) = delete;
+  OrderGateway &operator=(const OrderGateway &) = delete;
+
+  ~OrderGateway() {
+    stop();
+    close(sock_);
+  }
+
+  // The sink for one strategy thread
+  strategy::OrderSink &sink(size_t producer) { return *sinks_[producer]; }
+
+  // Sends what is queued, then joins the gateway thread
+  void stop() {
+    if (!running_.exchange(false))
+      return;
+    wake_.notify();
+    thread_.join();
+  }
+
+  uint64_t sent() const { return sent_.load(std::memory_order_relaxed); }
+  uint64_t acked() const { return acked_.load(std::memory_order_relaxed); }
+  uint64_t filled() const { return filled_.load(std::memory_order_relaxed); }
+  uint64_t rejected() const {
+    return rejected_.load(std::memory_order_relaxed);
+  }
+  bool connected() const { return connected_.load(std::memory_order_relaxed); }
+
+  const core::LatencyHistogram &tick_to_order() const {
+    return tick_to_order_;
+  }
+  const core::LatencyHistogram &order_to_ack() const { return order_to_ack_; }
+  const core::LatencyHistogram &order_to_fill() const {
+    return order_to_fill_;
+  }
+
+  void print_report(FILE *out = stdout) const {
+    uint64_t dropped = 0;
+    for (const auto &sink : sinks_)
+      dropped += sink->dropped();
+    std::fprintf(out,
+                 "Orders sent %llu | acked %llu | filled %llu | rejected "
+                 "%llu | dropped %llu%s\n",
+                 static_cast<unsigned long long>(sent()),
+                 static_cast<unsigned long long>(acked()),
+                 static_cast<unsigned long long>(filled()),
+                 static_cast<unsigned long long>(rejected()),
+                 static_cast<unsigned long long>(dropped),
+                 connected() ? "" : " (session lost)");
+    tick_to_order_.print("tick-to-order", out);
+    order_to_ack_.print("order-to-ack", out);
+    order_to_fill_.print("order-to-fill", out);
+  }
+
+private:
+  // Bounded so a burst of decisions cannot starve the read side
+  static constexpr size_t ORDER_BURST = 64;
+  static constexpr size_t READ_BYTES = 256 * sizeof(protocol::OrderMessage);
+  // Encoded orders the socket may be behind by (about 21,000)
+  static constexpr size_t MAX_PENDING_BYTES = 1 << 20;
+
+  void run() {
+    uint32_t idle = 0;
+    while (running_.load(std::memory_order_relaxed) ||
+           intents_.size_approx() != 0 || out_head_ != out_.size()) {
+      if (!connected_.load(std::memory_order_relaxed))
+        break;
+      // drain() takes up to its burst from every sink
+      size_t room = (MAX_PENDING_BYTES - pending()) /
+                    sizeof(protocol::OrderMessage) / intents_.producers();
+      size_t work = intents_.drain(
+          [&](const strategy::OrderIntent &intent) { encode(intent); },
+          std::min(ORDER_BURST, room));
+      work += flush();
+      work += receive();
+      if (work == 0)
+        wait(idle++);
+      else
+        idle = 0;
+    }
+  }
+
+  size_t pending() const { return out_.size() - out_head_; }
+
+  // One idle pass: spins first, then backs off as --wait says
+  void wait(uint32_t idle) {
+    if (idle < core::WAIT_SPIN_LIMIT || wait_ == core::WaitKind::BusySpin) {
+      core::cpu_relax();
+      return;
+    }
+    switch (wait_) {
+    case core::WaitKind::SpinYield:
+      std::this_thread::yield();
+      break;
+    case core::WaitKind::Blocking:
+      // Wake on a response, on socket space for queued orders, or on a
+      // new intent (if there is room to take it)
+      wake_.wait_until(sock_, pending() != 0 ? POLLIN | POLLOUT : POLLIN,
+                       [&] {
+                         return !running_.load(std::memory_order_relaxed) ||
+                                (pending() < MAX_PENDING_BYTES &&
+                                 intents_.size_approx() != 0);
+                       });
+      break;
+    default:
+      core::cpu_relax();
+      break;
+    }
+  }
+
+  void encode(const strategy::OrderIntent &intent) {
+    protocol::OrderMessage msg{};
+    msg.type = protocol::OrderType::New;
+    msg.side = intent.side;
+    std::memcpy(msg.symbol, intent.symbol, sizeof(msg.symbol));
+    msg.order_id = next_order_id_++;
+    msg.price = intent.price;
+    msg.quantity = intent.quantity;
+    msg.leaves = intent.quantity;
+    msg.client_ns = order_clock_ns();
+    // Ticks from another host's clock may appear to be from the future
+    if (intent.tick_ns != 0 && msg.client_ns >= intent.tick_ns)
+      tick_to_order_.record(msg.client_ns - intent.tick_ns);
+
+    const char *bytes = reinterpret_cast<const char *>(&msg);
+    out_.insert(out_.end(), bytes, bytes + sizeof(msg));
+    sent_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Writes as much of the outbound buffer as the socket takes
+  size_t flush() {
+    if (pending() == 0)
+      return 0;
+    ssize_t n = send(sock_, out_.data() + out_head_, pending(), SEND_FLAGS);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        connected_.store(false, std::memory_order_relaxed);
+      return 0;
+    }
+    out_head_ += static_cast<size_t>(n);
+    if (out_head_ == out_.size()) {
+      out_.clear();
+      out_head_ = 0;
+    }
+    return static_cast<size_t>(n);
+  }
+
+  size_t receive() {
+    ssize_t n = recv(sock_, in_ + in_len_, sizeof(in_) - in_len_, 0);
+    if (n == 0 ||
+        (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      connected_.store(false, std::memory_order_relaxed);
+      return 0;
+    }
+    if (n < 0)
+      return 0;
+    in_len_ += static_cast<size_t>(n);
+
+    uint64_t now = order_clock_ns();
+    size_t whole = in_len_ / sizeof(protocol::OrderMessage);
+    for (size_t i = 0; i < whole; i++) {
+      protocol::OrderMessage msg;
+      std::memcpy(&msg, in_ + i * sizeof(msg), sizeof(msg));
+      on_response(msg, now);
+    }
+    size_t used = whole * sizeof(protocol::OrderMessage);
+    std::memmove(in_, in_ + used, in_len_ - used);
+    in_len_ -= used;
+    return static_cast<size_t>(n);
+  }
+
+  void on_response(const protocol::OrderMessage &msg, uint64_t now) {
+    // Fills of resting orders carry no client timestamp
+    bool timed = msg.client_ns != 0;
+    uint64_t elapsed = now >= msg.client_ns ? now - msg.client_ns : 0;
+    switch (msg.type) {
+    case protocol::OrderType::Ack:
+      acked_.fetch_add(1, std::memory_order_relaxed);
+      if (timed)
+        order_to_ack_.record(elapsed);
+      break;
+    case protocol::OrderType::Fill:
+      filled_.fetch_add(1, std::memory_order_relaxed);
+      if (timed)
+        order_to_fill_.record(elapsed);
+      break;
+    case protocol::OrderType::Reject:
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      core::log<core::LogId::OrderRejected>(
+          msg.order_id, static_cast<unsigned>(msg.reason));
+      break;
+    default:
+      break;
+    }
+  }
+
+  int sock_ = -1;
+  FanInQueue<strategy::OrderIntent, strategy::ORDER_QUEUE_CAPACITY> intents_;
+  core::WaitKind wait_;
+  core::PollWait wake_; // Parks the gateway under --wait=block
+  std::vector<std::unique_ptr<strategy::OrderSink>> sinks_;
+
+  // Gateway-thread state
+  uint64_t next_order_id_ = 1;
+  std::vector<char> out_;
+  size_t out_head_ = 0;
+  char in_[READ_BYTES];
+  size_t in_len_ = 0;
+
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> acked_{0};
+  std::atomic<uint64_t> filled_{0};
+  std::atomic<uint64_t> rejected_{0};
+  std::atomic<bool> connected_{true};
+  std::atomic<bool> running_{true};
+  core::LatencyHistogram tick_to_order_;
+  core::LatencyHistogram order_to_ack_;
+  core::LatencyHistogram order_to_fill_;
+  std::thread thread_;
+};
+
+// Exchange side framing for one order-entry client: reassembles whole
+// OrderMessages from whatever each recv() returns
+class OrderSessionReader {
+public:
+  // One recv(), handing each whole message to handle(msg). False once the
+  // client has gone. Works on blocking and non-blocking sockets.
+  template <typename Handler> bool read(int fd, Handler &&handle) {
+    ssize_t n = recv(fd, in_ + len_, sizeof(in_) - len_, 0);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    if (n <= 0)
+      return false;
+    len_ += static_cast<size_t>(n);
+
+    size_t whole = len_ / sizeof(protocol::OrderMessage);
+    for (size_t i = 0; i < whole; i++) {
+      protocol::OrderMessage msg;
+      std::memcpy(&msg, in_ + i * sizeof(msg), sizeof(msg));
+      handle(msg);
+    }
+    size_t used = whole * sizeof(protocol::OrderMessage);
+    std::memmove(in_, in_ + used, len_ - used);
+    len_ -= used;
+    return true;
+  }
+
+private:
+  static constexpr size_t READ_BYTES = 256 * sizeof(protocol::OrderMessage);
+
+  char in_[READ_BYTES];
+  size_t len_ = 0;
+};
+
+// Serves one order-entry client on a blocking socket until it disconnects:
+// handle(msg, replies) per message, then one send() of all replies per read
+template <typename Handler> void serve_order_session(int fd, Handler &&handle) {
+  OrderSessionReader reader;
+  std::vector<protocol::OrderMessage> replies;
+
+  while (reader.read(fd, [&](const protocol::OrderMessage &msg) {
+    handle(msg, replies);
+  })) {
+    if (!replies.empty()) {
+      if (!send_all(fd, replies.data(),
+                    replies.size() * sizeof(protocol::OrderMessage)))
+        break;
+      replies.clear();
+    }
+  }
+}
+
+// Response to msg with the given type, echoing the client's fields
+inline protocol::OrderMessage order_reply(const protocol::OrderMessage &msg,
+                                          protocol::OrderType type) {
+  protocol::OrderMessage reply = msg;
+  reply.type = type;
+  reply.exchange_ns = order_clock_ns();
+  return reply;
+}
+
+} // namespace networking
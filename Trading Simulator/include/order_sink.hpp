@@ -0,0 +1,60 @@
+#pragma once
+
+#include "protocol.hpp"
+#include "spsc_queue.hpp"
+#include "wait_strategy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace strategy {
+
+// A strategy's decision to trade, on its way to the order gateway
+struct OrderIntent {
+  protocol::Side side;
+  char symbol[4];
+  double price;
+  uint32_t quantity;
+  uint64_t tick_ns; // Publisher timestamp of the tick behind the decision
+};
+
+constexpr size_t ORDER_QUEUE_CAPACITY = 1024;
+using OrderQueue = SPSCQueue<OrderIntent, ORDER_QUEUE_CAPACITY>;
+
+// Where a strategy thread submits orders: its own queue into the gateway
+// thread, which owns the socket. submit() never blocks and never makes a
+// syscall unless the gateway is parked (--wait=block) and must be woken;
+// if the gateway has fallen a full queue behind, the order is dropped and
+// counted.
+class OrderSink {
+public:
+  explicit OrderSink(OrderQueue &queue, core::PollWait *wake = nullptr)
+      : queue_(queue), wake_(wake) {}
+
+  bool submit(protocol::Side side, const char (&symbol)[4], double price,
+              uint32_t quantity, uint64_t tick_ns) {
+    OrderIntent *slot = queue_.claim_write();
+    if (slot == nullptr) {
+      dropped_++;
+      return false;
+    }
+    slot->side = side;
+    std::memcpy(slot->symbol, symbol, sizeof(slot->symbol));
+    slot->price = price;
+    slot->quantity = quantity;
+    slot->tick_ns = tick_ns;
+    queue_.commit_write();
+    if (wake_ != nullptr)
+      wake_->notify();
+    return true;
+  }
+
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  OrderQueue &queue_;
+  core::PollWait *wake_;
+  uint64_t dropped_ = 0;
+};
+
+} // namespace strategy
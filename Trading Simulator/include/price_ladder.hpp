@@ -0,0 +1,178 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace core {
+
+constexpr int64_t NO_BID = std::numeric_limits<int64_t>::min();
+constexpr int64_t NO_ASK = std::numeric_limits<int64_t>::max();
+
+// One symbol's price levels as a flat array indexed by price (in ticks)
+// modulo Levels. Every occupied price must lie within a span of fewer than
+// Levels ticks, so the ladder follows the market without ever recentring.
+// An occupancy bitmap finds the next level in a few word scans when the
+// best one empties; the best and deepest price of each side are cached, so
+// top of book is a load.
+//
+// The ladder does not know what a Level holds: owners call occupy() when a
+// level gains its first order and vacate() when it loses its last.
+template <typename Level, size_t Levels = size_t{1} << 14>
+class PriceLadder {
+  static_assert(std::has_single_bit(Levels) && Levels >= 64,
+                "Levels must be a power of two of at least 64");
+
+public:
+  static constexpr size_t LEVELS = Levels;
+  static constexpr size_t MASK = Levels - 1;
+
+  PriceLadder() : levels_(LEVELS), occupied_(LEVELS / 64) {}
+
+  int64_t best_bid() const { return best_bid_; }
+  int64_t best_ask() const { return best_ask_; }
+  bool empty() const { return best_bid_ == NO_BID && best_ask_ == NO_ASK; }
+
+  Level &level(int64_t price) {
+    return levels_[static_cast<size_t>(price) & MASK];
+  }
+  const Level &level(int64_t price) const {
+    return levels_[static_cast<size_t>(price) & MASK];
+  }
+
+  // Whether price can be occupied without breaking the span limit
+  bool can_hold(int64_t price) const {
+    if (empty())
+      return true;
+    int64_t lo = deep_bid_ != NO_BID ? deep_bid_ : best_ask_;
+    int64_t hi = deep_ask_ != NO_ASK ? deep_ask_ : best_bid_;
+    return std::max(hi, price) - std::min(lo, price) <
+           static_cast<int64_t>(LEVELS);
+  }
+
+  void occupy(int64_t price, protocol::Side side) {
+    set_occupied(price);
+    if (side == protocol::Side::Buy) {
+      if (best_bid_ == NO_BID) {
+        best_bid_ = deep_bid_ = price;
+      } else {
+        best_bid_ = std::max(best_bid_, price);
+        deep_bid_ = std::min(deep_bid_, price);
+      }
+    } else {
+      if (best_ask_ == NO_ASK) {
+        best_ask_ = deep_ask_ = price;
+      } else {
+        best_ask_ = std::min(best_ask_, price);
+        deep_ask_ = std::max(deep_ask_, price);
+      }
+    }
+  }
+
+  // Moves the best/deepest price of side on if price was one of them
+  void vacate(int64_t price, protocol::Side side) {
+    clear_occupied(price);
+    if (side == protocol::Side::Buy) {
+      if (best_bid_ == deep_bid_) {
+        best_bid_ = deep_bid_ = NO_BID;
+      } else if (price == best_bid_) {
+        best_bid_ = scan_down(price - 1, deep_bid_, NO_BID);
+      } else if (price == deep_bid_) {
+        deep_bid_ = scan_up(price + 1, best_bid_, NO_BID);
+      }
+    } else {
+      if (best_ask_ == deep_ask_) {
+        best_ask_ = deep_ask_ = NO_ASK;
+      } else if (price == best_ask_) {
+        best_ask_ = scan_up(price + 1, deep_ask_, NO_ASK);
+      } else if (price == deep_ask_) {
+        deep_ask_ = scan_down(price - 1, best_ask_, NO_ASK);
+      }
+    }
+  }
+
+  // The next occupied bid below price, or NO_BID
+  int64_t next_bid(int64_t price) const {
+    if (deep_bid_ == NO_BID || price <= deep_bid_)
+      return NO_BID;
+    return scan_down(price - 1, deep_bid_, NO_BID);
+  }
+
+  // The next occupied ask above price, or NO_ASK
+  int64_t next_ask(int64_t price) const {
+    if (deep_ask_ == NO_ASK || price >= deep_ask_)
+      return NO_ASK;
+    return scan_up(price + 1, deep_ask_, NO_ASK);
+  }
+
+  // Visits up to max occupied levels of side, best first, as
+  // visit(price, level). Returns how many were visited.
+  template <typename Visit>
+  size_t for_each_level(protocol::Side side, size_t max,
+                        Visit &&visit) const {
+    const bool buy = side == protocol::Side::Buy;
+    int64_t price = buy ? best_bid_ : best_ask_;
+    size_t n = 0;
+    for (; n < max && price != (buy ? NO_BID : NO_ASK); n++) {
+      visit(price, level(price));
+      price = buy ? next_bid(price) : next_ask(price);
+    }
+    return n;
+  }
+
+private:
+  void set_occupied(int64_t price) {
+    size_t bit = static_cast<size_t>(price) & MASK;
+    occupied_[bit >> 6] |= uint64_t{1} << (bit & 63);
+  }
+
+  void clear_occupied(int64_t price) {
+    size_t bit = static_cast<size_t>(price) & MASK;
+    occupied_[bit >> 6] &= ~(uint64_t{1} << (bit & 63));
+  }
+
+  // Highest occupied price in [floor, from], or none. Bits below floor in
+  // the last word may belong to prices outside the span and are rejected.
+  int64_t scan_down(int64_t from, int64_t floor, int64_t none) const {
+    for (int64_t price = from; price >= floor;) {
+      size_t bit = static_cast<size_t>(price) & MASK;
+      uint64_t word = occupied_[bit >> 6] & (~uint64_t{0} >> (63 - (bit & 63)));
+      if (word != 0) {
+        int64_t found = price - static_cast<int64_t>(
+                                    (bit & 63) - (63 - std::countl_zero(word)));
+        return found >= floor ? found : none;
+      }
+      price -= static_cast<int64_t>(bit & 63) + 1;
+    }
+    return none;
+  }
+
+  // Lowest occupied price in [from, ceiling], or none
+  int64_t scan_up(int64_t from, int64_t ceiling, int64_t none) const {
+    for (int64_t price = from; price <= ceiling;) {
+      size_t bit = static_cast<size_t>(price) & MASK;
+      uint64_t word = occupied_[bit >> 6] & (~uint64_t{0} << (bit & 63));
+      if (word != 0) {
+        int64_t found = price + static_cast<int64_t>(std::countr_zero(word) -
+                                                     (bit & 63));
+        return found <= ceiling ? found : none;
+      }
+      price += 64 - static_cast<int64_t>(bit & 63);
+    }
+    return none;
+  }
+
+  int64_t best_bid_ = NO_BID;
+  int64_t deep_bid_ = NO_BID; // Lowest occupied bid
+  int64_t best_ask_ = NO_ASK;
+  int64_t deep_ask_ = NO_ASK; // Highest occupied ask
+  std::vector<Level, HugePageAllocator<Level>> levels_;
+  std::vector<uint64_t> occupied_;
+};
+
+} // namespace core
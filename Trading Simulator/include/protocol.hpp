@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <string>
@@ -20,4 +21,112 @@ struct RetransmitRequest {
   uint64_t missed_sequence_num;
 };
 
+// Warm-start history (TCP, on the retransmission port): a RetransmitRequest
+// for HISTORY_REQUEST, then a HistoryRequest and `symbols` 4-byte names
+// (none = every symbol). The answer is a HistoryReply and `ticks`
+// TickPackets, oldest first: the last `depth` ticks of each symbol still in
+// the Publisher's RingBuffer, complete up to last_sequence.
+constexpr uint64_t HISTORY_REQUEST = UINT64_MAX;
+
+struct HistoryRequest {
+  uint32_t depth; // Ticks per symbol
+  uint32_t symbols;
+};
+
+struct HistoryReply {
+  uint64_t ticks;
+  uint64_t last_sequence;
+};
+
+// Order entry (TCP, subscriber <-> publisher). Every message is one
+// fixed-size OrderMessage, so framing is a whole number of 48-byte reads.
+// The client sends New and Cancel; the exchange answers with Ack (for either),
+// Fill or Reject for the same order_id and echoes client_ns for round-trip
+// timing. Fills of a resting order carry client_ns = 0.
+enum class OrderType : uint8_t { New = 1, Cancel, Ack, Fill, Reject };
+
+enum class Side : uint8_t { Buy = 1, Sell };
+
+enum class RejectReason : uint8_t {
+  None,
+  UnknownSymbol,
+  BadPrice,
+  BadQuantity,
+  UnknownOrder,
+  DuplicateOrder,
+  BookFull,
+  BadSide,    // Neither Buy nor Sell
+  BadOrderId, // order_id of 2^40 or more
+};
+
+struct alignas(8) OrderMessage {
+  OrderType type;        // 1 byte
+  Side side;             // 1 byte
+  RejectReason reason;   // 1 byte (Reject only)
+  uint8_t reserved;      // 1 byte
+  char symbol[4];        // 4 bytes
+  uint64_t order_id;     // 8 bytes, chosen by the client
+  double price;          // 8 bytes: limit price, or the fill price
+  uint32_t quantity;     // 4 bytes: order size, or the filled size
+  uint32_t leaves;       // 4 bytes: still open after this message
+  uint64_t client_ns;    // 8 bytes: client send time, echoed back
+  uint64_t exchange_ns;  // 8 bytes: exchange processing time
+};
+
+static_assert(sizeof(OrderMessage) == 48, "OrderMessage is 48 bytes");
+
+// Book feeds carry prices as integer ticks of $0.01
+constexpr int64_t PRICE_SCALE = 100;
+
+inline int64_t to_ticks(double price) {
+  return std::llround(price * PRICE_SCALE);
+}
+
+inline double to_price(int64_t ticks) {
+  return static_cast<double>(ticks) / PRICE_SCALE;
+}
+
+// L3 book feed (UDP multicast): one BookUpdate per order event in the
+// Publisher's matching engine, numbered in its own sequence. Clear empties
+// the symbol's book: it opens a new book and every periodic refresh, which
+// then Adds each resting order again, so a consumer that lost updates can
+// start the book again from there.
+enum class BookAction : uint8_t { Add = 1, Cancel, Execute, Clear };
+
+struct alignas(32) BookUpdate {
+  uint64_t sequence_num; // 8 bytes
+  uint64_t order_id;     // 8 bytes, assigned by the exchange
+  int32_t price;         // 4 bytes, in ticks
+  uint32_t quantity;     // 4 bytes: added, cancelled or executed size
+  char symbol[4];        // 4 bytes
+  BookAction action;     // 1 byte
+  Side side;             // 1 byte
+  uint16_t reserved;     // 2 bytes
+};
+
+static_assert(sizeof(BookUpdate) == 32, "BookUpdate is 32 bytes");
+
+// L2 market-by-price feed (UDP multicast): the top levels of each side as
+// a fixed-depth array, kept in step by index. Insert shifts the levels at
+// and below level down one (the last falls off), Delete shifts those below
+// up one, Update replaces the aggregate size. Changes within a publishing
+// window are conflated, so a level that moves and moves back sends nothing.
+// Clear empties both sides of the symbol: it opens a symbol's first update
+// and every periodic refresh, which then Inserts each level from the top,
+// so a consumer that lost updates can start the book again from there.
+enum class LevelAction : uint8_t { Insert = 1, Update, Delete, Clear };
+
+struct alignas(32) LevelUpdate {
+  uint64_t sequence_num; // 8 bytes
+  uint64_t quantity;     // 8 bytes, total size at the level
+  int32_t price;         // 4 bytes, in ticks
+  char symbol[4];        // 4 bytes
+  uint8_t level;         // 1 byte, 0 = best
+  LevelAction action;    // 1 byte
+  Side side;             // 1 byte
+  uint8_t reserved;      // 1 byte
+};
+
+static_assert(sizeof(LevelUpdate) == 32, "LevelUpdate is 32 bytes");
+
 } // namespace protocol
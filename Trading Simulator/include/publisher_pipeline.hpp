@@ -0,0 +1,232 @@
+#pragma once
+
+#include "market_generator.hpp"
+#include "protocol.hpp"
+#include "spsc_queue.hpp"
+#include "thread_affinity.hpp"
+#include "transport.hpp"
+#include "wait_strategy.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace exchange {
+
+// The Publisher as a pipeline of threads, each optionally pinned to a core:
+//
+//   generator  --moves-->  sequencer  --ticks-->  sender
+//
+// The generator paces MarketGenerator output into an SPSC queue. The
+// sequencer is the event loop thread: it trades the moves through the
+// matching engine, stamps sequence numbers and fills the recovery
+// RingBuffer. The sender batches the ticks onto the feed. A slow send
+// then delays neither the next tick's generation nor its sequencing.
+
+// Items a stage has finished, written by its own thread only. The metrics
+// timer reads per-second deltas with take().
+class StageCounter {
+public:
+  void add(uint64_t n) {
+    total_.store(total_.load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+  }
+  uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+  // Since the last take(); one reader only
+  uint64_t take() { return total() - std::exchange(reported_, total()); }
+
+private:
+  std::atomic<uint64_t> total_{0};
+  uint64_t reported_ = 0;
+};
+
+// Generates ticks_per_ms moves every millisecond on its own thread. After
+// each batch it writes a byte to a pipe, which the sequencer's event loop
+// watches. A full queue holds the generator back, never the sequencer.
+template <size_t QueueSize = 1 << 16> class GeneratorStage {
+public:
+  GeneratorStage(uint64_t seed, long ticks_per_ms, int cpu)
+      : generator_(seed) {
+    if (pipe(wake_) < 0)
+      throw std::runtime_error("Failed to create the generator wake pipe");
+    fcntl(wake_[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_[1], F_SETFL, O_NONBLOCK);
+    thread_ = std::thread([this, ticks_per_ms, cpu] {
+      pinned_ = core::pin_this_thread(cpu);
+      started_.store(true, std::memory_order_release);
+      run(static_cast<size_t>(ticks_per_ms > 0 ? ticks_per_ms : 0));
+    });
+    // Returns once the thread is pinned, so pinned() is settled
+    while (!started_.load(std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  GeneratorStage(const GeneratorStage &) = delete;
+  GeneratorStage &operator=(const GeneratorStage &) = delete;
+
+  ~GeneratorStage() {
+    stopping_.store(true, std::memory_order_relaxed);
+    thread_.join();
+    close(wake_[0]);
+    close(wake_[1]);
+  }
+
+  // For the sequencer's event loop: readable after each batch
+  int wake_fd() const { return wake_[0]; }
+
+  // Sequencer thread: on_move(const GeneratedTick &) for every queued move,
+  // oldest first. Returns how many there were.
+  template <typename OnMove> size_t drain(OnMove &&on_move) {
+    char bytes[64];
+    while (read(wake_[0], bytes, sizeof(bytes)) > 0) {
+    }
+    size_t drained = 0;
+    while (true) {
+      std::span<const GeneratedTick> run = moves_.front_n(256);
+      if (run.empty())
+        return drained;
+      for (const GeneratedTick &move : run)
+        on_move(move);
+      moves_.pop_n(run.size());
+      drained += run.size();
+    }
+  }
+
+  // Symbol names are fixed at construction, so any thread may read them
+  const char (&name(size_t symbol) const)[4] {
+    return generator_.name(symbol);
+  }
+  size_t symbols() const { return generator_.symbols(); }
+
+  size_t depth() const { return moves_.size_approx(); }
+  bool pinned() const { return pinned_.load(std::memory_order_relaxed); }
+
+  StageCounter generated;
+
+private:
+  void run(size_t ticks_per_ms) {
+    using Clock = std::chrono::steady_clock;
+    auto next = Clock::now();
+    while (!stopping_.load(std::memory_order_relaxed)) {
+      // Every 1ms; after a stall, carry on from now rather than burst
+      next += std::chrono::milliseconds(1);
+      auto now = Clock::now();
+      if (now > next + std::chrono::milliseconds(10))
+        next = now;
+      std::this_thread::sleep_until(next);
+
+      size_t want = ticks_per_ms;
+      while (want > 0 && !stopping_.load(std::memory_order_relaxed)) {
+        std::span<GeneratedTick> slots = moves_.claim_write_n(want);
+        if (slots.empty()) {
+          std::this_thread::yield();
+          continue;
+        }
+        generator_.generate(slots);
+        moves_.commit_write_n(slots.size());
+        generated.add(slots.size());
+        want -= slots.size();
+      }
+      char byte = 1;
+      ssize_t woke = write(wake_[1], &byte, 1);
+      (void)woke; // A full pipe already has the sequencer awake
+    }
+  }
+
+  MarketGenerator<> generator_;
+  SPSCQueue<GeneratedTick, QueueSize> moves_;
+  int wake_[2] = {-1, -1};
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> pinned_{false};
+  std::atomic<bool> started_{false};
+  std::thread thread_;
+};
+
+// Sends sequenced ticks on its own thread, up to FeedSender::SEND_BATCH per
+// call. The sequencer queues ticks with push() and calls notify() once per
+// event; the sender parks when there is nothing to send.
+template <size_t QueueSize = 1 << 16> class SenderStage {
+public:
+  SenderStage(networking::FeedSender &feed, int cpu) : feed_(feed) {
+    thread_ = std::thread([this, cpu] {
+      pinned_ = core::pin_this_thread(cpu);
+      started_.store(true, std::memory_order_release);
+      run();
+    });
+    while (!started_.load(std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  SenderStage(const SenderStage &) = delete;
+  SenderStage &operator=(const SenderStage &) = delete;
+
+  ~SenderStage() { finish(); }
+
+  // Sequencer thread. A full queue means the sender is a whole queue
+  // behind: the sequencer yields until it catches up, counted as a stall.
+  void push(const protocol::TickPacket &tick) {
+    protocol::TickPacket *slot;
+    while ((slot = ticks_.claim_write()) == nullptr) {
+      stalls_.add(1);
+      ready_.notify();
+      std::this_thread::yield();
+    }
+    *slot = tick;
+    ticks_.commit_write();
+  }
+
+  void notify() { ready_.notify(); }
+
+  // Sends whatever is still queued, then stops the thread
+  void finish() {
+    if (!thread_.joinable())
+      return;
+    stopping_.store(true, std::memory_order_release);
+    ready_.notify();
+    thread_.join();
+  }
+
+  size_t depth() const { return ticks_.size_approx(); }
+  bool pinned() const { return pinned_.load(std::memory_order_relaxed); }
+  uint64_t stalls() const { return stalls_.total(); }
+
+  StageCounter sent;    // Ticks handed to the transport
+  StageCounter batches; // send_batch calls
+
+private:
+  void run() {
+    while (true) {
+      ready_.wait_until([&] {
+        return ticks_.front() != nullptr ||
+               stopping_.load(std::memory_order_acquire);
+      });
+      std::span<const protocol::TickPacket> run =
+          ticks_.front_n(networking::FeedSender::SEND_BATCH);
+      if (run.empty()) {
+        if (stopping_.load(std::memory_order_acquire) &&
+            ticks_.front() == nullptr)
+          return;
+        continue;
+      }
+      sent.add(feed_.send_batch(run));
+      batches.add(1);
+      ticks_.pop_n(run.size());
+    }
+  }
+
+  networking::FeedSender &feed_;
+  SPSCQueue<protocol::TickPacket, QueueSize> ticks_;
+  core::BlockingWait ready_;
+  StageCounter stalls_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> pinned_{false};
+  std::atomic<bool> started_{false};
+  std::thread thread_;
+};
+
+} // namespace exchange
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+
+namespace core {
+
+// Random numbers a block at a time from Lanes independent xoshiro256++
+// streams. The state is stored by word across lanes (s0[Lanes], s1[Lanes],
+// ...), so one step of every lane is the same shifts, rotates and xors on
+// adjacent words and the compiler turns the lane loop into vector code.
+// Lane i starts 2^128 steps after lane i - 1 (xoshiro's jump), so lanes
+// never overlap. Blocks are filled lane-interleaved.
+template <size_t Lanes = 8> class RandomBlocks {
+public:
+  static constexpr size_t LANES = Lanes;
+
+  explicit RandomBlocks(uint64_t seed) {
+    // SplitMix64 expands the seed into the first lane's state
+    uint64_t first[4];
+    for (uint64_t &word : first) {
+      seed += 0x9E3779B97F4A7C15ull;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      word = z ^ (z >> 31);
+    }
+    for (size_t lane = 0; lane < Lanes; lane++) {
+      for (size_t w = 0; w < 4; w++)
+        s_[w][lane] = first[w];
+      jump(first);
+    }
+  }
+
+  // out.size() must be a multiple of Lanes
+  void fill(std::span<uint64_t> out) {
+    if (out.size() % Lanes != 0)
+      throw std::runtime_error("RandomBlocks: block not a multiple of lanes");
+    uint64_t *s0 = s_[0].data(), *s1 = s_[1].data(), *s2 = s_[2].data(),
+             *s3 = s_[3].data();
+    for (size_t i = 0; i < out.size(); i += Lanes) {
+      uint64_t *block = out.data() + i;
+      for (size_t lane = 0; lane < Lanes; lane++) {
+        block[lane] = rotl(s0[lane] + s3[lane], 23) + s0[lane];
+        const uint64_t t = s1[lane] << 17;
+        s2[lane] ^= s0[lane];
+        s3[lane] ^= s1[lane];
+        s1[lane] ^= s2[lane];
+        s0[lane] ^= s3[lane];
+        s2[lane] ^= t;
+        s3[lane] = rotl(s3[lane], 45);
+      }
+    }
+  }
+
+private:
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  static void step(uint64_t (&s)[4]) {
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+  }
+
+  // Advances s by 2^128 steps
+  static void jump(uint64_t (&s)[4]) {
+    static constexpr uint64_t JUMP[] = {0x180EC6D33CFD0ABAull,
+                                        0xD5A61266F0C9392Cull,
+                                        0xA9582618E03FC9AAull,
+                                        0x39ABDC4529B1661Cull};
+    uint64_t acc[4] = {};
+    for (uint64_t word : JUMP) {
+      for (int b = 0; b < 64; b++) {
+        if (word & (uint64_t{1} << b)) {
+          for (int w = 0; w < 4; w++)
+            acc[w] ^= s[w];
+        }
+        step(s);
+      }
+    }
+    for (int w = 0; w < 4; w++)
+      s[w] = acc[w];
+  }
+
+  std::array<std::array<uint64_t, Lanes>, 4> s_;
+};
+
+// Standard normal samples by the ziggurat method (Marsaglia and Tsang, 128
+// layers). One random word makes a sample about 99% of the time, with a
+// table lookup, a multiply and a compare; the rest call spare() for more
+// words and cost a log or an exp.
+class Ziggurat {
+public:
+  Ziggurat() {
+    x_[0] = V / f(R);
+    x_[1] = R;
+    for (size_t i = 2; i < LAYERS; i++)
+      x_[i] = std::sqrt(-2.0 * std::log(V / x_[i - 1] + f(x_[i - 1])));
+    x_[LAYERS] = 0.0;
+    for (size_t i = 0; i <= LAYERS; i++)
+      f_[i] = f(x_[i]);
+  }
+
+  // Layer from the low 7 bits, signed position from the top 53
+  template <typename Spare> double sample(uint64_t bits, Spare &&spare) const {
+    while (true) {
+      const size_t i = bits & (LAYERS - 1);
+      const double u = 2.0 * unit(bits) - 1.0;
+      const double x = u * x_[i];
+      if (std::fabs(x) < x_[i + 1])
+        return x;
+      if (i == 0) {
+        // Beyond R: the tail, by Marsaglia's method
+        double tx, ty;
+        do {
+          tx = -std::log(unit_open_zero(spare())) / R;
+          ty = -std::log(unit_open_zero(spare()));
+        } while (ty + ty < tx * tx);
+        return u < 0.0 ? -(R + tx) : R + tx;
+      }
+      if (f_[i + 1] + (f_[i] - f_[i + 1]) * unit(spare()) < f(x))
+        return x;
+      bits = spare();
+    }
+  }
+
+  // [0, 1) and (0, 1] from the top 53 bits
+  static double unit(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+  }
+  static double unit_open_zero(uint64_t bits) {
+    return static_cast<double>((bits >> 11) + 1) * 0x1.0p-53;
+  }
+
+private:
+  static constexpr size_t LAYERS = 128;
+  static constexpr double R = 3.442619855899;
+  static constexpr double V = 9.91256303526217e-3;
+
+  static double f(double x) { return std::exp(-0.5 * x * x); }
+
+  double x_[LAYERS + 1];
+  double f_[LAYERS + 1];
+};
+
+} // namespace core
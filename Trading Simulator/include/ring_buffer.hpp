@@ -30,10 +30,15 @@ public:
     versions_[index].store(v + 2, std::memory_order_release);
 
     if (seq_num > max_seq_.load(std::memory_order_relaxed)) {
-      max_seq_.store(seq_num, std::memory_order_relaxed);
+      max_seq_.store(seq_num, std::memory_order_release);
     }
   }
 
+  static constexpr size_t capacity() { return Capacity; }
+
+  // Highest sequence number pushed so far (0 = empty)
+  uint64_t newest() const { return max_seq_.load(std::memory_order_acquire); }
+
   // Called by the TCP Recovery Thread: SeqLock-protected read
   bool get(uint64_t seq_num, T &out_item) const {
     uint64_t current_max = max_seq_.load(std::memory_order_relaxed);
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "checkpoint.hpp"
+#include "huge_pages.hpp"
+#include "strategy.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace strategy {
+
+// Token bucket: up to burst orders at once, refilled at per_sec
+struct RateLimit {
+  double per_sec;
+  double burst;
+};
+
+// Per-symbol pre-trade limits
+struct RiskLimits {
+  int64_t max_position = 1000;   // |net shares| after the order
+  double max_notional = 1000000; // |net shares| * price after the order
+  RateLimit rate = {100, 20};    // Orders for this symbol
+  double price_band = 0.05;      // Max |price - reference| / reference
+};
+
+// Why an order was stopped; several can apply at once
+enum RiskReject : uint8_t {
+  RISK_OK = 0,
+  RISK_POSITION = 1,
+  RISK_NOTIONAL = 2,
+  RISK_RATE = 4,
+  RISK_PRICE_BAND = 8,
+};
+
+// Pre-trade checks for one strategy thread, shared by the strategies it
+// runs: net position, notional, per-symbol and gate-wide order rate, and a
+// fat-finger band around a reference price. Orders that reduce the
+// position always pass the position and notional checks, so a gate never
+// traps a strategy in a position. Everything a check reads or writes for a
+// symbol sits in one cache line, limits precomputed on first sight; the
+// checks are evaluated together into a mask rather than one branch each.
+// Single-threaded.
+class RiskGate {
+public:
+  explicit RiskGate(const RiskLimits &defaults = {},
+                    RateLimit total = {1000, 100})
+      : symbols_(MAX_SYMBOLS), defaults_(defaults), total_{} {
+    total_.rate_per_ns = total.per_sec * 1e-9;
+    total_.burst = total.burst;
+    total_.tokens = total.burst;
+  }
+
+  RiskGate(const RiskGate &) = delete;
+  RiskGate &operator=(const RiskGate &) = delete;
+
+  // Overrides the defaults for one symbol, keeping its position
+  void set_limits(const char (&symbol)[4], const RiskLimits &limits) {
+    configure(entry(core::symbol_key(symbol)), limits);
+  }
+
+  // Accepted orders count against the limits at once. now_ns drives the
+  // token buckets and only needs to be monotonic per gate.
+  RiskReject check(const char (&symbol)[4], protocol::Side side, double price,
+                   uint32_t quantity, double reference, int64_t now_ns) {
+    Symbol &s = entry(core::symbol_key(symbol));
+    const int64_t delta = side == protocol::Side::Buy
+                              ? int64_t{quantity}
+                              : -int64_t{quantity};
+    const int64_t next = s.position + delta;
+    const int64_t exposure = next < 0 ? -next : next;
+    const bool grows = exposure > (s.position < 0 ? -s.position : s.position);
+
+    const double tokens = refill(s, now_ns);
+    const double total_tokens = refill(total_, now_ns);
+    const double deviation = price > reference ? price - reference
+                                               : reference - price;
+
+    const unsigned reject =
+        (grows & (exposure > s.max_position)) * RISK_POSITION |
+        (grows & (static_cast<double>(exposure) * price > s.max_notional)) *
+            RISK_NOTIONAL |
+        ((tokens < 1.0) | (total_tokens < 1.0)) * RISK_RATE |
+        !(deviation <= s.band * reference) * RISK_PRICE_BAND;
+
+    const bool ok = reject == RISK_OK;
+    s.tokens = tokens - ok;
+    s.last_ns = std::max(s.last_ns, now_ns);
+    total_.tokens = total_tokens - ok;
+    total_.last_ns = std::max(total_.last_ns, now_ns);
+    s.position = ok ? next : s.position;
+    accepted_ += ok;
+    for (size_t bit = 0; bit < rejects_.size(); bit++)
+      rejects_[bit] += (reject >> bit) & 1;
+    return static_cast<RiskReject>(reject);
+  }
+
+  // Net shares the gate has let through for symbol
+  int64_t position(const char (&symbol)[4]) const {
+    uint32_t id = index_.find(core::symbol_key(symbol));
+    return id == index_.NOT_FOUND ? 0 : symbols_[id].position;
+  }
+
+  // Net position per symbol seen, for a checkpoint: limits come from the
+  // configuration and token buckets start full again on restore
+  void save_checkpoint(core::CheckpointWriter &out) const {
+    out.put(static_cast<uint64_t>(configured_));
+    for (uint32_t id = 0; id < configured_; id++) {
+      out.put(index_.key_of(id));
+      out.put(symbols_[id].position);
+    }
+  }
+
+  // Only into a gate that has let nothing through yet, and only once the
+  // whole layout checks out
+  bool restore_checkpoint(core::CheckpointReader &in) {
+    uint64_t count;
+    if (accepted_ != 0 || !in.get(count) || count > MAX_SYMBOLS ||
+        in.remaining() != count * CHECKPOINT_RECORD)
+      return false;
+    for (uint64_t i = 0; i < count; i++) {
+      uint32_t key = 0;
+      int64_t position = 0;
+      in.get(key);
+      in.get(position);
+      entry(key).position = position;
+    }
+    return true;
+  }
+
+  uint64_t accepted() const { return accepted_; }
+  // Orders stopped by one reason (a single RiskReject bit)
+  uint64_t rejected(RiskReject reason) const {
+    return rejects_[static_cast<size_t>(std::countr_zero(
+        static_cast<unsigned>(reason)))];
+  }
+
+private:
+  // One cache line: the check's limits and state together
+  struct alignas(64) Symbol {
+    int64_t max_position;
+    double max_notional;
+    double rate_per_ns;
+    double burst;
+    double band;
+    int64_t position;
+    double tokens;
+    int64_t last_ns;
+  };
+  static_assert(sizeof(Symbol) == 64);
+
+  static constexpr size_t CHECKPOINT_RECORD =
+      sizeof(uint32_t) + sizeof(int64_t);
+
+  Symbol &entry(uint32_t key) {
+    uint32_t id = index_.find_or_insert(key);
+    Symbol &s = symbols_[id];
+    if (id == configured_) {
+      configure(s, defaults_);
+      s.position = 0;
+      configured_++;
+    }
+    return s;
+  }
+
+  static void configure(Symbol &s, const RiskLimits &limits) {
+    s.max_position = limits.max_position;
+    s.max_notional = limits.max_notional;
+    s.rate_per_ns = limits.rate.per_sec * 1e-9;
+    s.burst = limits.rate.burst;
+    s.band = limits.price_band;
+    s.tokens = limits.rate.burst;
+    s.last_ns = 0;
+  }
+
+  // Tokens available at now_ns; a clock step backwards refills nothing
+  static double refill(const Symbol &bucket, int64_t now_ns) {
+    double elapsed =
+        static_cast<double>(std::max<int64_t>(now_ns - bucket.last_ns, 0));
+    return std::min(bucket.burst,
+                    bucket.tokens + elapsed * bucket.rate_per_ns);
+  }
+
+  core::SymbolIndex<MAX_SYMBOLS> index_;
+  std::vector<Symbol, core::HugePageAllocator<Symbol>> symbols_;
+  uint32_t configured_ = 0;
+  RiskLimits defaults_;
+  Symbol total_; // Gate-wide bucket; only the rate fields are used
+  uint64_t accepted_ = 0;
+  std::array<uint64_t, 4> rejects_{};
+};
+
+} // namespace strategy
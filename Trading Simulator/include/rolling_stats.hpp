@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace strategy {
+
+// Rolling mean and variance of a fixed window in O(1) per tick, without the
+// E[x^2] - E[x]^2 cancellation of running sum / sum-of-squares (at $400 the
+// two terms agree to ~10 digits and the variance loses them) and without a
+// periodic rescan to undo drift.
+//
+// State per symbol: mean, a Kahan compensation term for mean, and M2 (the
+// sum of squared deviations from the mean). Population variance = M2 / N.
+
+// mean += increment, carrying the lost low-order bits in comp so the error
+// stays bounded instead of growing with the number of ticks
+inline void add_compensated(double &mean, double &comp, double increment) {
+  double y = increment - comp;
+  double t = mean + y;
+  comp = (t - mean) - y;
+  mean = t;
+}
+
+// Warmup: x is the count-th price of a window that is not yet full
+inline void rolling_add(double &mean, double &comp, double &m2, double x,
+                        uint32_t count) {
+  double delta = x - mean;
+  add_compensated(mean, comp, delta / count);
+  m2 += delta * (x - mean);
+}
+
+// Full window of period prices: x replaces old_x (Welford's update for a
+// sliding window)
+inline void rolling_replace(double &mean, double &comp, double &m2,
+                            double old_x, double x, double period) {
+  double old_mean = mean;
+  double diff = x - old_x;
+  add_compensated(mean, comp, diff / period);
+  m2 += diff * ((x - mean) + (old_x - old_mean));
+}
+
+} // namespace strategy
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "huge_pages.hpp"
+#include "protocol.hpp"
+#include "spsc_queue.hpp"
+#include "strategy.hpp"
+#include "symbol_table.hpp"
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace strategy {
+
+// One bit per worker in the router's wakeup mask
+constexpr size_t MAX_WORKERS = 64;
+
+// Shard owning a symbol. Fibonacci hashing spreads neighbouring tickers
+// (AAPL, AAPM, ...) across shards, and the multiply-shift maps onto any
+// shard count without a modulo.
+inline size_t shard_for(uint32_t symbol_key, size_t shards) {
+  uint32_t mixed = symbol_key * 0x9E3779B1u;
+  return static_cast<size_t>((uint64_t{mixed} * shards) >> 32);
+}
+
+// One private StrategySet per shard, plus the figures each shard's worker
+// publishes after every batch. Readers sum the published atomics, so session
+// PnL is aggregated without locks and without touching worker state.
+template <typename Set> class ShardGroup {
+public:
+  ShardGroup(size_t shards, const StrategyConfig &config)
+      : ShardGroup(shards, [&](size_t) { return config; }) {}
+
+  // config_for(shard) returns that shard's StrategyConfig, e.g. to give
+  // each worker its own order sink
+  template <std::invocable<size_t> ConfigFor>
+  ShardGroup(size_t shards, ConfigFor &&config_for) : shards_(shards) {
+    if (shards == 0 || shards > MAX_WORKERS)
+      throw std::runtime_error("Worker count must be 1-" +
+                               std::to_string(MAX_WORKERS));
+    for (size_t s = 0; s < shards; s++)
+      shards_[s].strategies = std::make_unique<Set>(config_for(s));
+  }
+
+  size_t size() const { return shards_.size(); }
+
+  Set &strategies(size_t shard) { return *shards_[shard].strategies; }
+  const Set &strategies(size_t shard) const {
+    return *shards_[shard].strategies;
+  }
+
+  // Called by the shard's worker only
+  void publish(size_t shard, uint64_t processed) {
+    Shard &s = shards_[shard];
+    s.pnl.store(s.strategies->session_pnl(), std::memory_order_relaxed);
+    s.processed.store(processed, std::memory_order_release);
+  }
+
+  // Realised PnL as of each worker's last published batch
+  double session_pnl() const {
+    double total = 0.0;
+    for (const Shard &s : shards_)
+      total += s.pnl.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  uint64_t processed() const {
+    uint64_t total = 0;
+    for (const Shard &s : shards_)
+      total += s.processed.load(std::memory_order_acquire);
+    return total;
+  }
+
+private:
+  // A line per shard, so workers never write to each other's lines
+  struct alignas(64) Shard {
+    std::atomic<double> pnl{0.0};
+    std::atomic<uint64_t> processed{0};
+    std::unique_ptr<Set> strategies;
+  };
+
+  std::vector<Shard> shards_;
+};
+
+// Symbol-sharded strategy execution. A single router thread hashes each tick
+// to the worker that owns its symbol and writes it to that worker's private
+// SPSCQueue. Every symbol is handled by exactly one worker and each queue is
+// FIFO, so per-symbol tick order is preserved; symbol state is never shared,
+// so workers run without locks or atomics on the hot path.
+template <typename Set, typename Wait, size_t QueueCapacity = 4096>
+class ShardedExecutor {
+public:
+  using Queue = SPSCQueue<protocol::TickPacket, QueueCapacity,
+                          core::HugePageAllocator<protocol::TickPacket>>;
+
+  // batch_eval: on_batch over up to drain_max ticks per wakeup, otherwise
+  // on_tick one at a time
+  ShardedExecutor(ShardGroup<Set> &group, bool batch_eval, size_t drain_max)
+      : group_(group), batch_eval_(batch_eval),
+        drain_max_(batch_eval ? drain_max : 1) {
+    for (size_t s = 0; s < group.size(); s++)
+      workers_.push_back(std::make_unique<Worker>());
+    for (size_t s = 0; s < group.size(); s++)
+      workers_[s]->thread = std::thread([this, s] { run(s); });
+  }
+
+  ShardedExecutor(const ShardedExecutor &) = delete;
+  ShardedExecutor &operator=(const ShardedExecutor &) = delete;
+
+  ~ShardedExecutor() { stop(); }
+
+  size_t workers() const { return workers_.size(); }
+
+  // Called by the router thread only. Each worker is woken once per call.
+  void route(std::span<const protocol::TickPacket> ticks) {
+    uint64_t touched = 0;
+    for (const protocol::TickPacket &tick : ticks) {
+      size_t shard = shard_for(core::symbol_key(tick.symbol), workers_.size());
+      Worker &worker = *workers_[shard];
+
+      protocol::TickPacket *slot = worker.queue.claim_write();
+      if (slot == nullptr) {
+        // Backpressure: the worker may be parked on ticks we have not
+        // announced yet
+        worker.data_ready.notify();
+        worker.space_free.wait_until(
+            [&] { return (slot = worker.queue.claim_write()) != nullptr; });
+      }
+      *slot = tick;
+      worker.queue.commit_write();
+      touched |= uint64_t{1} << shard;
+    }
+
+    for (; touched != 0; touched &= touched - 1)
+      workers_[std::countr_zero(touched)]->data_ready.notify();
+  }
+
+  // Lets every worker drain its queue, then joins them
+  void stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel))
+      return;
+    for (auto &worker : workers_)
+      worker->data_ready.notify();
+    for (auto &worker : workers_)
+      worker->thread.join();
+  }
+
+private:
+  struct Worker {
+    Queue queue;
+    Wait data_ready;
+    Wait space_free;
+    std::thread thread;
+  };
+
+  void run(size_t shard) {
+    Worker &worker = *workers_[shard];
+    Set &strategies = group_.strategies(shard);
+    uint64_t processed = 0;
+
+    while (true) {
+      std::span<const protocol::TickPacket> ticks;
+      worker.data_ready.wait_until([&] {
+        // Read the flag first: ticks routed before stop() are then visible
+        bool stopping = !running_.load(std::memory_order_acquire);
+        ticks = worker.queue.front_n(drain_max_);
+        return !ticks.empty() || stopping;
+      });
+      if (ticks.empty())
+        break;
+
+      if (batch_eval_) {
+        strategies.on_batch(ticks);
+      } else {
+        for (const protocol::TickPacket &tick : ticks)
+          strategies.on_tick(tick);
+      }
+      processed += ticks.size();
+
+      worker.queue.pop_n(ticks.size());
+      worker.space_free.notify();
+      group_.publish(shard, processed);
+    }
+  }
+
+  ShardGroup<Set> &group_;
+  const bool batch_eval_;
+  const size_t drain_max_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> running_{true};
+};
+
+} // namespace strategy
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace core {
+
+// POSIX shared memory segment mapped into this process. The creator owns the
+// name and unlinks it on destruction, attachers only unmap their view.
+// Names must start with '/' and stay under 31 characters (macOS limit).
+class SharedMemory {
+public:
+  // Called by the producer process: creates (or replaces) the named segment
+  static SharedMemory create(const std::string &name, size_t size) {
+    shm_unlink(name.c_str()); // Clear a stale segment from a crashed run
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+      throw std::runtime_error("Failed to create shared memory " + name);
+
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error("Failed to size shared memory " + name);
+    }
+
+    void *addr = map(fd, size);
+    close(fd);
+    if (addr == nullptr) {
+      shm_unlink(name.c_str());
+      throw std::runtime_error("Failed to map shared memory " + name);
+    }
+    return SharedMemory(name, addr, size, true);
+  }
+
+  // Called by consumer processes: maps an existing segment at its full size
+  static SharedMemory attach(const std::string &name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+      throw std::runtime_error("Failed to open shared memory " + name);
+
+    struct stat st {};
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+      close(fd);
+      throw std::runtime_error("Failed to stat shared memory " + name);
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void *addr = map(fd, size);
+    close(fd);
+    if (addr == nullptr)
+      throw std::runtime_error("Failed to map shared memory " + name);
+    return SharedMemory(name, addr, size, false);
+  }
+
+  SharedMemory(SharedMemory &&other) noexcept
+      : name_(std::move(other.name_)),
+        addr_(std::exchange(other.addr_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        owner_(std::exchange(other.owner_, false)) {}
+
+  SharedMemory &operator=(SharedMemory &&other) noexcept {
+    if (this != &other) {
+      release();
+      name_ = std::move(other.name_);
+      addr_ = std::exchange(other.addr_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      owner_ = std::exchange(other.owner_, false);
+    }
+    return *this;
+  }
+
+  SharedMemory(const SharedMemory &) = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+
+  ~SharedMemory() { release(); }
+
+  void *data() const { return addr_; }
+  size_t size() const { return size_; }
+
+private:
+  SharedMemory(std::string name, void *addr, size_t size, bool owner)
+      : name_(std::move(name)), addr_(addr), size_(size), owner_(owner) {}
+
+  static void *map(int fd, size_t size) {
+    void *addr =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+  }
+
+  void release() {
+    if (addr_ != nullptr) {
+      munmap(addr_, size_);
+      addr_ = nullptr;
+    }
+    if (owner_) {
+      shm_unlink(name_.c_str());
+      owner_ = false;
+    }
+  }
+
+  std::string name_;
+  void *addr_ = nullptr;
+  size_t size_ = 0;
+  bool owner_ = false;
+};
+
+} // namespace core
@@ -1,54 +1,127 @@
 #pragma once
 
-#include "protocol.hpp"
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <memory>
+#include <span>
 #include <vector>
 
 // Zero-Copy Single-Producer Single-Consumer (SPSC) Ring Buffer
-template <size_t Capacity> class SPSCQueue {
+//
+// Indices run freely and are masked into the buffer, so Capacity must be a
+// power of two and every slot is usable. Each side keeps a cached copy of the
+// other side's index and only re-reads the shared atomic when the cache says
+// the queue looks full (producer) or empty (consumer). The Allocator places
+// the slot storage (e.g. core::HugePageAllocator for huge pages).
+template <typename T, size_t Capacity, typename Allocator = std::allocator<T>>
+class SPSCQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SPSCQueue capacity must be a power of two");
+
+  static constexpr size_t MASK = Capacity - 1;
+
 private:
-  std::vector<protocol::TickPacket> buffer;
+  std::vector<T, Allocator> buffer;
 
-  // alignas isolates the CPU cache lines, preventing false sharing
+  // alignas isolates the CPU cache lines, preventing false sharing. Each
+  // line holds one side's index together with its private cached copy of
+  // the other side's index.
   alignas(64) std::atomic<size_t> head{0};
+  size_t cached_tail = 0; // Consumer-owned
+
   alignas(64) std::atomic<size_t> tail{0};
+  size_t cached_head = 0; // Producer-owned
 
 public:
   SPSCQueue() : buffer(Capacity) {}
 
   // Called by the Network Thread: Requests a raw pointer to an empty
   // memory slot
-  protocol::TickPacket *claim_write() {
+  T *claim_write() {
     size_t current_tail = tail.load(std::memory_order_relaxed);
-    size_t next_tail = (current_tail + 1) % Capacity;
-    if (next_tail == head.load(std::memory_order_acquire)) {
-      return nullptr; // Queue full
+    if (current_tail - cached_head == Capacity) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (current_tail - cached_head == Capacity) {
+        return nullptr; // Queue full
+      }
     }
-    return &buffer[current_tail];
+    return &buffer[current_tail & MASK];
   }
 
   // Called by the Network Thread: Officially publishes the data block to
   // the Strategy Thread
   void commit_write() {
     size_t current_tail = tail.load(std::memory_order_relaxed);
-    tail.store((current_tail + 1) % Capacity, std::memory_order_release);
+    tail.store(current_tail + 1, std::memory_order_release);
+  }
+
+  // Called by the Network Thread: Claims up to max contiguous empty slots.
+  // The span stops at the end of the buffer, so a wrap takes two claims.
+  std::span<T> claim_write_n(size_t max) {
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    size_t free = Capacity - (current_tail - cached_head);
+    if (free < max) {
+      cached_head = head.load(std::memory_order_acquire);
+      free = Capacity - (current_tail - cached_head);
+    }
+    size_t index = current_tail & MASK;
+    size_t n = std::min({max, free, Capacity - index});
+    return {buffer.data() + index, n};
+  }
+
+  // Called by the Network Thread: Publishes the first n claimed slots with a
+  // single release store
+  void commit_write_n(size_t n) {
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    tail.store(current_tail + n, std::memory_order_release);
   }
 
   // Called by the Strategy Thread: Peeks at the oldest available data
   // without copying it
-  const protocol::TickPacket *front() {
+  const T *front() {
     size_t current_head = head.load(std::memory_order_relaxed);
-    if (current_head == tail.load(std::memory_order_acquire)) {
-      return nullptr; // Queue empty
+    if (current_head == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      if (current_head == cached_tail) {
+        return nullptr; // Queue empty
+      }
     }
-    return &buffer[current_head];
+    return &buffer[current_head & MASK];
   }
 
   // Called by the Strategy Thread: Releases the memory slot back to the
   // Network Thread
   void pop() {
     size_t current_head = head.load(std::memory_order_relaxed);
-    head.store((current_head + 1) % Capacity, std::memory_order_release);
+    head.store(current_head + 1, std::memory_order_release);
   }
+
+  // Called by the Strategy Thread: Peeks at up to max contiguous items
+  std::span<const T> front_n(size_t max) {
+    size_t current_head = head.load(std::memory_order_relaxed);
+    size_t available = cached_tail - current_head;
+    if (available < max) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      available = cached_tail - current_head;
+    }
+    size_t index = current_head & MASK;
+    size_t n = std::min({max, available, Capacity - index});
+    return {buffer.data() + index, n};
+  }
+
+  // Called by the Strategy Thread: Releases n slots with one release store
+  void pop_n(size_t n) {
+    size_t current_head = head.load(std::memory_order_relaxed);
+    head.store(current_head + n, std::memory_order_release);
+  }
+
+  // Approximate occupancy, safe to call from any thread (metrics only)
+  size_t size_approx() const {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_relaxed);
+    return t >= h ? t - h : 0;
+  }
+
+  static constexpr size_t capacity() { return Capacity; }
 };
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "bollinger_simd.hpp"
+#include "checkpoint.hpp"
+#include "indicators.hpp"
+#include "order_sink.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace core {
+class BboBoard;
+}
+
+namespace strategy {
+
+// Default universe size for per-strategy symbol tables
+constexpr size_t MAX_SYMBOLS = size_t{1} << 17;
+
+class RiskGate;
+
+// Settings shared by every strategy in a set
+struct StrategyConfig {
+  SimdLevel simd = detect_simd();
+  // Order entry for the thread running the set; nullptr trades locally only
+  OrderSink *orders = nullptr;
+  // Top of book per symbol from the book feed; nullptr with --book=off
+  const core::BboBoard *bbo = nullptr;
+  // Pre-trade checks for the thread running the set; nullptr trades
+  // unchecked
+  RiskGate *risk = nullptr;
+  // Indicators shared by the strategies of a set; StrategySet fills it in
+  IndicatorEngine *indicators = nullptr;
+};
+
+// What a strategy must provide to be composed into a StrategySet. Each
+// strategy owns its symbol state and PnL; nothing is shared between them.
+template <typename S>
+concept TickStrategy =
+    std::constructible_from<S, const StrategyConfig &> &&
+    requires(S strategy, const S &view, const protocol::TickPacket &tick,
+             std::span<const protocol::TickPacket> ticks, std::ostream &out) {
+      strategy.on_tick(tick);
+      strategy.on_batch(ticks);
+      { view.name() } -> std::convertible_to<std::string>;
+      { view.session_pnl() } -> std::convertible_to<double>;
+      { view.report_open_positions(out) } -> std::convertible_to<double>;
+    };
+
+// Optional: a strategy that can save its state and resume from it. restore
+// runs on a freshly constructed strategy and returns false, leaving it
+// untouched, if the data does not match its layout.
+template <typename S>
+concept Checkpointable =
+    requires(S strategy, const S &view, core::CheckpointWriter &out,
+             core::CheckpointReader &in) {
+      view.save_checkpoint(out);
+      { strategy.restore_checkpoint(in) } -> std::same_as<bool>;
+    };
+
+// Optional: a strategy that can be primed with recent history before going
+// live. warm_up updates its state as on_tick would but never trades.
+template <typename S>
+concept WarmStartable =
+    requires(S strategy, const S &view,
+             std::span<const protocol::TickPacket> ticks) {
+      strategy.warm_up(ticks);
+      { view.warmup_ticks() } -> std::convertible_to<size_t>;
+      { view.ready_symbols() } -> std::convertible_to<size_t>;
+      { view.symbols() } -> std::convertible_to<size_t>;
+    };
+
+// Strategies composed at compile time into one tick handler. on_tick is a
+// fold over the tuple, so every call is direct and inlinable: no virtual
+// dispatch, no per-strategy loop. The set owns the IndicatorEngine its
+// strategies share and advances it before they see each tick.
+template <TickStrategy... Strategies> class StrategySet {
+  static_assert(sizeof...(Strategies) > 0, "StrategySet needs a strategy");
+
+public:
+  static constexpr size_t size() { return sizeof...(Strategies); }
+
+  // Every strategy is constructed in place from the same config
+  explicit StrategySet(const StrategyConfig &config = {})
+      : indicators_(MAX_SYMBOLS),
+        strategies_(((void)sizeof(Strategies), with_indicators(config))...) {}
+
+  void on_tick(const protocol::TickPacket &tick) {
+    if (!indicators_.empty())
+      indicators_.on_tick(tick);
+    std::apply([&](auto &...s) { (s.on_tick(tick), ...); }, strategies_);
+  }
+
+  // Shared indicators hold one state per symbol, so a set that declared
+  // any walks the batch tick by tick (the same decisions either way)
+  void on_batch(std::span<const protocol::TickPacket> ticks) {
+    if (!indicators_.empty()) {
+      for (const protocol::TickPacket &tick : ticks)
+        on_tick(tick);
+      return;
+    }
+    std::apply([&](auto &...s) { (s.on_batch(ticks), ...); }, strategies_);
+  }
+
+  // Visits each strategy in registration order
+  template <typename F> void for_each(F &&visit) const {
+    std::apply([&](const auto &...s) { (visit(s), ...); }, strategies_);
+  }
+
+  double session_pnl() const {
+    double total = 0.0;
+    for_each([&](const auto &s) { total += s.session_pnl(); });
+    return total;
+  }
+
+  // Primes the shared indicators and every WarmStartable strategy with
+  // history, oldest tick first, without trading
+  void warm_up(std::span<const protocol::TickPacket> ticks) {
+    if (!indicators_.empty()) {
+      for (const protocol::TickPacket &tick : ticks)
+        indicators_.on_tick(tick);
+    }
+    std::apply(
+        [&](auto &...s) {
+          auto warm = [&](auto &strategy) {
+            if constexpr (WarmStartable<std::decay_t<decltype(strategy)>>)
+              strategy.warm_up(ticks);
+          };
+          (warm(s), ...);
+        },
+        strategies_);
+  }
+
+  // Ticks of history per symbol that make the whole set ready to trade
+  size_t warmup_ticks() const {
+    size_t ticks = indicators_.max_period();
+    for_each([&](const auto &s) {
+      if constexpr (WarmStartable<std::decay_t<decltype(s)>>)
+        ticks = std::max<size_t>(ticks, s.warmup_ticks());
+    });
+    return ticks;
+  }
+
+  // Each strategy's name and state, in registration order; strategies that
+  // are not Checkpointable save nothing and restart cold
+  void save_checkpoint(core::CheckpointWriter &out) const {
+    for_each([&](const auto &s) {
+      std::string name = s.name();
+      out.put(static_cast<uint32_t>(name.size()));
+      out.put_bytes(name.data(), name.size());
+      size_t length_at = out.size();
+      out.put(uint64_t{0});
+      size_t start = out.size();
+      if constexpr (Checkpointable<std::decay_t<decltype(s)>>)
+        s.save_checkpoint(out);
+      out.patch(length_at, static_cast<uint64_t>(out.size() - start));
+    });
+  }
+
+  // Restores a freshly constructed set from save_checkpoint's output. False
+  // if the strategies differ from the saved ones or a strategy rejects its
+  // state; the set may then be partly restored and should be discarded.
+  bool restore_checkpoint(core::CheckpointReader &in) {
+    bool ok = true;
+    std::apply(
+        [&](auto &...s) { ((ok = ok && restore_one(s, in)), ...); },
+        strategies_);
+    return ok && in.remaining() == 0;
+  }
+
+private:
+  template <typename S>
+  static bool restore_one(S &strategy, core::CheckpointReader &in) {
+    uint32_t name_size;
+    uint64_t length;
+    std::string name;
+    if (!in.get(name_size) || name_size > in.remaining())
+      return false;
+    name.resize(name_size);
+    if (!in.get_bytes(name.data(), name_size) || name != strategy.name() ||
+        !in.get(length))
+      return false;
+    std::optional<core::CheckpointReader> state = in.sub(length);
+    if (!state)
+      return false;
+    if constexpr (Checkpointable<S>)
+      return strategy.restore_checkpoint(*state) && state->remaining() == 0;
+    else
+      return length == 0;
+  }
+
+  StrategyConfig with_indicators(StrategyConfig config) {
+    config.indicators = &indicators_;
+    return config;
+  }
+
+  IndicatorEngine indicators_;
+  std::tuple<Strategies...> strategies_;
+};
+
+} // namespace strategy
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "chunked_vector.hpp"
+#include "huge_pages.hpp"
+#include "symbol_table.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace strategy {
+
+// Where in its window a symbol is. 4 bytes, so 16 symbols share a line.
+struct WindowCursor {
+  uint16_t count = 0; // Prices collected so far (warmup until == Period)
+  uint16_t idx = 0;   // Oldest price once the window is full
+};
+
+// Reporting data, only written when a position closes
+struct SymbolReport {
+  double pnl = 0.0;
+  int trades = 0;
+};
+
+// Per-symbol strategy state as a structure of arrays, indexed by the dense
+// symbol ID from SymbolIndex:
+//  - hot: the rolling statistics (see rolling_stats.hpp) and position
+//    fields read on every tick, one flat column each, sized for MaxSymbols
+//    up front (a few MB in total)
+//  - windows: the Period prices of each symbol back to back in 2 MB chunks,
+//    allocated as symbols appear
+//  - cold: reporting fields, kept out of the lines the tick path touches
+template <size_t Period, size_t MaxSymbols> class StateStore {
+  static_assert(Period > 0 && Period <= UINT16_MAX, "Window must fit cursor");
+
+  // Hot columns share one allocation, each starting 7 cache lines further
+  // into a 4 KB page than the last. Columns of equal element size would
+  // otherwise place mean[id], m2[id], ... at the same page offset, where
+  // loads falsely wait on earlier stores (4K aliasing) and every column
+  // competes for the same L1 set.
+  static constexpr size_t COLUMN_STAGGER = 7 * 64;
+
+  static constexpr size_t column_bytes(size_t element) {
+    return (MaxSymbols * element + 63) / 64 * 64 + COLUMN_STAGGER;
+  }
+
+  static constexpr size_t HOT_BYTES =
+      4 * column_bytes(sizeof(double)) + column_bytes(sizeof(WindowCursor)) +
+      column_bytes(sizeof(int8_t)) + column_bytes(sizeof(uint16_t));
+
+public:
+  using Window = std::array<double, Period>;
+
+  // Per-symbol bytes across all columns, for reports
+  static constexpr size_t BYTES_PER_SYMBOL =
+      4 * sizeof(double) + sizeof(WindowCursor) + sizeof(int8_t) +
+      sizeof(uint16_t) + sizeof(Window) + sizeof(SymbolReport);
+
+  StateStore()
+      : windows(MaxSymbols), report(MaxSymbols),
+        hot_(static_cast<std::byte *>(core::huge_allocate(HOT_BYTES))) {
+    size_t offset = 0;
+    mean = carve<double>(offset);
+    mean_comp = carve<double>(offset);
+    m2 = carve<double>(offset);
+    entry_price = carve<double>(offset);
+    cursor = carve<WindowCursor>(offset);
+    position = carve<int8_t>(offset);
+    ticks_held = carve<uint16_t>(offset);
+  }
+
+  StateStore(const StateStore &) = delete;
+  StateStore &operator=(const StateStore &) = delete;
+
+  ~StateStore() { core::huge_deallocate(hot_, HOT_BYTES); }
+
+  // Dense ID for the symbol, giving it a zeroed window on first sight
+  uint32_t id_for(uint32_t key) {
+    uint32_t id = index.find_or_insert(key);
+    if (id == windows.size()) {
+      windows.emplace_back();
+    }
+    return id;
+  }
+
+  size_t size() const { return windows.size(); }
+
+  // The last price inserted into the window is the current market value
+  double last_price(uint32_t id) const {
+    const WindowCursor &c = cursor[id];
+    if (c.count < Period)
+      return windows[id][c.count - 1];
+    return windows[id][c.idx == 0 ? Period - 1 : c.idx - 1];
+  }
+
+  core::SymbolIndex<MaxSymbols> index;
+
+  // Hot
+  double *mean;
+  double *mean_comp; // Kahan compensation for mean
+  double *m2;        // Sum of squared deviations from mean
+  double *entry_price;
+  WindowCursor *cursor;
+  int8_t *position; // 0 = flat, 1 = bought
+  uint16_t *ticks_held;
+
+  // Windows
+  core::ChunkedVector<Window> windows;
+
+  // Cold
+  std::vector<SymbolReport, core::HugePageAllocator<SymbolReport>> report;
+
+private:
+  // Next zero-initialised column; every column size is a multiple of 64
+  template <typename T> T *carve(size_t &offset) {
+    T *column = reinterpret_cast<T *>(hot_ + offset);
+    std::uninitialized_value_construct_n(column, MaxSymbols);
+    offset += column_bytes(sizeof(T));
+    return column;
+  }
+
+  std::byte *hot_;
+};
+
+} // namespace strategy
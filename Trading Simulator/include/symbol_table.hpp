@@ -0,0 +1,169 @@
+#pragma once
+
+#include "chunked_vector.hpp"
+#include "huge_pages.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// The 4-byte wire symbol reinterpreted as an integer key
+inline uint32_t symbol_key(const char (&symbol)[4]) {
+  uint32_t key;
+  std::memcpy(&key, symbol, sizeof(key));
+  return key;
+}
+
+// Printable form of a key (wire symbols are not always NUL-terminated)
+inline std::string symbol_name(uint32_t key) {
+  char chars[4];
+  std::memcpy(chars, &key, sizeof(chars));
+  return std::string(chars, strnlen(chars, sizeof(chars)));
+}
+
+inline std::string_view symbol_view(const char (&symbol)[4]) {
+  return std::string_view(symbol, strnlen(symbol, sizeof(symbol)));
+}
+
+// Maps symbol keys to dense IDs 0..size()-1 in first-seen order. Open
+// addressing with linear probing over 8-byte (key, id) slots: a lookup is a
+// multiply, a shift and usually one cache line. The table is sized for
+// MaxSymbols up front (load factor <= 0.5), so it never rehashes and never
+// allocates after construction. Key 0 (the all-NUL symbol) marks empty
+// slots, so its ID is kept outside the table.
+template <size_t MaxSymbols> class SymbolIndex {
+  static constexpr size_t bit_width(size_t n) {
+    size_t bits = 0;
+    while ((size_t{1} << bits) < n)
+      bits++;
+    return bits;
+  }
+
+public:
+  static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+  static constexpr size_t BITS = bit_width(MaxSymbols * 2);
+  static constexpr size_t SLOTS = size_t{1} << BITS;
+  static constexpr size_t MASK = SLOTS - 1;
+
+  SymbolIndex() : slots_(SLOTS), keys_(MaxSymbols) {}
+
+  // Dense ID for key, assigning the next free one on first sight
+  uint32_t find_or_insert(uint32_t key) {
+    if (key == EMPTY) {
+      if (empty_key_id_ == NOT_FOUND)
+        empty_key_id_ = assign(key);
+      return empty_key_id_;
+    }
+    size_t pos = hash(key);
+    while (true) {
+      Slot &slot = slots_[pos];
+      if (slot.key == EMPTY) {
+        slot.id = assign(key);
+        slot.key = key;
+        return slot.id;
+      }
+      if (slot.key == key)
+        return slot.id;
+      pos = (pos + 1) & MASK;
+    }
+  }
+
+  uint32_t find(uint32_t key) const {
+    if (key == EMPTY)
+      return empty_key_id_;
+    size_t pos = hash(key);
+    while (true) {
+      const Slot &slot = slots_[pos];
+      if (slot.key == EMPTY)
+        return NOT_FOUND;
+      if (slot.key == key)
+        return slot.id;
+      pos = (pos + 1) & MASK;
+    }
+  }
+
+  uint32_t key_of(uint32_t id) const { return keys_[id]; }
+  size_t size() const { return size_; }
+  bool full() const { return size_ == MaxSymbols; }
+
+private:
+  // Next dense ID, recorded against key
+  uint32_t assign(uint32_t key) {
+    if (size_ == MaxSymbols)
+      throw std::length_error("SymbolIndex is full");
+    keys_[size_] = key;
+    return static_cast<uint32_t>(size_++);
+  }
+
+  static constexpr uint32_t EMPTY = 0;
+
+  struct Slot {
+    uint32_t key = EMPTY;
+    uint32_t id = 0;
+  };
+
+  // Fibonacci hashing: the top bits of key * 2^32/phi
+  static size_t hash(uint32_t key) {
+    return static_cast<uint32_t>(key * 0x9E3779B1u) >> (32 - BITS);
+  }
+
+  std::vector<Slot, HugePageAllocator<Slot>> slots_;
+  std::vector<uint32_t, HugePageAllocator<uint32_t>> keys_;
+  size_t size_ = 0;
+  uint32_t empty_key_id_ = NOT_FOUND;
+};
+
+// Flat symbol -> V table. Values are stored densely by symbol ID in chunks
+// that never move, so the reference returned for a symbol stays valid for the
+// table's lifetime and memory grows with the symbols actually seen.
+template <typename V, size_t MaxSymbols> class SymbolTable {
+public:
+  SymbolTable() : values_(MaxSymbols) {}
+
+  // Returns the symbol's value, constructing it from args on first sight
+  template <typename... Args>
+  V &find_or_insert(uint32_t key, Args &&...args) {
+    uint32_t id = index_.find_or_insert(key);
+    if (id == values_.size()) {
+      values_.emplace_back(std::forward<Args>(args)...);
+    }
+    return values_[id];
+  }
+
+  V *find(uint32_t key) {
+    uint32_t id = index_.find(key);
+    return id == SymbolIndex<MaxSymbols>::NOT_FOUND ? nullptr : &values_[id];
+  }
+  const V *find(uint32_t key) const {
+    uint32_t id = index_.find(key);
+    return id == SymbolIndex<MaxSymbols>::NOT_FOUND ? nullptr : &values_[id];
+  }
+
+  // Visits (key, value) in first-seen order
+  template <typename F> void for_each(F &&visit) const {
+    for (size_t id = 0; id < values_.size(); id++) {
+      visit(index_.key_of(static_cast<uint32_t>(id)), values_[id]);
+    }
+  }
+  template <typename F> void for_each(F &&visit) {
+    for (size_t id = 0; id < values_.size(); id++) {
+      visit(index_.key_of(static_cast<uint32_t>(id)), values_[id]);
+    }
+  }
+
+  size_t size() const { return values_.size(); }
+  // No room for another symbol: find_or_insert of a new key would throw
+  bool full() const { return index_.full(); }
+
+private:
+  SymbolIndex<MaxSymbols> index_;
+  ChunkedVector<V> values_;
+};
+
+} // namespace core
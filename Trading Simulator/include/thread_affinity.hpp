@@ -0,0 +1,25 @@
+#pragma once
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace core {
+
+// Pins the calling thread to one core; cpu < 0 leaves it where it is.
+// False if the pin failed or the platform has no hard affinity (macOS).
+inline bool pin_this_thread(int cpu) {
+  if (cpu < 0)
+    return false;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+} // namespace core
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace core {
+
+// A precomputed tick stream on disk: a 32-byte header and then TickPackets
+// exactly as they go on the feed, except that timestamp holds the tick's
+// offset in nanoseconds from the start of the stream (its send time at 1x)
+// and sequence_num its position from 1. Replay stamps both afresh.
+struct TickFileHeader {
+  uint64_t magic;
+  uint64_t ticks;
+  uint64_t seed;         // Generator seed, to regenerate the same stream
+  uint64_t ticks_per_ms; // Rate the offsets were laid out at
+};
+
+static_assert(sizeof(TickFileHeader) == sizeof(protocol::TickPacket),
+              "Ticks stay 32-byte aligned after the header");
+
+constexpr uint64_t TICK_FILE_MAGIC = 0x314C49464B434954; // "TICKFIL1"
+
+// Appends ticks to a new tick file; the header's count is written last, so
+// a file cut short by a crash is rejected on open instead of replayed.
+class TickFileWriter {
+public:
+  TickFileWriter(const std::string &path, uint64_t seed,
+                 uint64_t ticks_per_ms)
+      : path_(path) {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+      throw std::runtime_error("Failed to create tick file " + path);
+    header_ = {0, 0, seed, ticks_per_ms};
+    write_all(&header_, sizeof(header_));
+  }
+
+  TickFileWriter(const TickFileWriter &) = delete;
+  TickFileWriter &operator=(const TickFileWriter &) = delete;
+
+  ~TickFileWriter() {
+    if (fd_ >= 0)
+      close(fd_);
+  }
+
+  void append(std::span<const protocol::TickPacket> ticks) {
+    write_all(ticks.data(), ticks.size_bytes());
+    header_.ticks += ticks.size();
+  }
+
+  // Seals the file: magic and tick count go into the header
+  void finish() {
+    header_.magic = TICK_FILE_MAGIC;
+    if (pwrite(fd_, &header_, sizeof(header_), 0) !=
+            static_cast<ssize_t>(sizeof(header_)) ||
+        fsync(fd_) < 0)
+      throw std::runtime_error("Failed to seal tick file " + path_);
+    close(fd_);
+    fd_ = -1;
+  }
+
+  uint64_t ticks() const { return header_.ticks; }
+
+private:
+  void write_all(const void *data, size_t bytes) {
+    const char *p = static_cast<const char *>(data);
+    while (bytes > 0) {
+      ssize_t n = write(fd_, p, bytes);
+      if (n <= 0)
+        throw std::runtime_error("Failed to write tick file " + path_);
+      p += n;
+      bytes -= static_cast<size_t>(n);
+    }
+  }
+
+  std::string path_;
+  int fd_ = -1;
+  TickFileHeader header_{};
+};
+
+// A tick file mapped read-only. Pages come in on first touch; prefault()
+// reads them all in up front, so a replay does not take its page faults
+// while it is sending.
+class MappedTickFile {
+public:
+  explicit MappedTickFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Failed to open tick file " + path);
+    struct stat st {};
+    if (fstat(fd, &st) < 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(TickFileHeader)) {
+      close(fd);
+      throw std::runtime_error("Not a tick file: " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+      throw std::runtime_error("Failed to map tick file " + path);
+    base_ = static_cast<const std::byte *>(addr);
+    madvise(addr, size_, MADV_SEQUENTIAL);
+
+    const TickFileHeader &h = header();
+    if (h.magic != TICK_FILE_MAGIC ||
+        h.ticks > (size_ - sizeof(h)) / sizeof(protocol::TickPacket)) {
+      munmap(addr, size_);
+      throw std::runtime_error("Tick file " + path +
+                               " is incomplete or not a tick file");
+    }
+  }
+
+  MappedTickFile(const MappedTickFile &) = delete;
+  MappedTickFile &operator=(const MappedTickFile &) = delete;
+
+  ~MappedTickFile() { munmap(const_cast<std::byte *>(base_), size_); }
+
+  const TickFileHeader &header() const {
+    return *reinterpret_cast<const TickFileHeader *>(base_);
+  }
+
+  std::span<const protocol::TickPacket> ticks() const {
+    return {reinterpret_cast<const protocol::TickPacket *>(
+                base_ + sizeof(TickFileHeader)),
+            header().ticks};
+  }
+
+  size_t bytes() const { return size_; }
+
+  // Starts readahead of the whole file, then reads a byte of every page to
+  // map it. The sum goes to a volatile, or the loop would compile away.
+  // Returns the number of pages touched.
+  [[nodiscard]] size_t prefault() const {
+    madvise(const_cast<std::byte *>(base_), size_, MADV_WILLNEED);
+    uint64_t sum = 0;
+    size_t pages = 0;
+    for (size_t i = 0; i < size_; i += 4096, pages++)
+      sum += static_cast<uint8_t>(base_[i]);
+    volatile uint64_t sink = sum;
+    (void)sink;
+    return pages;
+  }
+
+private:
+  const std::byte *base_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace core
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "flat_id_map.hpp"
+#include "protocol.hpp"
+#include "symbol_table.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace core {
+
+// Appends to out the last `depth` ticks of each symbol in keys (empty =
+// every symbol) still held by a tick RingBuffer, oldest first. The ring is
+// walked from its newest sequence number back, so a busy Publisher only
+// overwrites ticks the walk has not reached yet; those are left out. With
+// keys given, the walk stops once every symbol has its depth. Sequence
+// numbers start at 1. Returns the sequence number the history is complete
+// up to (0 if the ring is empty).
+template <typename Ring>
+uint64_t collect_history(const Ring &ring, uint32_t depth,
+                         std::span<const uint32_t> keys,
+                         std::vector<protocol::TickPacket> &out) {
+  const uint64_t newest = ring.newest();
+  if (newest == 0 || depth == 0)
+    return newest;
+  const uint64_t oldest =
+      newest >= Ring::capacity() ? newest - Ring::capacity() + 1 : 1;
+
+  // Dense ID per symbol and its ticks so far; requested symbols are
+  // registered up front, so any other symbol is skipped
+  FlatIdMap ids(keys.empty() ? Ring::capacity() : keys.size());
+  std::vector<uint32_t> counts;
+  for (uint32_t key : keys) {
+    if (ids.insert(key, static_cast<uint32_t>(counts.size())))
+      counts.push_back(0);
+  }
+  size_t unfilled = counts.size();
+
+  const size_t first = out.size();
+  protocol::TickPacket tick;
+  for (uint64_t seq = newest; seq >= oldest; seq--) {
+    if (!ring.get(seq, tick) || tick.price <= 0.0)
+      continue;
+    uint32_t key = symbol_key(tick.symbol);
+    uint32_t id = ids.find(key);
+    if (id == FlatIdMap::NOT_FOUND) {
+      if (!keys.empty())
+        continue;
+      id = static_cast<uint32_t>(counts.size());
+      ids.insert(key, id);
+      counts.push_back(0);
+    }
+    if (counts[id] == depth)
+      continue;
+    out.push_back(tick);
+    if (++counts[id] == depth && !keys.empty() && --unfilled == 0)
+      break;
+  }
+  std::reverse(out.begin() + static_cast<ptrdiff_t>(first), out.end());
+  return newest;
+}
+
+} // namespace core
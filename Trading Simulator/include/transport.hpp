@@ -0,0 +1,171 @@
+#pragma once
+
+#include "broadcast_ring.hpp"
+#include "networking.hpp"
+#include "protocol.hpp"
+#include "shared_memory.hpp"
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace networking {
+
+// How ticks travel from the Publisher to the Subscriber. UDP multicast is the
+// production path; the shared-memory ring takes the kernel out of the loop
+// for single-host benchmarking. TCP recovery is used by both.
+enum class Transport { Udp, SharedMemory };
+
+inline Transport parse_transport(const std::string &name) {
+  if (name == "udp")
+    return Transport::Udp;
+  if (name == "shm")
+    return Transport::SharedMemory;
+  throw std::runtime_error("Unknown transport '" + name + "' (udp|shm)");
+}
+
+inline const char *transport_name(Transport transport) {
+  return transport == Transport::Udp ? "udp" : "shm";
+}
+
+const std::string FEED_SHM_NAME = "/hft_tick_feed";
+
+// 256k slots = ~10ms of headroom at 25M ticks/sec before a reader is lapped
+using FeedRing = core::BroadcastRing<protocol::TickPacket, 1 << 18>;
+
+// Publisher side of the tick feed
+class FeedSender {
+public:
+  FeedSender(Transport transport, const std::string &multicast_ip, int port)
+      : transport_(transport) {
+    if (transport_ == Transport::Udp) {
+      sock_ = create_udp_multicast_sender(multicast_ip, port, addr_);
+    } else {
+      shm_.emplace(core::SharedMemory::create(FEED_SHM_NAME, sizeof(FeedRing)));
+      ring_ = FeedRing::create_in(*shm_);
+    }
+  }
+
+  FeedSender(const FeedSender &) = delete;
+  FeedSender &operator=(const FeedSender &) = delete;
+
+  ~FeedSender() {
+    if (sock_ >= 0)
+      close(sock_);
+  }
+
+  // Returns true once the tick has been handed to the transport
+  bool send(const protocol::TickPacket &tick) {
+    if (transport_ == Transport::SharedMemory) {
+      ring_->publish(tick);
+      return true;
+    }
+    ssize_t sent = sendto(sock_, &tick, sizeof(protocol::TickPacket), 0,
+                          (struct sockaddr *)&addr_, sizeof(addr_));
+    return sent > 0;
+  }
+
+  static constexpr size_t SEND_BATCH = 64;
+
+  // Hands a run of ticks to the transport, still one datagram per tick.
+  // On Linux a UDP run costs one sendmmsg call per SEND_BATCH ticks instead
+  // of a sendto each. Returns how many were handed over.
+  size_t send_batch(std::span<const protocol::TickPacket> ticks) {
+    if (transport_ == Transport::SharedMemory) {
+      for (const protocol::TickPacket &tick : ticks)
+        ring_->publish(tick);
+      return ticks.size();
+    }
+    size_t sent = 0;
+#ifdef __linux__
+    while (sent < ticks.size()) {
+      mmsghdr msgs[SEND_BATCH];
+      iovec iovs[SEND_BATCH];
+      size_t n = std::min(ticks.size() - sent, SEND_BATCH);
+      for (size_t i = 0; i < n; i++) {
+        iovs[i].iov_base = const_cast<protocol::TickPacket *>(&ticks[sent + i]);
+        iovs[i].iov_len = sizeof(protocol::TickPacket);
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_name = &addr_;
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr_);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+      int done = sendmmsg(sock_, msgs, static_cast<unsigned>(n), 0);
+      if (done <= 0)
+        break;
+      sent += static_cast<size_t>(done);
+    }
+#else
+    for (const protocol::TickPacket &tick : ticks)
+      sent += send(tick) ? 1 : 0;
+#endif
+    return sent;
+  }
+
+  Transport transport() const { return transport_; }
+
+private:
+  Transport transport_;
+  int sock_ = -1;
+  sockaddr_in addr_{};
+  std::optional<core::SharedMemory> shm_;
+  FeedRing *ring_ = nullptr;
+};
+
+enum class ReceiveStatus { Packet, Empty, Error };
+
+// Subscriber side of the tick feed
+class FeedReceiver {
+public:
+  FeedReceiver(Transport transport, const std::string &multicast_ip, int port)
+      : transport_(transport) {
+    if (transport_ == Transport::Udp) {
+      sock_ = create_udp_multicast_receiver(multicast_ip, port);
+    } else {
+      shm_.emplace(core::SharedMemory::attach(FEED_SHM_NAME));
+      reader_ = std::make_unique<core::BroadcastReader<FeedRing>>(
+          *FeedRing::attach_to(*shm_));
+    }
+  }
+
+  FeedReceiver(const FeedReceiver &) = delete;
+  FeedReceiver &operator=(const FeedReceiver &) = delete;
+
+  ~FeedReceiver() {
+    if (sock_ >= 0)
+      close(sock_);
+  }
+
+  // Writes the next tick straight into slot. UDP blocks in the kernel;
+  // shared memory returns Empty immediately so the caller decides how to wait.
+  // Ticks lost to a ring overrun surface as a sequence gap, exactly like
+  // dropped datagrams, and go through the same TCP recovery.
+  ReceiveStatus receive(protocol::TickPacket *slot) {
+    if (transport_ == Transport::SharedMemory) {
+      return reader_->read(*slot) == core::BroadcastReadStatus::Ok
+                 ? ReceiveStatus::Packet
+                 : ReceiveStatus::Empty;
+    }
+
+    sockaddr_in sender_addr{};
+    socklen_t sender_len = sizeof(sender_addr);
+    ssize_t received = recvfrom(sock_, slot, sizeof(protocol::TickPacket), 0,
+                                (struct sockaddr *)&sender_addr, &sender_len);
+    if (received == sizeof(protocol::TickPacket))
+      return ReceiveStatus::Packet;
+    return received < 0 ? ReceiveStatus::Error : ReceiveStatus::Empty;
+  }
+
+  Transport transport() const { return transport_; }
+
+private:
+  Transport transport_;
+  int sock_ = -1;
+  std::optional<core::SharedMemory> shm_;
+  std::unique_ptr<core::BroadcastReader<FeedRing>> reader_;
+};
+
+} // namespace networking
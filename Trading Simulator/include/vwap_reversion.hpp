@@ -0,0 +1,132 @@
+#pragma once
+
+#include "binary_log.hpp"
+#include "indicators.hpp"
+#include "protocol.hpp"
+#include "risk_gate.hpp"
+#include "strategy.hpp"
+#include "symbol_table.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace strategy {
+
+// Trading strat: buys a stretched dip (z-score of the Period-tick SMA at or
+// below -2) only while the price is also under the session VWAP, and sells
+// once it recovers to the Period-tick EMA or after 50 ticks. All three
+// indicators come from the set's shared IndicatorEngine, so running it
+// next to other strategies with the same windows costs no extra updates;
+// the z-score and VWAP are only derived for symbols that are flat.
+template <size_t Period, size_t MaxSymbols = MAX_SYMBOLS> class VwapReversion {
+public:
+  static constexpr uint32_t LOT_SIZE = 100;
+
+  explicit VwapReversion(const StrategyConfig &config = {})
+      : indicators_(require(config.indicators)),
+        sma_(indicators_.sma(Period)), ema_(indicators_.ema(Period)),
+        vwap_(indicators_.vwap()), orders_(config.orders),
+        risk_(config.risk) {}
+
+  std::string name() const { return "VWAP" + std::to_string(Period); }
+
+  // The set has already advanced the indicators for this tick
+  void on_tick(const protocol::TickPacket &tick) {
+    if (!indicators_.ready(sma_))
+      return;
+    State &state = states_.find_or_insert(core::symbol_key(tick.symbol));
+    state.last_price = tick.price;
+    core::LogSymbol sym(tick.symbol);
+
+    if (state.position == 0) {
+      double z = indicators_.zscore(sma_);
+      if (z > -2.0)
+        return;
+      double vwap = indicators_.value(vwap_);
+      if (tick.price >= vwap ||
+          !approve(protocol::Side::Buy, tick, indicators_.value(sma_)))
+        return;
+      state.position = 1;
+      state.entry_price = tick.price;
+      state.ticks_held = 0;
+      send_order(protocol::Side::Buy, tick);
+      core::log<core::LogId::VwapBuy>(Period, sym, tick.price, z, vwap);
+      return;
+    }
+
+    state.ticks_held++;
+    if ((tick.price < indicators_.value(ema_) && state.ticks_held <= 50) ||
+        !approve(protocol::Side::Sell, tick, indicators_.value(sma_)))
+      return;
+    send_order(protocol::Side::Sell, tick);
+    double pnl = (tick.price - state.entry_price) * LOT_SIZE;
+    session_pnl_ += pnl;
+    state.position = 0;
+    core::log<core::LogId::VwapExit>(Period, sym, tick.price, pnl);
+  }
+
+  // Indicators advance per tick, so batches are walked in order
+  void on_batch(std::span<const protocol::TickPacket> ticks) {
+    for (const protocol::TickPacket &tick : ticks)
+      on_tick(tick);
+  }
+
+  double session_pnl() const { return session_pnl_; }
+
+  double report_open_positions(std::ostream &out) const {
+    double mtm_pnl = 0.0;
+    states_.for_each([&](uint32_t key, const State &state) {
+      if (state.position != 1)
+        return;
+      double unrealised = (state.last_price - state.entry_price) * LOT_SIZE;
+      mtm_pnl += unrealised;
+      out << "  Open Position: " << core::symbol_name(key) << " (Bought @ $"
+          << state.entry_price << ", Current @ $" << state.last_price
+          << ") -> Unrealised: $" << unrealised << "\n";
+    });
+    return mtm_pnl;
+  }
+
+private:
+  struct State {
+    double entry_price = 0.0;
+    double last_price = 0.0;
+    uint16_t ticks_held = 0;
+    int8_t position = 0; // 0 = flat, 1 = bought
+  };
+
+  static IndicatorEngine &require(IndicatorEngine *indicators) {
+    if (indicators == nullptr)
+      throw std::runtime_error("VwapReversion must run in a StrategySet");
+    return *indicators;
+  }
+
+  bool approve(protocol::Side side, const protocol::TickPacket &tick,
+               double reference) {
+    return risk_ == nullptr ||
+           risk_->check(tick.symbol, side, tick.price, LOT_SIZE, reference,
+                        static_cast<int64_t>(tick.timestamp)) == RISK_OK;
+  }
+
+  void send_order(protocol::Side side, const protocol::TickPacket &tick) {
+    if (orders_)
+      orders_->submit(side, tick.symbol, tick.price, LOT_SIZE,
+                      tick.timestamp);
+  }
+
+  IndicatorEngine &indicators_;
+  Indicator sma_;
+  Indicator ema_;
+  Indicator vwap_;
+  core::SymbolTable<State, MaxSymbols> states_;
+  double session_pnl_ = 0.0;
+  OrderSink *orders_;
+  RiskGate *risk_;
+};
+
+static_assert(TickStrategy<VwapReversion<100>>);
+
+} // namespace strategy
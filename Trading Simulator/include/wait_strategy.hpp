@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace core {
+
+// Tells the core we are spinning: frees pipeline resources for the sibling
+// hyperthread and lowers power while we wait
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Wait strategies shared by every queue producer and consumer. The waiting
+// side calls wait_until(ready) with a predicate over the queue; the other
+// side calls notify() after it publishes (or frees) a slot. They trade
+// wakeup latency for CPU:
+//
+//   BusySpinWait   lowest latency, burns a full core
+//   SpinPauseWait  spins, then adds a pause hint on every retry
+//   SpinYieldWait  spins, then gives the core to other threads
+//   BlockingWait   spins, then parks in the kernel (futex / ulock)
+enum class WaitKind { BusySpin, SpinPause, SpinYield, Blocking };
+
+inline WaitKind parse_wait_strategy(const std::string &name) {
+  if (name == "spin")
+    return WaitKind::BusySpin;
+  if (name == "pause")
+    return WaitKind::SpinPause;
+  if (name == "yield")
+    return WaitKind::SpinYield;
+  if (name == "block")
+    return WaitKind::Blocking;
+  throw std::runtime_error("Unknown wait strategy '" + name +
+                           "' (spin|pause|yield|block)");
+}
+
+// Tight iterations before any backoff kicks in
+constexpr uint32_t WAIT_SPIN_LIMIT = 1000;
+
+struct BusySpinWait {
+  static constexpr const char *name = "spin";
+
+  template <typename Pred> void wait_until(Pred &&ready) {
+    while (!ready()) {
+    }
+  }
+  void notify() {}
+};
+
+struct SpinPauseWait {
+  static constexpr const char *name = "pause";
+
+  template <typename Pred> void wait_until(Pred &&ready) {
+    for (uint32_t spins = 0; !ready(); spins++) {
+      if (spins >= WAIT_SPIN_LIMIT)
+        cpu_relax();
+    }
+  }
+  void notify() {}
+};
+
+struct SpinYieldWait {
+  static constexpr const char *name = "yield";
+
+  template <typename Pred> void wait_until(Pred &&ready) {
+    for (uint32_t spins = 0; !ready(); spins++) {
+      if (spins >= WAIT_SPIN_LIMIT)
+        std::this_thread::yield();
+    }
+  }
+  void notify() {}
+};
+
+// Parks the waiter on an eventcount after a short spin. std::atomic::wait is
+// a futex on Linux and __ulock_wait on macOS. The sleeper count is the wakeup
+// hint: notify() only pays for a syscall when someone is actually parked, so
+// the fast path is a fence and a load.
+class BlockingWait {
+public:
+  static constexpr const char *name = "block";
+
+  template <typename Pred> void wait_until(Pred &&ready) {
+    for (uint32_t spins = 0; spins < WAIT_SPIN_LIMIT; spins++) {
+      if (ready())
+        return;
+      cpu_relax();
+    }
+
+    while (true) {
+      sleepers_.fetch_add(1, std::memory_order_seq_cst);
+      uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+      // Re-check after announcing ourselves, or a notify that raced with
+      // the spin above would be lost
+      if (ready()) {
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+      epoch_.wait(epoch, std::memory_order_seq_cst);
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+      if (ready())
+        return;
+    }
+  }
+
+  void notify() {
+    // Orders the caller's publish before the sleeper check (pairs with the
+    // waiter's fetch_add / re-check)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+      epoch_.fetch_add(1, std::memory_order_seq_cst);
+      epoch_.notify_all();
+    }
+  }
+
+private:
+  alignas(64) std::atomic<uint32_t> epoch_{0};
+  alignas(64) std::atomic<uint32_t> sleepers_{0};
+};
+
+// BlockingWait for a thread that also serves a socket: it parks in poll()
+// on the socket and a wake pipe, so either socket readiness or a notify()
+// wakes it. As with BlockingWait, notify() only pays for a syscall (a
+// write) while the waiter is parked.
+class PollWait {
+public:
+  PollWait() {
+    if (pipe(wake_) < 0)
+      throw std::runtime_error("Failed to create wake pipe");
+    fcntl(wake_[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_[1], F_SETFL, O_NONBLOCK);
+  }
+
+  PollWait(const PollWait &) = delete;
+  PollWait &operator=(const PollWait &) = delete;
+
+  ~PollWait() {
+    close(wake_[0]);
+    close(wake_[1]);
+  }
+
+  // Returns once ready() holds or fd has one of events (POLLIN, POLLOUT)
+  template <typename Pred>
+  void wait_until(int fd, short events, Pred &&ready) {
+    parked_.store(true, std::memory_order_seq_cst);
+    // Re-check after announcing ourselves, or a racing notify is lost
+    if (!ready()) {
+      pollfd fds[2] = {{fd, events, 0}, {wake_[0], POLLIN, 0}};
+      while (poll(fds, 2, -1) < 0 && errno == EINTR) {
+      }
+    }
+    parked_.store(false, std::memory_order_relaxed);
+    char drained[64];
+    while (read(wake_[0], drained, sizeof(drained)) > 0) {
+    }
+  }
+
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed)) {
+      char byte = 1;
+      ssize_t woke = write(wake_[1], &byte, 1);
+      (void)woke; // A full pipe already has the waiter awake
+    }
+  }
+
+private:
+  int wake_[2] = {-1, -1};
+  std::atomic<bool> parked_{false};
+};
+
+// Resolves a runtime choice to a concrete strategy type once at startup, so
+// the hot loops are instantiated per strategy with no dispatch per wait.
+// body receives a std::type_identity<Wait> tag.
+template <typename F> void with_wait_strategy(WaitKind kind, F &&body) {
+  switch (kind) {
+  case WaitKind::BusySpin:
+    body(std::type_identity<BusySpinWait>{});
+    break;
+  case WaitKind::SpinPause:
+    body(std::type_identity<SpinPauseWait>{});
+    break;
+  case WaitKind::SpinYield:
+    body(std::type_identity<SpinYieldWait>{});
+    break;
+  case WaitKind::Blocking:
+    body(std::type_identity<BlockingWait>{});
+    break;
+  }
+}
+
+} // namespace core
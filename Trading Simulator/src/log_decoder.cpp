@@ -0,0 +1,56 @@
+#include "binary_log.hpp"
+#include "command_line.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// Prints a binary log written with --log-file=PATH, one record per line:
+//   <timestamp ns> [thread] text
+//
+// Usage: log_decoder PATH [--color]
+int main(int argc, char **argv) {
+  core::CommandLine args(argc, argv);
+  if (argc < 2 || std::strncmp(argv[1], "--", 2) == 0) {
+    std::cerr << "Usage: log_decoder PATH [--color]\n";
+    return 1;
+  }
+  const bool color = args.has("color") && isatty(STDOUT_FILENO);
+
+  FILE *file = std::fopen(argv[1], "rb");
+  if (!file) {
+    std::cerr << "Cannot open " << argv[1] << "\n";
+    return 1;
+  }
+
+  core::LogFileHeader header{};
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      std::memcmp(header.magic, core::LOG_FILE_MAGIC, sizeof(header.magic)) !=
+          0) {
+    std::cerr << argv[1] << " is not a binary log\n";
+    std::fclose(file);
+    return 1;
+  }
+  if (header.version != core::LOG_FILE_VERSION ||
+      header.record_size != sizeof(core::LogRecord)) {
+    std::cerr << "Unsupported log version " << header.version << "\n";
+    std::fclose(file);
+    return 1;
+  }
+
+  core::LogRecord record;
+  std::string text;
+  uint64_t records = 0;
+  while (std::fread(&record, sizeof(record), 1, file) == 1) {
+    text.clear();
+    core::format_log_record(record, text, color);
+    std::printf("%" PRIu64 " [%u] %s\n", record.timestamp,
+                static_cast<unsigned>(record.thread), text.c_str());
+    records++;
+  }
+  std::fclose(file);
+  std::fprintf(stderr, "%" PRIu64 " records\n", records);
+  return 0;
+}
@@ -1,32 +1,104 @@
+#include "binary_log.hpp"
+#include "command_line.hpp"
 #include "event_loop.hpp"
+#include "huge_pages.hpp"
+#include "interrupt.hpp"
+#include "market_generator.hpp"
+#include "market_by_price.hpp"
+#include "matching_engine.hpp"
 #include "networking.hpp"
+#include "order_entry.hpp"
 #include "protocol.hpp"
+#include "publisher_pipeline.hpp"
 #include "ring_buffer.hpp"
+#include "tick_file.hpp"
+#include "thread_affinity.hpp"
+#include "tick_history.hpp"
+#include "transport.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
-#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <random>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 const std::string MULTICAST_IP = "224.0.0.1";
 const int MULTICAST_PORT = 30001;
+const int BOOK_PORT = 30002;
+const int DEPTH_PORT = 30003;
 const int TCP_PORT = 40001;
+const int ORDER_PORT = 40002;
 const size_t RING_BUFFER_SIZE = 50000;
+const uint32_t MAX_RESTING_ORDERS = 1 << 20;
+// Most symbols one history request may name
+const uint32_t MAX_HISTORY_SYMBOLS = 1 << 16;
+// Levels per side on the L2 channel
+constexpr size_t DEPTH_LEVELS = 10;
+// Unsent reply bytes an order-entry client may leave queued before it is
+// disconnected (about 21,000 replies)
+constexpr size_t MAX_REPLY_BACKLOG = 1 << 20;
+
+using TickRingBuffer = core::RingBuffer<protocol::TickPacket, RING_BUFFER_SIZE>;
+using Generator = exchange::GeneratorStage<>;
+using Sender = exchange::SenderStage<>;
 
 std::atomic<bool> keep_running{true};
 
-void signal_handler(int signum) {
+// Ctrl-C, on the core::on_interrupt thread rather than in a signal handler
+void handle_interrupt(int signum) {
+  core::Logger::instance().stop();
   std::cout << "\n[PUBLISHER] Shutting down...\n";
   keep_running = false;
   exit(signum);
 }
 
+// Answers a warm-start history request from the ring buffer in one reply.
+// False if the client is gone or the request is malformed.
+bool serve_history(int client_fd, const TickRingBuffer &ring_buffer) {
+  protocol::HistoryRequest req;
+  if (recv(client_fd, &req, sizeof(req), MSG_WAITALL) != sizeof(req) ||
+      req.symbols > MAX_HISTORY_SYMBOLS)
+    return false;
+  struct Name {
+    char symbol[4];
+  };
+  std::vector<Name> names(req.symbols);
+  size_t name_bytes = names.size() * sizeof(Name);
+  if (!names.empty() && recv(client_fd, names.data(), name_bytes,
+                             MSG_WAITALL) != static_cast<ssize_t>(name_bytes))
+    return false;
+  std::vector<uint32_t> keys;
+  for (const Name &name : names)
+    keys.push_back(core::symbol_key(name.symbol));
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<protocol::TickPacket> ticks;
+  protocol::HistoryReply reply{};
+  reply.last_sequence =
+      core::collect_history(ring_buffer, req.depth, keys, ticks);
+  reply.ticks = ticks.size();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "[TCP] Serving history: " << ticks.size() << " ticks (last "
+            << req.depth << " per symbol, up to seq " << reply.last_sequence
+            << ") collected in " << elapsed.count() << " us\n";
+  return networking::send_all(client_fd, &reply, sizeof(reply)) &&
+         networking::send_all(client_fd, ticks.data(),
+                              ticks.size() * sizeof(protocol::TickPacket));
+}
+
 // Blocking TCP Recovery Thread: handles subscriber recovery requests
-void tcp_recovery_thread_func(
-    int tcp_sock, const core::RingBuffer<protocol::TickPacket, RING_BUFFER_SIZE>
-                      &ring_buffer) {
+void tcp_recovery_thread_func(int tcp_sock, const TickRingBuffer &ring_buffer) {
   std::cout << "[THREAD] TCP Recovery thread initialised.\n";
 
   while (keep_running) {
@@ -45,15 +117,18 @@ void tcp_recovery_thread_func(
       // Loop reading requests until the client closes the connection
       while (true) {
         ssize_t bytes_read = recv(client_fd, &req, sizeof(req), MSG_WAITALL);
-        if (bytes_read == sizeof(protocol::RetransmitRequest)) {
+        if (bytes_read == sizeof(protocol::RetransmitRequest) &&
+            req.missed_sequence_num == protocol::HISTORY_REQUEST) {
+          if (!serve_history(client_fd, ring_buffer))
+            break;
+        } else if (bytes_read == sizeof(protocol::RetransmitRequest)) {
           protocol::TickPacket recovery_tick;
           if (ring_buffer.get(req.missed_sequence_num, recovery_tick)) {
             send(client_fd, &recovery_tick, sizeof(recovery_tick), 0);
             packets_recovered++;
           } else {
-            std::cerr << "[TCP] Requested packet seq="
-                      << req.missed_sequence_num
-                      << " no longer in ring buffer!\n";
+            core::log<core::LogId::RetransmitMissing>(
+                req.missed_sequence_num);
             // Send an empty 'dead' tick back to signal failure
             protocol::TickPacket dead_tick{};
             dead_tick.sequence_num = req.missed_sequence_num;
@@ -73,174 +148,761 @@ void tcp_recovery_thread_func(
   }
 }
 
-int main() {
-  std::signal(SIGINT, signal_handler);
+// One order-entry client. Its socket fd doubles as its owner ID in the
+// matching engine: fds are unique while open, and a session's orders are
+// all cancelled before its fd can be reused. The socket is non-blocking:
+// replies the client has not read yet stay queued here, so a slow reader
+// never stalls the event loop (and the feed) in send().
+struct OrderSession {
+  networking::EventData event;
+  networking::OrderSessionReader reader;
+  std::vector<protocol::OrderMessage> replies; // Queued, not fully sent
+  size_t sent_bytes = 0;                       // Of replies, already sent
+  bool failed = false; // Gone or too far behind: to be closed
+
+  // Writes as much of the queue as the socket takes. False if the client
+  // is gone or more than MAX_REPLY_BACKLOG bytes behind.
+  bool send_replies() {
+    const char *bytes = reinterpret_cast<const char *>(replies.data());
+    const size_t queued = replies.size() * sizeof(protocol::OrderMessage);
+    while (sent_bytes < queued) {
+      ssize_t n = send(event.fd, bytes + sent_bytes, queued - sent_bytes,
+                       networking::SEND_FLAGS);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+      if (n <= 0)
+        return false;
+      sent_bytes += static_cast<size_t>(n);
+    }
+    // Drop the replies sent in full; a partly sent one stays at the front
+    size_t done = sent_bytes / sizeof(protocol::OrderMessage);
+    replies.erase(replies.begin(), replies.begin() + done);
+    sent_bytes -= done * sizeof(protocol::OrderMessage);
+    return replies.size() * sizeof(protocol::OrderMessage) - sent_bytes <=
+           MAX_REPLY_BACKLOG;
+  }
+};
+
+// A multicast channel of fixed-size messages carrying their own sequence
+// numbers, sent 32 (1 KiB) to a datagram
+template <typename Message> class MulticastChannel {
+public:
+  MulticastChannel(const std::string &ip, int port)
+      : sock_(networking::create_udp_multicast_sender(ip, port, addr_)) {}
+
+  MulticastChannel(const MulticastChannel &) = delete;
+  MulticastChannel &operator=(const MulticastChannel &) = delete;
+
+  ~MulticastChannel() { close(sock_); }
+
+  void push(const Message &message) {
+    Message &slot = batch_[batched_++];
+    slot = message;
+    slot.sequence_num = next_seq_num_++;
+    if (batched_ == batch_.size())
+      flush();
+  }
+
+  void flush() {
+    if (batched_ == 0)
+      return;
+    sendto(sock_, batch_.data(), batched_ * sizeof(Message), 0,
+           (struct sockaddr *)&addr_, sizeof(addr_));
+    sent_this_sec_ += batched_;
+    batched_ = 0;
+  }
+
+  // Messages sent since the last call
+  uint64_t take_sent() { return std::exchange(sent_this_sec_, 0); }
+
+private:
+  sockaddr_in addr_{};
+  int sock_;
+  std::array<Message, 32> batch_{};
+  size_t batched_ = 0;
+  uint64_t next_seq_num_ = 1;
+  uint64_t sent_this_sec_ = 0;
+};
+
+// Publishes the matching engine's output. Every execution becomes a tick on
+// the feed (and in the recovery ring buffer), fills go back to the order
+// entry sessions involved, L3 book updates are batched onto their own
+// multicast channel and changed books are conflated onto the L2 channel.
+class ExchangeEvents {
+public:
+  ExchangeEvents(networking::FeedSender &feed, TickRingBuffer &ring_buffer,
+                 uint64_t seed)
+      : feed_(feed), ring_buffer_(ring_buffer), rng_(seed) {
+    next_drop_ += drop_gap_(rng_);
+  }
+
+  // Hands sequenced ticks to a sender thread instead of sending them here
+  void set_sender(Sender *sender) { sender_ = sender; }
+
+  // Stamps the next sequence number and the send time on a tick and
+  // publishes it: into the ring buffer, then onto the feed (or the sender)
+  void publish_tick(protocol::TickPacket tick) {
+    tick.sequence_num = seq_num_;
+
+    // Record timestamp to compare with subscriber --> calculate latency
+    tick.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::high_resolution_clock::now()
+                             .time_since_epoch())
+                         .count();
+
+    // Push to ring Buffer (SeqLock-protected)
+    ring_buffer_.push(seq_num_, tick);
+
+    // Send over the feed (artificially drop 1 in 20000 packets). The gap
+    // to the next drop is drawn once per drop, not once per tick.
+    if (seq_num_ != next_drop_) {
+      if (sender_ != nullptr) {
+        sender_->push(tick);
+      } else if (feed_.send(tick)) {
+        msgs_sent_this_sec_++;
+      }
+    } else {
+      core::log<core::LogId::SimulatedDrop>(seq_num_);
+      next_drop_ += 1 + drop_gap_(rng_);
+    }
+    last_sent_tick_ = tick;
+    seq_num_++;
+  }
+
+  void on_execution(const exchange::Execution &exec) {
+    protocol::TickPacket tick{};
+    std::memcpy(tick.symbol, exec.symbol, sizeof(tick.symbol));
+    tick.price = protocol::to_price(exec.price);
+    tick.quantity = exec.quantity;
+    publish_tick(tick);
+
+    protocol::Side maker_side = exec.taker_side == protocol::Side::Buy
+                                    ? protocol::Side::Sell
+                                    : protocol::Side::Buy;
+    fill(exec.maker_owner, exec.maker_client_id, maker_side, exec,
+         exec.maker_leaves, 0);
+    fill(exec.taker_owner, exec.taker_client_id, exec.taker_side, exec,
+         exec.taker_leaves, taker_client_ns_);
+  }
+
+  void on_book_update(const protocol::BookUpdate &update) {
+    book_channel_.push(update);
+    depth_.mark(update.symbol);
+  }
+
+  // Ends an L2 window: sends the net change of every book touched in it
+  template <typename Engine> void publish_depth(Engine &engine) {
+    depth_.flush(engine, [&](const protocol::LevelUpdate &update) {
+      depth_channel_.push(update);
+    });
+    depth_channel_.flush();
+  }
+
+  // Re-sends every L3 book in full, so consumers that lost updates resync
+  template <typename Engine> void refresh_book(const Engine &engine) {
+    engine.snapshot([&](const protocol::BookUpdate &update) {
+      book_channel_.push(update);
+    });
+    book_channel_.flush();
+  }
+
+  // Re-sends every L2 book in full, so consumers that lost updates resync
+  void refresh_depth() {
+    depth_.refresh([&](const protocol::LevelUpdate &update) {
+      depth_channel_.push(update);
+    });
+    depth_channel_.flush();
+  }
+
+  // Client timestamp echoed on the taker's fills while its New is matched
+  void set_taker_client_ns(uint64_t client_ns) { taker_client_ns_ = client_ns; }
+
+  OrderSession &open_session(int fd) {
+    OrderSession &session = sessions_[fd];
+    session.event = {fd, false};
+    return session;
+  }
+
+  OrderSession *session(int fd) {
+    auto it = sessions_.find(fd);
+    return it == sessions_.end() ? nullptr : &it->second;
+  }
+
+  void close_session(int fd) { sessions_.erase(fd); }
+
+  // Sends what the last event produced: one datagram of book updates and
+  // one non-blocking write of queued replies per session. Ticks go to the
+  // sender thread. Sessions that are gone or too far behind are marked
+  // failed and left for the caller to close, see failed_sessions().
+  void flush() {
+    if (sender_ != nullptr)
+      sender_->notify();
+    book_channel_.flush();
+    for (auto &[fd, session] : sessions_) {
+      if (!session.failed && !session.replies.empty() &&
+          !session.send_replies())
+        session.failed = true;
+    }
+  }
+
+  // Sessions flush() has marked failed. Close them only between event
+  // batches: a session's EventData may still be due later in this one.
+  std::vector<int> failed_sessions() const {
+    std::vector<int> fds;
+    for (const auto &[fd, session] : sessions_) {
+      if (session.failed)
+        fds.push_back(fd);
+    }
+    return fds;
+  }
+
+  uint64_t next_sequence() const { return seq_num_; }
+
+  // Per-second metrics, reset on read
+  uint64_t take_msgs_sent() {
+    return sender_ != nullptr ? sender_->sent.take()
+                              : std::exchange(msgs_sent_this_sec_, 0);
+  }
+  uint64_t take_book_updates() { return book_channel_.take_sent(); }
+  uint64_t take_depth_updates() { return depth_channel_.take_sent(); }
+  const protocol::TickPacket &last_sent_tick() const { return last_sent_tick_; }
+
+private:
+  void fill(uint32_t owner, uint64_t client_id, protocol::Side side,
+            const exchange::Execution &exec, uint32_t leaves,
+            uint64_t client_ns) {
+    OrderSession *s = session(static_cast<int>(owner));
+    if (s == nullptr)
+      return;
+    protocol::OrderMessage msg{};
+    msg.type = protocol::OrderType::Fill;
+    msg.side = side;
+    std::memcpy(msg.symbol, exec.symbol, sizeof(msg.symbol));
+    msg.order_id = client_id;
+    msg.price = protocol::to_price(exec.price);
+    msg.quantity = exec.quantity;
+    msg.leaves = leaves;
+    msg.client_ns = client_ns;
+    msg.exchange_ns = networking::order_clock_ns();
+    s->replies.push_back(msg);
+  }
+
+  networking::FeedSender &feed_;
+  Sender *sender_ = nullptr;
+  TickRingBuffer &ring_buffer_;
+  MulticastChannel<protocol::BookUpdate> book_channel_{MULTICAST_IP,
+                                                       BOOK_PORT};
+  MulticastChannel<protocol::LevelUpdate> depth_channel_{MULTICAST_IP,
+                                                         DEPTH_PORT};
+  exchange::MarketByPrice<DEPTH_LEVELS> depth_;
+  std::unordered_map<int, OrderSession> sessions_;
+
+  std::mt19937 rng_;
+  // Ticks sent between drops: 1 in 20000 is dropped
+  std::geometric_distribution<uint64_t> drop_gap_{1.0 / 20000};
+  uint64_t next_drop_ = 1;
+  uint64_t seq_num_ = 1;
+  uint64_t taker_client_ns_ = 0;
+  uint64_t msgs_sent_this_sec_ = 0;
+  protocol::TickPacket last_sent_tick_{};
+};
+
+using Exchange = exchange::MatchingEngine<ExchangeEvents>;
+
+// New and Cancel from an order-entry session. The Ack goes out ahead of any
+// fills the order takes on arrival; the rest rests in the book.
+// Only symbols in listed (the generated market) can be traded.
+void handle_order(Exchange &engine, ExchangeEvents &events,
+                  const std::unordered_set<uint32_t> &listed,
+                  OrderSession &session, const protocol::OrderMessage &msg) {
+  const uint32_t owner = static_cast<uint32_t>(session.event.fd);
+  auto reject = [&](protocol::RejectReason reason) {
+    protocol::OrderMessage reply =
+        networking::order_reply(msg, protocol::OrderType::Reject);
+    reply.reason = reason;
+    session.replies.push_back(reply);
+  };
+
+  if (msg.type == protocol::OrderType::Cancel) {
+    if (engine.cancel(owner, msg.order_id))
+      session.replies.push_back(
+          networking::order_reply(msg, protocol::OrderType::Ack));
+    else
+      reject(protocol::RejectReason::UnknownOrder);
+    return;
+  }
+  if (msg.type != protocol::OrderType::New)
+    return;
+
+  // The engine reads anything but Buy as Sell
+  if (msg.side != protocol::Side::Buy && msg.side != protocol::Side::Sell) {
+    reject(protocol::RejectReason::BadSide);
+    return;
+  }
+  if (!listed.contains(core::symbol_key(msg.symbol))) {
+    reject(protocol::RejectReason::UnknownSymbol);
+    return;
+  }
+  // Also keeps NaN and absurd prices away from the tick conversion
+  if (!(msg.price > 0.0 && msg.price < 1e7)) {
+    reject(protocol::RejectReason::BadPrice);
+    return;
+  }
+  int64_t price = protocol::to_ticks(msg.price);
+  protocol::RejectReason reason =
+      engine.validate(owner, msg.order_id, msg.symbol, price, msg.quantity);
+  if (reason != protocol::RejectReason::None) {
+    reject(reason);
+    return;
+  }
+
+  session.replies.push_back(
+      networking::order_reply(msg, protocol::OrderType::Ack));
+  events.set_taker_client_ns(msg.client_ns);
+  engine.add(owner, msg.order_id, msg.symbol, msg.side, price, msg.quantity);
+  events.set_taker_client_ns(0);
+}
+
+// Generator liquidity: a bid and an ask per symbol one tick either side of
+// the generated price, replaced on every update, and an immediate-or-cancel
+// taker that crosses the spread. Owner IDs sit above any socket fd.
+struct MarketMaker {
+  static constexpr uint32_t QUOTE_OWNER = 0xFFFFFF;
+  static constexpr uint32_t TAKER_OWNER = 0xFFFFFE;
+  static constexpr uint32_t QUOTE_SIZE = 1000;
+
+  explicit MarketMaker(size_t symbols) : bid_ids(symbols), ask_ids(symbols) {}
+
+  void requote(Exchange &engine, size_t sym, const char (&symbol)[4],
+               int64_t fair) {
+    engine.cancel(QUOTE_OWNER, bid_ids[sym]);
+    engine.cancel(QUOTE_OWNER, ask_ids[sym]);
+    bid_ids[sym] = next_id++;
+    ask_ids[sym] = next_id++;
+    engine.add(QUOTE_OWNER, bid_ids[sym], symbol, protocol::Side::Buy,
+               fair - 1, QUOTE_SIZE);
+    engine.add(QUOTE_OWNER, ask_ids[sym], symbol, protocol::Side::Sell,
+               fair + 1, QUOTE_SIZE);
+  }
+
+  void take(Exchange &engine, const char (&symbol)[4], protocol::Side side,
+            int64_t fair, uint32_t quantity) {
+    int64_t limit = side == protocol::Side::Buy ? fair + 1 : fair - 1;
+    engine.add(TAKER_OWNER, next_id++, symbol, side, limit, quantity, true);
+  }
+
+  std::vector<uint64_t> bid_ids;
+  std::vector<uint64_t> ask_ids;
+  uint64_t next_id = 1;
+};
+
+// Reports a --pin-* request; cpu < 0 means none was made
+void report_pin(const char *stage, int cpu, bool pinned) {
+  if (cpu < 0)
+    return;
+  std::cout << "[PIPELINE] " << stage
+            << (pinned ? " pinned to CPU " : " could not be pinned to CPU ")
+            << cpu << "\n";
+}
+
+// One line a second on the pipeline: each stage's rate and the queue in
+// front of the next. A queue that keeps growing names the slow stage. The
+// sender's rate is the msgs/sec on the [METRICS] line.
+void print_pipeline(Generator *generator, uint64_t sequenced,
+                    Sender &sender) {
+  std::cout << "[PIPELINE] ";
+  if (generator != nullptr)
+    std::cout << "generator " << generator->generated.take() << "/s (queue "
+              << generator->depth() << ") -> ";
+  std::cout << "sequencer " << sequenced << "/s (queue " << sender.depth()
+            << ") -> sender " << sender.batches.take() << " batches/s, "
+            << sender.stalls() << " stalls\n";
+}
+
+// Ticks per batch between clock checks in a replay
+constexpr size_t REPLAY_BATCH = 1024;
+
+// Offline mode: writes `ticks` ticks of generated flow to a tick file, as
+// the market maker and taker trade them on the live exchange. Offsets
+// follow the live pacing of ticks_per_ms ticks per 1ms event.
+void write_tick_file(const std::string &path, uint64_t ticks,
+                     long ticks_per_ms, uint64_t seed) {
+  auto start = std::chrono::steady_clock::now();
+  exchange::MarketGenerator<> generator(seed);
+  core::TickFileWriter file(path, seed, static_cast<uint64_t>(ticks_per_ms));
+  std::vector<exchange::GeneratedTick> moves(REPLAY_BATCH * 4);
+  std::vector<protocol::TickPacket> out(moves.size());
+  for (uint64_t done = 0; done < ticks;) {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(moves.size(),
+                                                      ticks - done));
+    generator.generate(std::span(moves.data(), n));
+    for (size_t i = 0; i < n; i++, done++) {
+      const uint64_t seq = done + 1;
+      out[i] = exchange::generated_trade(
+          moves[i], generator.name(moves[i].symbol),
+          100 + static_cast<uint32_t>(seq % 50));
+      out[i].sequence_num = seq;
+      out[i].timestamp = done / static_cast<uint64_t>(ticks_per_ms) * 1000000;
+    }
+    file.append(std::span(out.data(), n));
+  }
+  file.finish();
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  std::cout << "[GENERATE] " << ticks << " ticks ("
+            << ticks * sizeof(protocol::TickPacket) / (1 << 20)
+            << " MB, seed " << seed << ") written to " << path << " in "
+            << secs << " s (" << static_cast<uint64_t>(ticks / secs)
+            << " ticks/sec)\n";
+}
+
+// Replay mode: streams a mapped tick file onto the feed at speed times its
+// recorded pace, or as fast as it can go with speed 0. Nothing is generated
+// per tick: each one is copied out of the file, stamped and sent.
+//
+// With a sender, the replay loop is both generator and sequencer: it reads
+// and stamps, and the sender thread sends.
+void replay_tick_file(const core::MappedTickFile &file, double speed,
+                      ExchangeEvents &events, Sender *sender) {
+  using Clock = std::chrono::steady_clock;
+  const std::span<const protocol::TickPacket> ticks = file.ticks();
+  const auto start = Clock::now();
+  auto next_report = start + std::chrono::seconds(1);
+  size_t sent = 0;
+  uint64_t reported = events.next_sequence();
+  while (sent < ticks.size() && keep_running) {
+    const auto now = Clock::now();
+    if (now >= next_report) {
+      const protocol::TickPacket &last_sent_tick = events.last_sent_tick();
+      std::cout << "[METRICS] " << events.take_msgs_sent()
+                << " msgs/sec | Replay: " << sent << "/" << ticks.size()
+                << " | Last Tick: " << last_sent_tick.symbol << " @ "
+                << last_sent_tick.price << "\n";
+      if (sender != nullptr)
+        print_pipeline(nullptr,
+                       events.next_sequence() -
+                           std::exchange(reported, events.next_sequence()),
+                       *sender);
+      next_report += std::chrono::seconds(1);
+    }
+    size_t end = std::min(sent + REPLAY_BATCH, ticks.size());
+    if (speed > 0.0) {
+      // Position in the file's own time, and the ticks due by then
+      const uint64_t file_ns = static_cast<uint64_t>(
+          std::chrono::duration<double, std::nano>(now - start).count() *
+          speed);
+      size_t due = sent;
+      while (due < end && ticks[due].timestamp <= file_ns)
+        due++;
+      if (due == sent) {
+        // Sleep through long gaps, spin through the last 100us
+        auto wait = std::chrono::nanoseconds(static_cast<uint64_t>(
+            (ticks[sent].timestamp - file_ns) / speed));
+        if (wait > std::chrono::microseconds(200))
+          std::this_thread::sleep_for(wait - std::chrono::microseconds(100));
+        continue;
+      }
+      end = due;
+    }
+    for (; sent < end; sent++)
+      events.publish_tick(ticks[sent]);
+    events.flush();
+  }
+  // The replay's pace includes getting the last tick onto the feed
+  if (sender != nullptr)
+    sender->finish();
+
+  double secs =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  double recorded = ticks.empty() ? 0.0 : ticks.back().timestamp / 1e9;
+  std::cout << "[REPLAY] " << sent << " ticks in " << secs << " s ("
+            << static_cast<uint64_t>(sent / secs) << " ticks/sec, "
+            << recorded / secs << "x the recorded pace)\n";
+}
+
+int main(int argc, char **argv) {
+  core::on_interrupt(handle_interrupt);
   std::cout << "Starting simple market data publisher...\n";
 
+  core::CommandLine args(argc, argv);
+
   try {
-    sockaddr_in udp_addr{};
-    int udp_sock = networking::create_udp_multicast_sender(
-        MULTICAST_IP, MULTICAST_PORT, udp_addr);
-    std::cout << "[UDP] Ready to broadcast on " << MULTICAST_IP << ":"
-              << MULTICAST_PORT << "\n";
+    // Drops and retransmit misses are logged off the tick loop;
+    // --log-file=PATH also keeps the raw records for log_decoder
+    core::Logger::instance().start({stdout, args.get("log-file", "")});
+
+    // --transport=shm swaps UDP multicast for the shared-memory ring
+    networking::Transport transport =
+        networking::parse_transport(args.get("transport", "udp"));
+    // Ticks generated per 1ms timer event (default 10 = 10,000 msgs/sec)
+    const long ticks_per_ms = args.get_int("ticks-per-ms", 10);
+    // L2 conflation window: each book's net change per window is sent
+    const long depth_window_ms = args.get_int("depth-window-ms", 1);
+    if (depth_window_ms < 1)
+      throw std::runtime_error("--depth-window-ms must be at least 1");
+    // Full L2 refresh period: the longest a consumer that lost an update
+    // goes without that symbol's book
+    const long depth_refresh_ms = args.get_int("depth-refresh-ms", 1000);
+    if (depth_refresh_ms < 1)
+      throw std::runtime_error("--depth-refresh-ms must be at least 1");
+    // The same for the L3 channel, which re-sends every resting order
+    const long book_refresh_ms = args.get_int("book-refresh-ms", 1000);
+    if (book_refresh_ms < 1)
+      throw std::runtime_error("--book-refresh-ms must be at least 1");
+    // --pipeline=on (default) runs generation, sequencing and sending on
+    // three threads; off does all three on the event loop thread.
+    // --pin-generator/--pin-sequencer/--pin-sender=CPU pin them (Linux).
+    const std::string pipeline = args.get("pipeline", "on");
+    if (pipeline != "on" && pipeline != "off")
+      throw std::runtime_error("--pipeline must be on or off");
+    const bool pipelined = pipeline == "on";
+    const int pin_generator =
+        static_cast<int>(args.get_int("pin-generator", -1));
+    const int pin_sequencer =
+        static_cast<int>(args.get_int("pin-sequencer", -1));
+    const int pin_sender = static_cast<int>(args.get_int("pin-sender", -1));
+    // Generator seed; the same seed gives the same market (and drops). A
+    // replay defaults to the seed its file was generated with.
+    uint64_t seed = args.has("seed")
+                        ? static_cast<uint64_t>(args.get_int("seed", 0))
+                        : std::random_device{}();
+
+    // --generate=PATH writes --ticks=N ticks to a tick file and exits
+    if (args.has("generate")) {
+      if (ticks_per_ms < 1)
+        throw std::runtime_error("--ticks-per-ms must be at least 1");
+      long ticks = args.get_int("ticks", 10000000);
+      if (ticks < 1)
+        throw std::runtime_error("--ticks must be at least 1");
+      std::cout << "[MARKET] Seed " << seed << "\n";
+      write_tick_file(args.get("generate", ""), static_cast<uint64_t>(ticks),
+                      ticks_per_ms, seed);
+      core::Logger::instance().stop();
+      return 0;
+    }
+
+    // --replay=PATH streams a tick file at --speed=N (1 = recorded pace)
+    // or --speed=max instead of generating. Mapped and faulted in up front.
+    std::optional<core::MappedTickFile> replay;
+    double speed = 1.0;
+    if (args.has("replay")) {
+      std::string pace = args.get("speed", "1");
+      speed = pace == "max" ? 0.0 : std::strtod(pace.c_str(), nullptr);
+      if (pace != "max" && !(speed > 0.0))
+        throw std::runtime_error("--speed must be a positive number or max");
+      replay.emplace(args.get("replay", ""));
+      const size_t pages = replay->prefault();
+      if (!args.has("seed"))
+        seed = replay->header().seed;
+      std::cout << "[REPLAY] " << replay->ticks().size() << " ticks ("
+                << replay->bytes() / (1 << 20) << " MB in " << pages
+                << " pages faulted in, seed "
+                << replay->header().seed << ") mapped from "
+                << args.get("replay", "") << " at "
+                << (speed > 0.0 ? pace + "x" : std::string("max speed"))
+                << "\n";
+    }
+    std::cout << "[MARKET] Seed " << seed << "\n";
+    core::configure_huge_pages(args);
+
+    networking::FeedSender feed(transport, MULTICAST_IP, MULTICAST_PORT);
+    if (transport == networking::Transport::Udp) {
+      std::cout << "[UDP] Ready to broadcast on " << MULTICAST_IP << ":"
+                << MULTICAST_PORT << "\n";
+    } else {
+      std::cout << "[SHM] Ready to broadcast on " << networking::FEED_SHM_NAME
+                << "\n";
+    }
 
     int tcp_sock = networking::create_tcp_listener(TCP_PORT);
     std::cout << "[TCP] Listening for recovery requests on port " << TCP_PORT
               << "\n";
+    // Multi-megabyte and randomly probed by recovery: keep it on huge pages
+    auto ring_buffer = core::make_huge<TickRingBuffer>();
+    std::cout << "[MEMORY] " << core::huge_page_summary() << "\n";
+
+    // A replay only feeds ticks: no matching engine, order entry or book
+    // feeds. Recovery stays up after the file ends, until Ctrl-C.
+    if (replay) {
+      std::unique_ptr<Sender> sender;
+      if (pipelined)
+        sender = std::make_unique<Sender>(feed, pin_sender);
+      if (sender)
+        report_pin("Sender", pin_sender, sender->pinned());
+      ExchangeEvents events(feed, *ring_buffer, seed);
+      events.set_sender(sender.get());
+      report_pin("Sequencer", pin_sequencer,
+                 core::pin_this_thread(pin_sequencer));
+      std::thread tcp_thread(tcp_recovery_thread_func, tcp_sock,
+                             std::ref(*ring_buffer));
+      replay_tick_file(*replay, speed, events, sender.get());
+      tcp_thread.join();
+      core::Logger::instance().stop();
+      return 0;
+    }
+
+    int order_sock = networking::create_tcp_listener(ORDER_PORT);
+    std::cout << "[ORDERS] Listening for orders on port " << ORDER_PORT
+              << "\n";
 
     // kqueue handles timers
     networking::EventLoop loop;
-    core::RingBuffer<protocol::TickPacket, RING_BUFFER_SIZE> ring_buffer;
 
     networking::EventData market_tick_data{-1, true};
     networking::EventData metrics_timer_data{-2, true};
+    networking::EventData depth_window_data{-3, true};
+    networking::EventData depth_refresh_data{-4, true};
+    networking::EventData book_refresh_data{-5, true};
 
-    loop.register_timer(1, 1, &market_tick_data); // 1ms interval (1000 msgs/s)
     loop.register_timer(2, 1000,
                         &metrics_timer_data); // metrics report every second
+    loop.register_timer(3, static_cast<int>(depth_window_ms),
+                        &depth_window_data);
+    loop.register_timer(4, static_cast<int>(depth_refresh_ms),
+                        &depth_refresh_data);
+    loop.register_timer(5, static_cast<int>(book_refresh_ms),
+                        &book_refresh_data);
+
+    networking::EventData order_listen_data{order_sock, false};
+    loop.register_read(order_sock, &order_listen_data);
+
+    // Pipelined, ticks leave through the sender thread
+    std::unique_ptr<Sender> sender;
+    if (pipelined)
+      sender = std::make_unique<Sender>(feed, pin_sender);
+    // Trades and book changes from the engine drive both feeds
+    ExchangeEvents events(feed, *ring_buffer, seed);
+    events.set_sender(sender.get());
+    Exchange engine(events, MAX_RESTING_ORDERS);
+    report_pin("Sequencer", pin_sequencer,
+               core::pin_this_thread(pin_sequencer));
+
+    // Prices for the generated flow, ticks_per_ms moves a millisecond:
+    // pipelined from the generator thread, woken through its pipe; inline
+    // a timer event's worth per batch
+    std::unique_ptr<Generator> generator_stage;
+    std::optional<exchange::MarketGenerator<>> generator;
+    std::vector<exchange::GeneratedTick> generated;
+    networking::EventData generator_wake_data{-1, false};
+    if (pipelined) {
+      generator_stage =
+          std::make_unique<Generator>(seed, ticks_per_ms, pin_generator);
+      report_pin("Generator", pin_generator, generator_stage->pinned());
+      report_pin("Sender", pin_sender, sender->pinned());
+      generator_wake_data.fd = generator_stage->wake_fd();
+      loop.register_read(generator_wake_data.fd, &generator_wake_data);
+    } else {
+      generator.emplace(seed);
+      generated.resize(static_cast<size_t>(std::max(ticks_per_ms, 0L)));
+      loop.register_timer(1, 1, &market_tick_data); // 1ms interval
+    }
+    MarketMaker market_maker(pipelined ? generator_stage->symbols()
+                                       : generator->symbols());
+    // Order entry trades the generated symbols only
+    std::unordered_set<uint32_t> listed;
+    for (size_t i = 0; i < market_maker.bid_ids.size(); i++)
+      listed.insert(core::symbol_key(
+          pipelined ? generator_stage->name(i) : generator->name(i)));
+    // The market maker requotes around the new price and a taker crosses
+    // the spread: the resulting trade is the tick on the feed
+    auto trade = [&](const exchange::GeneratedTick &move,
+                     const char (&symbol)[4]) {
+      int64_t fair = protocol::to_ticks(move.price);
+      market_maker.requote(engine, move.symbol, symbol, fair);
+      uint32_t quantity =
+          100 + static_cast<uint32_t>(events.next_sequence() % 50);
+      market_maker.take(engine, symbol, move.side, fair, quantity);
+    };
+    uint64_t sequenced = events.next_sequence();
+    std::cout << "[PIPELINE] "
+              << (pipelined ? "generator, sequencer and sender threads"
+                            : "off: one thread generates, sequences and "
+                              "sends")
+              << "\n";
+    std::cout << "[BOOK] L3 book updates on " << MULTICAST_IP << ":"
+              << BOOK_PORT << " (refreshed every " << book_refresh_ms
+              << "ms), L2 top " << DEPTH_LEVELS << " levels on "
+              << MULTICAST_IP << ":" << DEPTH_PORT << " every "
+              << depth_window_ms << "ms (refreshed every " << depth_refresh_ms
+              << "ms)\n";
 
     // Spawn dedicated TCP recovery thread
     std::thread tcp_thread(tcp_recovery_thread_func, tcp_sock,
-                           std::ref(ring_buffer));
+                           std::ref(*ring_buffer));
 
-    uint64_t seq_num = 1;
-    uint64_t msgs_sent_this_sec = 0;
-    protocol::TickPacket last_sent_tick{};
+    // Cancels a session's resting orders and closes it
+    auto end_session = [&](int fd, const char *why) {
+      size_t cancelled = engine.cancel_all(static_cast<uint32_t>(fd));
+      std::cout << "[ORDERS] Order entry session " << why << ", "
+                << cancelled << " resting orders cancelled\n";
+      events.close_session(fd);
+      close(fd);
+    };
 
     std::cout << "Entering Event Loop...\n";
     while (keep_running) {
       loop.poll([&](networking::EventData *data, bool is_eof) {
         (void)is_eof;
 
-        if (data == &metrics_timer_data) {
-          std::cout << "[METRICS] " << msgs_sent_this_sec
-                    << " msgs/sec | Last Tick: " << last_sent_tick.symbol
-                    << " @ " << last_sent_tick.price << "\n";
-          msgs_sent_this_sec = 0;
-        } else if (data == &market_tick_data) {
-          // 10,000 msgs/sec
-          for (int batch = 0; batch < 10; ++batch) {
-            // Generate new TickPacket
-            static std::mt19937 rng{std::random_device{}()};
-            static std::uniform_int_distribution<uint32_t> sym_dist(0, 49);
-            static std::uniform_int_distribution<int> drop_dist(1, 20000);
-
-            // Random walk delta: prices move by up to 0.2% per tick
-            static std::normal_distribution<double> price_delta_dist(0.0, 0.01);
-
-            // Stock prices
-            static std::vector<double> current_prices(50, 0.0);
-            static bool prices_initialised = false;
-            if (!prices_initialised) {
-              for (int i = 0; i < 50; i++) {
-                current_prices[i] =
-                    100.0 + (i * 7); // Base prices: 100.00, 107.00, 114.00...
-              }
-              prices_initialised = true;
-            }
-
-            const char *symbols[] = {
-                "AAPL", "MSFT", "GOOG", "AMZN", "META", "TSLA", "NVDA", "JPM",
-                "JNJ",  "V",    "UNH",  "PG",   "HD",   "DIS",  "MA",   "BAC",
-                "VZ",   "CRM",  "XOM",  "PFE",  "NKE",  "INTC", "T",    "KO",
-                "MRK",  "PEP",  "ABT",  "WMT",  "CVX",  "CSCO", "MCD",  "ABBV",
-                "MDT",  "BMY",  "ACN",  "AVGO", "TXN",  "COST", "NEE",  "QCOM",
-                "DHR",  "LIN",  "PM",   "UNP",  "LOW",  "HON",  "UPS",  "IBM",
-                "SBUX", "CAT"};
-
-            uint32_t sym_idx = sym_dist(rng);
-
-            // Geometric Brownian Motion style "Random Walk"
-            // (Log-Normal percentage shift)
-            current_prices[sym_idx] +=
-                (current_prices[sym_idx] * price_delta_dist(rng));
-
-            // Prevent negative prices
-            if (current_prices[sym_idx] < 1.0)
-              current_prices[sym_idx] = 1.0;
-
-            double published_price = current_prices[sym_idx];
-
-            // Simulate a "Drop" (Bad earnings, scandal)
-            static std::uniform_int_distribution<int> fund_drop_dist(1, 500);
-            // Simulate a "Spike" (Acquisition, breakthrough)
-            static std::uniform_int_distribution<int> fund_spike_dist(1, 1000);
-
-            if (fund_drop_dist(rng) == 1) {
-              // Permanent structural damage (6 to 9 Sigma)
-              static std::uniform_real_distribution<double> drop_depth(0.06,
-                                                                       0.09);
-              current_prices[sym_idx] -=
-                  (current_prices[sym_idx] * drop_depth(rng));
-              if (current_prices[sym_idx] < 1.0)
-                current_prices[sym_idx] = 1.0;
-              published_price = current_prices[sym_idx];
-            } else if (fund_spike_dist(rng) == 1) {
-              // Permanent structural growth (6 to 9 Sigma)
-              static std::uniform_real_distribution<double> spike_depth(0.06,
-                                                                        0.09);
-              current_prices[sym_idx] +=
-                  (current_prices[sym_idx] * spike_depth(rng));
-              published_price = current_prices[sym_idx];
-            } else {
-              // Simulate a "Flash Crash" - 1.0% chance
-              static std::uniform_int_distribution<int> anomaly_drop_dist(1,
-                                                                          100);
-              // Simulate a "Flash Spike" - 0.5% chance
-              static std::uniform_int_distribution<int> anomaly_spike_dist(1,
-                                                                           200);
-
-              if (anomaly_drop_dist(rng) == 1) {
-                // Momentary Flash Crash (3 to 5 Sigma)
-                static std::uniform_real_distribution<double> a_drop_depth(
-                    0.025, 0.05);
-                published_price -= (published_price * a_drop_depth(rng));
-              } else if (anomaly_spike_dist(rng) == 1) {
-                // Momentary Flash Spike (3 to 5 Sigma)
-                static std::uniform_real_distribution<double> a_spike_depth(
-                    0.025, 0.05);
-                published_price += (published_price * a_spike_depth(rng));
-              }
-            }
-
-            protocol::TickPacket tick{};
-            tick.sequence_num = seq_num;
-            std::strncpy(tick.symbol, symbols[sym_idx],
-                         sizeof(tick.symbol) - 1);
-            tick.price = published_price;
-            tick.quantity = 100 + (seq_num % 50);
-
-            // Record timestamp to compare with subscriber --> calculate latency
-            tick.timestamp =
-                std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now()
-                        .time_since_epoch())
-                    .count();
-
-            // Push to ring Buffer (SeqLock-protected)
-            ring_buffer.push(seq_num, tick);
-
-            // Send over UDP (artificially drop 1 in 2000 packets)
-            bool drop_simulation = (drop_dist(rng) == 1);
-            if (!drop_simulation) {
-              ssize_t sent =
-                  sendto(udp_sock, &tick, sizeof(protocol::TickPacket), 0,
-                         (struct sockaddr *)&udp_addr, sizeof(udp_addr));
-              if (sent > 0) {
-                msgs_sent_this_sec++;
-              }
-            } else {
-              std::cout << "[SIMULATION] Dropped UDP Broadcast for TICK seq="
-                        << seq_num << "\n";
-            }
-            last_sent_tick = tick;
-            seq_num++;
+        if (data == &order_listen_data) {
+          int client_fd = accept(order_sock, nullptr, nullptr);
+          if (client_fd >= 0) {
+            std::cout << "[ORDERS] Order entry session opened\n";
+            networking::set_tcp_low_latency(client_fd);
+            networking::set_nonblocking(client_fd);
+            loop.register_read(client_fd,
+                               &events.open_session(client_fd).event);
           }
+        } else if (data == &generator_wake_data) {
+          generator_stage->drain([&](const exchange::GeneratedTick &move) {
+            trade(move, generator_stage->name(move.symbol));
+          });
+        } else if (!data->is_timer) {
+          OrderSession *session = events.session(data->fd);
+          if (session == nullptr)
+            return;
+          bool open = session->reader.read(
+              data->fd, [&](const protocol::OrderMessage &msg) {
+                handle_order(engine, events, listed, *session, msg);
+              });
+          if (!open)
+            end_session(data->fd, "closed");
+        } else if (data == &depth_window_data) {
+          events.publish_depth(engine);
+        } else if (data == &depth_refresh_data) {
+          events.refresh_depth();
+        } else if (data == &book_refresh_data) {
+          events.refresh_book(engine);
+        } else if (data == &metrics_timer_data) {
+          const protocol::TickPacket &last_sent_tick = events.last_sent_tick();
+          std::cout << "[METRICS] " << events.take_msgs_sent()
+                    << " msgs/sec | L3: " << events.take_book_updates()
+                    << "/sec | L2: " << events.take_depth_updates()
+                    << "/sec | Resting: " << engine.resting()
+                    << " | Last Tick: " << last_sent_tick.symbol << " @ "
+                    << last_sent_tick.price << "\n";
+          const uint64_t next = events.next_sequence();
+          if (sender)
+            print_pipeline(generator_stage.get(),
+                           next - std::exchange(sequenced, next), *sender);
+        } else if (data == &market_tick_data) {
+          // 10,000 msgs/sec by default
+          generator->generate(generated);
+          for (const exchange::GeneratedTick &move : generated)
+            trade(move, generator->name(move.symbol));
         }
+        events.flush();
       });
+      // After the batch: no pending event can still point at these
+      for (int fd : events.failed_sessions())
+        end_session(fd, "dropped (gone or too far behind on replies)");
     }
 
     tcp_thread.join();
+    core::Logger::instance().stop();
 
   } catch (const std::exception &e) {
     std::cerr << "Fatal Error: " << e.what() << "\n";
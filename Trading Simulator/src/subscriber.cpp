@@ -1,336 +1,826 @@
+#include "binary_log.hpp"
+#include "book_builder.hpp"
+#include "checkpoint.hpp"
+#include "command_line.hpp"
+#include "huge_pages.hpp"
+#include "interrupt.hpp"
+#include "mean_reversion.hpp"
 #include "networking.hpp"
+#include "order_entry.hpp"
 #include "protocol.hpp"
+#include "risk_gate.hpp"
+#include "sharded_strategies.hpp"
 #include "spsc_queue.hpp"
+#include "strategy.hpp"
+#include "transport.hpp"
+#include "wait_strategy.hpp"
+#include <algorithm>
 #include <arpa/inet.h>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
-#include <cmath>
-#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
 #include <sys/socket.h>
 #include <thread>
 #include <unistd.h>
-#include <unordered_map>
 #include <vector>
 
 const std::string MULTICAST_IP = "224.0.0.1";
 const int MULTICAST_PORT = 30001;
+const int BOOK_PORT = 30002;
+const int DEPTH_PORT = 30003;
 const std::string PUBLISHER_IP = "127.0.0.1";
 const int TCP_PORT = 40001;
+const int ORDER_PORT = 40002;
+// Ticks the Publisher can still retransmit (its RingBuffer size)
+const uint64_t RECOVERY_WINDOW = 50000;
+// Retransmit requests in flight on the recovery connection
+constexpr size_t RECOVERY_PIPELINE = 256;
+const size_t MAX_SYMBOLS = 1 << 17;
+const size_t MAX_BOOK_SYMBOLS = 1024;
+const uint32_t MAX_BOOK_ORDERS = 1 << 20;
+constexpr size_t DEPTH_LEVELS = 10;
+
+// Strategies run on every tick, composed at compile time into one handler.
+// Register more by adding them to the list, e.g.
+// MeanReversion<20, MAX_SYMBOLS>; each gets its own state and PnL.
+constexpr size_t SMA_PERIOD = 100;
+using Strategies =
+    strategy::StrategySet<strategy::MeanReversion<SMA_PERIOD, MAX_SYMBOLS>>;
 
-// Strategy State: SMA (Simple Moving Average)
-const int SMA_PERIOD = 100;
-struct SymbolState {
-  std::vector<double> prices;
-  int idx = 0;
-  double sum = 0.0;
-  double sum_sq = 0.0;
-  int position = 0; // 0 = flat, 1 = bought
-  double entry_price = 0.0;
-  double pnl = 0.0;
-  int trades = 0;
-  int ticks_held = 0;
-  int total_ticks_processed = 0;
+std::atomic<bool> keep_running{true};
+// Created in main() once the huge page options are set: one set run on the
+// strategy thread, or with --workers=N one private set per worker shard
+std::unique_ptr<Strategies> strategies;
+std::unique_ptr<strategy::ShardGroup<Strategies>> shards;
+// Order entry session to the Publisher, if it accepted the connection
+std::unique_ptr<networking::OrderGateway> gateway;
+// Top of book from the L3 or L2 channel with --book=l3|l2
+std::unique_ptr<core::BboBoard> bbo_board;
+// Pre-trade checks, one gate per strategy thread; empty with --risk=off
+std::vector<std::unique_ptr<strategy::RiskGate>> risk_gates;
+// Periodic strategy checkpoints with --checkpoint=PATH
+std::unique_ptr<core::Checkpointer> checkpointer;
+
+struct CheckpointStats {
+  std::atomic<uint64_t> skipped{0}; // Previous one still flushing
+  std::atomic<uint64_t> save_ns{0}; // Last serialisation, strategy thread
 };
+CheckpointStats checkpoint_stats;
 
-std::atomic<bool> keep_running{true};
-double total_session_pnl = 0.0;
-std::unordered_map<std::string, SymbolState> strategy_state;
+struct BookFeedStats {
+  std::atomic<uint64_t> updates{0};
+  std::atomic<uint64_t> gaps{0};
+  std::atomic<uint64_t> rejected{0};
+};
+BookFeedStats book_stats;
 
-void signal_handler(int signum) {
+// Ctrl-C, on the core::on_interrupt thread rather than in a signal handler
+void handle_interrupt(int signum) {
+  // Write out queued trade logs before the report
+  core::Logger::instance().stop();
   std::cout
       << "\n\n[TRADING ENGINE] Shutting down... Generating Final Report\n";
   std::cout << "=========================================================\n";
 
   // Close any open positions at the last known price to calculate final score
+  double realised_pnl = 0.0;
   double mtm_pnl = 0.0;
-  for (const auto &[sym, state] : strategy_state) {
-    if (state.position == 1 && !state.prices.empty()) {
-      // The last price inserted into the ring buffer is current market value
-      int last_inserted_idx =
-          (state.idx == 0) ? state.prices.size() - 1 : state.idx - 1;
-      double current_market_price = state.prices[last_inserted_idx];
-
-      double unrealised_profit =
-          (current_market_price - state.entry_price) * 100.0;
-      mtm_pnl += unrealised_profit;
-
-      std::cout << "  Open Position: " << sym << " (Bought @ $"
-                << state.entry_price << ", Current @ $" << current_market_price
-                << ") -> Unrealised: $" << unrealised_profit << "\n";
+  auto report = [&](const Strategies &set, const std::string &label) {
+    set.for_each([&](const auto &strat) {
+      std::cout << "[" << strat.name() << label << "] Realised: $"
+                << strat.session_pnl() << "\n";
+      realised_pnl += strat.session_pnl();
+      mtm_pnl += strat.report_open_positions(std::cout);
+    });
+  };
+  if (shards) {
+    for (size_t s = 0; s < shards->size(); s++) {
+      report(shards->strategies(s), " worker " + std::to_string(s));
     }
+  } else if (strategies) {
+    report(*strategies, "");
   }
 
   std::cout << "---------------------------------------------------------\n";
-  std::cout << "REALISED PnL:   $" << total_session_pnl << "\n";
+  std::cout << "REALISED PnL:   $" << realised_pnl << "\n";
   std::cout << "UNREALISED PnL: $" << mtm_pnl << "\n";
-  std::cout << "TOTAL NET PnL:  $" << (total_session_pnl + mtm_pnl) << "\n";
+  std::cout << "TOTAL NET PnL:  $" << (realised_pnl + mtm_pnl) << "\n";
+  if (gateway) {
+    std::cout << "---------------------------------------------------------\n"
+              << std::flush;
+    gateway->print_report();
+  }
+  if (!risk_gates.empty()) {
+    uint64_t accepted = 0, position = 0, notional = 0, rate = 0, band = 0;
+    for (const auto &gate : risk_gates) {
+      accepted += gate->accepted();
+      position += gate->rejected(strategy::RISK_POSITION);
+      notional += gate->rejected(strategy::RISK_NOTIONAL);
+      rate += gate->rejected(strategy::RISK_RATE);
+      band += gate->rejected(strategy::RISK_PRICE_BAND);
+    }
+    std::cout << "Risk accepted " << accepted << " | rejected position "
+              << position << ", notional " << notional << ", rate " << rate
+              << ", price band " << band << "\n";
+  }
+  if (checkpointer) {
+    std::cout << "Checkpoints written " << checkpointer->written()
+              << " (last seq " << checkpointer->last_sequence() << ", flush "
+              << checkpointer->last_flush_ns() / 1000 << " us) | skipped "
+              << checkpoint_stats.skipped.load() << " | serialise "
+              << checkpoint_stats.save_ns.load() / 1000 << " us\n";
+  }
+  if (bbo_board) {
+    std::cout << "Book updates " << book_stats.updates.load() << " | gaps "
+              << book_stats.gaps.load() << " | rejected "
+              << book_stats.rejected.load() << "\n";
+  }
   std::cout << "=========================================================\n";
   exit(signum);
 }
 
-void execute_strategy(const protocol::TickPacket &tick) {
-  // Trading strat: statistical arbitrage (mean reversion)
-  // Maintain the moving average for the stock
-  std::string sym(tick.symbol);
-  SymbolState &state = strategy_state[sym];
+using TickQueue = SPSCQueue<protocol::TickPacket, 16384,
+                            core::HugePageAllocator<protocol::TickPacket>>;
 
-  if (state.prices.size() < SMA_PERIOD) {
-    state.prices.push_back(tick.price);
-    state.sum += tick.price;
-    state.sum_sq += (tick.price * tick.price);
-  } else {
-    double old_price = state.prices[state.idx];
-    state.sum -= old_price;
-    state.sum_sq -= (old_price * old_price);
+template <typename Wait>
+void network_thread_func(networking::FeedReceiver &feed,
+                         TickQueue &event_queue, Wait &data_ready,
+                         Wait &space_free) {
+  std::cout << "[THREAD] Network thread initialised.\n";
+  while (keep_running) {
 
-    state.prices[state.idx] = tick.price;
-    state.sum += tick.price;
-    state.sum_sq += (tick.price * tick.price);
+    // Claim memory from the pre-allocated Ring Buffer (Backpressure prevents
+    // the app from proceeding until space clears)
+    protocol::TickPacket *raw_slot = nullptr;
+    space_free.wait_until([&] {
+      return (raw_slot = event_queue.claim_write()) != nullptr || !keep_running;
+    });
+    if (!keep_running)
+      break;
 
-    state.idx = (state.idx + 1) % SMA_PERIOD;
+    // Directly input Ticks into ring buffer (shared memory polls until a
+    // tick is published; the Publisher is another process, so nobody can
+    // notify us and we spin here regardless of the wait strategy)
+    networking::ReceiveStatus status;
+    while ((status = feed.receive(raw_slot)) ==
+               networking::ReceiveStatus::Empty &&
+           keep_running) {
+    }
+
+    if (status == networking::ReceiveStatus::Packet) {
+      // Publish data to the Strategy Engine
+      event_queue.commit_write();
+      data_ready.notify();
+    } else if (status == networking::ReceiveStatus::Error) {
+      std::cerr << "UDP Receive failed occasionally due to loop disconnect\n";
+      break;
+    }
   }
+}
 
-  if (state.prices.size() == SMA_PERIOD) {
-    state.total_ticks_processed++;
-
-    // recalculates sums and sum sq manually to wipe out floating-point drift
-    // every once in a while
-    if (state.total_ticks_processed % 1000 == 0) {
-      double true_sum = 0.0;
-      double true_sum_sq = 0.0;
-      for (double p : state.prices) {
-        true_sum += p;
-        true_sum_sq += (p * p);
+using Books = core::BookBuilder<MAX_BOOK_SYMBOLS>;
+using DepthBooks = core::MbpBuilder<DEPTH_LEVELS, MAX_BOOK_SYMBOLS>;
+
+// Builds every symbol's book from one of the Publisher's book channels
+// (BookUpdate into Books, or LevelUpdate into DepthBooks) and publishes the
+// top of each changed book once per datagram. The channels have no
+// recovery, but the Publisher refreshes every book periodically: a gap
+// empties every book and an update that does not fit empties its own, and
+// an emptied book's top of book is invalidated until its next refresh.
+template <typename Message, typename Builder>
+void book_thread_func(int sock, Builder &books, core::BboBoard &board) {
+  std::cout << "[THREAD] Book builder thread initialised.\n";
+  constexpr size_t MAX_BATCH = 64;
+  Message batch[MAX_BATCH];
+  decltype(books.apply(batch[0])) touched[MAX_BATCH];
+  uint64_t expected_seq = 0;
+
+  while (keep_running) {
+    ssize_t received = recv(sock, batch, sizeof(batch), 0);
+    if (received < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "[BOOK] Receive failed, book builder stopped\n";
+      break;
+    }
+    size_t count = static_cast<size_t>(received) / sizeof(batch[0]);
+    size_t changed = 0;
+    for (size_t i = 0; i < count; i++) {
+      const Message &update = batch[i];
+      if (expected_seq != 0 && update.sequence_num > expected_seq) {
+        core::log<core::LogId::BookGap>(expected_seq, update.sequence_num);
+        book_stats.gaps.fetch_add(1, std::memory_order_relaxed);
+        books.desync();
+        board.invalidate_all();
+        changed = 0;
+      }
+      expected_seq = update.sequence_num + 1;
+
+      auto *book = books.apply(update);
+      if (book == nullptr) {
+        book_stats.rejected.fetch_add(1, std::memory_order_relaxed);
+        board.invalidate(core::symbol_key(update.symbol));
+      } else if (std::find(touched, touched + changed, book) ==
+                 touched + changed) {
+        touched[changed++] = book;
       }
-      state.sum = true_sum;
-      state.sum_sq = true_sum_sq;
     }
+    for (size_t i = 0; i < changed; i++) {
+      if (books.synced(*touched[i]))
+        board.publish(touched[i]->key(), touched[i]->bbo());
+      else
+        board.invalidate(touched[i]->key());
+    }
+    book_stats.updates.fetch_add(count, std::memory_order_relaxed);
+  }
+}
 
-    double current_sma = state.sum / SMA_PERIOD;
+// Fetches [from_seq, to_seq) from the Publisher's TCP recovery port and hands
+// the recovered ticks to deliver(span). Returns how many were recovered.
+// Ticks older than the Publisher's RingBuffer are not requested, and up to
+// RECOVERY_PIPELINE requests are sent before reading their answers, so a
+// long gap (e.g. after a restart) costs a round trip per window, not per tick.
+template <typename Deliver>
+uint64_t recover_gap(uint64_t from_seq, uint64_t to_seq, Deliver &&deliver) {
+  uint64_t recovered = 0;
+  if (to_seq - from_seq > RECOVERY_WINDOW) {
+    core::log<core::LogId::RecoverySkipped>(from_seq,
+                                            to_seq - RECOVERY_WINDOW - 1);
+    from_seq = to_seq - RECOVERY_WINDOW;
+  }
+  // Recover missing packet via TCP using ONE persistent connection
+  try {
+    int tcp_sock = networking::connect_tcp_client(PUBLISHER_IP, TCP_PORT);
+
+    protocol::RetransmitRequest requests[RECOVERY_PIPELINE];
+    protocol::TickPacket answers[RECOVERY_PIPELINE];
+    for (uint64_t first = from_seq; first < to_seq;
+         first += RECOVERY_PIPELINE) {
+      size_t n = static_cast<size_t>(
+          std::min<uint64_t>(RECOVERY_PIPELINE, to_seq - first));
+      for (size_t i = 0; i < n; i++)
+        requests[i] = protocol::RetransmitRequest{first + i};
+      if (!networking::send_all(tcp_sock, requests, n * sizeof(requests[0]))) {
+        core::log<core::LogId::RecoveryBroken>(first);
+        break;
+      }
 
-    // Variance Calculation leveraging the Ring Buffer
-    double variance = (state.sum_sq / SMA_PERIOD) - (current_sma * current_sma);
+      // Use MSG_WAITALL to ensure strict 32-byte TCP packet reconstruction
+      ssize_t bytes_recv =
+          recv(tcp_sock, answers, n * sizeof(answers[0]), MSG_WAITALL);
+      size_t received =
+          bytes_recv > 0 ? static_cast<size_t>(bytes_recv) / sizeof(answers[0])
+                         : 0;
+
+      // Live answers are compacted in place and delivered as one run
+      size_t live = 0;
+      for (size_t i = 0; i < received; i++) {
+        if (answers[i].price > 0.0) {
+          core::log<core::LogId::Recovered>(answers[i].sequence_num,
+                                            answers[i].price);
+          answers[live++] = answers[i];
+        } else {
+          core::log<core::LogId::RecoveryExpired>(first + i);
+        }
+      }
+      recovered += live;
+      // Send the recovered packets directly into strategy engine
+      deliver(std::span<const protocol::TickPacket>(answers, live));
 
-    // floating-point subtraction can precisely drift into -0.000001,
-    if (variance < 0.0) {
-      variance = 0.0;
+      if (received < n) {
+        core::log<core::LogId::RecoveryBroken>(first + received);
+        break; // Exit the loop if the TCP pipe breaks halfway through
+      }
     }
 
-    double std_dev = std::sqrt(variance);
-
-    // Round the standard deviation so it doesn't get too small
-    // in completely silent markets
-    if (std_dev < 0.10)
-      std_dev = 0.10;
-
-    // If we have no position, look for a dip below the Bollinger Band (-2
-    // Standard Deviations)
-    if (state.position == 0 && tick.price <= current_sma - (2.0 * std_dev)) {
-      state.position = 1;
-      state.entry_price = tick.price;
-      state.ticks_held = 0;
-      std::cout << "\033[1;32m[STRATEGY] BUY 100 " << sym << " @ $"
-                << tick.price << " (SMA: $" << current_sma << ", 2\u03c3: $"
-                << (2.0 * std_dev) << ")\033[0m\n";
+    // Close the connection explicitly once the entire batch is completed
+    close(tcp_sock);
+
+  } catch (const std::exception &e) {
+    std::cerr << "[TCP] Recovery connection failed: " << e.what() << "\n";
+  }
+  return recovered;
+}
+
+// Requests the last depth ticks of every symbol from the Publisher's recovery
+// port. Returns them oldest first and sets last_sequence to the sequence
+// number they are complete up to; empty if the Publisher cannot serve them.
+std::vector<protocol::TickPacket> fetch_history(uint32_t depth,
+                                                uint64_t &last_sequence) {
+  std::vector<protocol::TickPacket> ticks;
+  last_sequence = 0;
+  try {
+    int tcp_sock = networking::connect_tcp_client(PUBLISHER_IP, TCP_PORT);
+    protocol::RetransmitRequest marker{protocol::HISTORY_REQUEST};
+    protocol::HistoryRequest req{depth, 0};
+    protocol::HistoryReply reply{};
+    if (networking::send_all(tcp_sock, &marker, sizeof(marker)) &&
+        networking::send_all(tcp_sock, &req, sizeof(req)) &&
+        recv(tcp_sock, &reply, sizeof(reply), MSG_WAITALL) ==
+            sizeof(reply) &&
+        reply.ticks <= RECOVERY_WINDOW) {
+      ticks.resize(reply.ticks);
+      size_t bytes = ticks.size() * sizeof(protocol::TickPacket);
+      if (bytes == 0 || recv(tcp_sock, ticks.data(), bytes, MSG_WAITALL) ==
+                            static_cast<ssize_t>(bytes))
+        last_sequence = reply.last_sequence;
+      else
+        ticks.clear();
     }
-    // If we have stock, manage the open position
-    else if (state.position == 1) {
-      state.ticks_held++;
-
-      // Exit 1: take profit (mean reversion)
-      if (tick.price >= current_sma) {
-        double profit = (tick.price - state.entry_price) * 100.0;
-        state.pnl += profit;
-        total_session_pnl += profit;
-        state.position = 0;
-        state.trades++;
-        std::cout << "\033[1;36m[STRATEGY] SELL (TAKE PROFIT) 100 " << sym
-                  << " @ $" << tick.price << " (Profit: $" << profit
-                  << ")\033[0m\n";
-      }
-      // Exit 2: hard stop loss (The price just keeps plummeting)
-      else if (tick.price <= state.entry_price - (3.0 * std_dev) &&
-               state.ticks_held > 2) {
-        double loss = (tick.price - state.entry_price) * 100.0;
-        state.pnl += loss;
-        total_session_pnl += loss;
-        state.position = 0;
-        state.trades++;
-        std::cout << "\033[1;31m[STRATEGY] SELL (STOP LOSS) 100 " << sym
-                  << " @ $" << tick.price << " (Loss: $" << loss
-                  << ")\033[0m\n";
+    close(tcp_sock);
+  } catch (const std::exception &e) {
+    std::cerr << "[HISTORY] History unavailable (" << e.what() << ")\n";
+  }
+  return ticks;
+}
+
+// Loads history into the strategy sets (each worker's set gets the symbols it
+// owns) and prints how many symbols each strategy can trade right away
+void warm_up(std::span<const protocol::TickPacket> ticks) {
+  std::vector<std::string> names;
+  std::vector<size_t> ready, seen;
+  auto count = [&](const Strategies &set) {
+    size_t i = 0;
+    set.for_each([&](const auto &strat) {
+      if constexpr (strategy::WarmStartable<std::decay_t<decltype(strat)>>) {
+        if (i == names.size()) {
+          names.push_back(strat.name());
+          ready.push_back(0);
+          seen.push_back(0);
+        }
+        ready[i] += strat.ready_symbols();
+        seen[i] += strat.symbols();
+        i++;
       }
-      // Exit 3: time stop loss (stock is not rising back to mean)
-      else if (state.ticks_held > 50) {
-        double loss = (tick.price - state.entry_price) * 100.0;
-        state.pnl += loss;
-        total_session_pnl += loss;
-        state.position = 0;
-        state.trades++;
-        std::cout << "\033[1;33m[STRATEGY] SELL (TIME STOP) 100 " << sym
-                  << " @ $" << tick.price << " (PnL: $" << loss << ")\033[0m\n";
+    });
+  };
+  if (shards) {
+    std::vector<protocol::TickPacket> owned;
+    for (size_t s = 0; s < shards->size(); s++) {
+      owned.clear();
+      for (const protocol::TickPacket &tick : ticks) {
+        if (strategy::shard_for(core::symbol_key(tick.symbol),
+                                shards->size()) == s)
+          owned.push_back(tick);
       }
+      shards->strategies(s).warm_up(owned);
+      count(shards->strategies(s));
     }
+  } else {
+    strategies->warm_up(ticks);
+    count(*strategies);
+  }
+  for (size_t i = 0; i < names.size(); i++) {
+    std::cout << "[HISTORY] " << names[i] << " ready for " << ready[i]
+              << " of " << seen[i] << " symbols\n";
   }
 }
 
-SPSCQueue<10000> event_queue;
+// Serialises the strategies and the risk gate's positions into the
+// checkpoint staging buffer, stamped with the last applied sequence number,
+// and leaves syncing it to the flusher thread. Skipped while the previous
+// checkpoint is still being flushed.
+void save_checkpoint(core::Checkpointer &checkpoints, uint64_t sequence) {
+  std::span<std::byte> slot = checkpoints.begin();
+  if (slot.empty()) {
+    checkpoint_stats.skipped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  core::CheckpointWriter out(slot);
+  // Length-prefixed strategies, then the gate's positions if risk is on
+  size_t length_at = out.size();
+  out.put(uint64_t{0});
+  size_t set_start = out.size();
+  strategies->save_checkpoint(out);
+  out.patch(length_at, static_cast<uint64_t>(out.size() - set_start));
+  out.put(static_cast<uint8_t>(!risk_gates.empty()));
+  if (!risk_gates.empty())
+    risk_gates[0]->save_checkpoint(out);
+  if (out.overflow()) {
+    core::log<core::LogId::CheckpointOverflow>(slot.size());
+    return;
+  }
+  checkpoints.submit(out.size(), sequence);
+  checkpoint_stats.save_ns.store(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count(),
+      std::memory_order_relaxed);
+}
 
-void network_thread_func(int udp_sock) {
-  std::cout << "[THREAD] Network thread initialised.\n";
-  while (keep_running) {
+// Restores what save_checkpoint wrote into fresh strategies and risk gate.
+// False if either rejects its part; the strategies should then be
+// discarded, but the gate is untouched. Saved positions are dropped if risk
+// is now off; with no saved positions the gate starts flat.
+bool restore_checkpoint(core::CheckpointReader &in) {
+  uint64_t length;
+  uint8_t has_gate;
+  if (!in.get(length))
+    return false;
+  std::optional<core::CheckpointReader> set = in.sub(length);
+  if (!set || !strategies->restore_checkpoint(*set) || !in.get(has_gate))
+    return false;
+  if (has_gate && !risk_gates.empty())
+    return risk_gates[0]->restore_checkpoint(in);
+  return has_gate || in.remaining() == 0;
+}
 
-    // Claim memory from the pre-allocated Ring Buffer
-    protocol::TickPacket *raw_slot = nullptr;
-    while (!(raw_slot = event_queue.claim_write()) && keep_running) {
-      // Spin-wait (Backpressure prevents the app from proceeding until space
-      // clears)
+// "150.01 x 300 / 150.03 x 1000", with "-" for an empty side
+std::string format_bbo(const core::Bbo &top) {
+  char bid[40] = "-";
+  char ask[40] = "-";
+  if (top.bid_price != core::NO_BID)
+    std::snprintf(bid, sizeof(bid), "%.2f x %llu",
+                  protocol::to_price(top.bid_price),
+                  static_cast<unsigned long long>(top.bid_quantity));
+  if (top.ask_price != core::NO_ASK)
+    std::snprintf(ask, sizeof(ask), "%.2f x %llu",
+                  protocol::to_price(top.ask_price),
+                  static_cast<unsigned long long>(top.ask_quantity));
+  return std::string(bid) + " / " + ask;
+}
+
+// Ticks drained from the queue per wakeup in --eval=batch mode
+constexpr size_t DRAIN_BATCH = 256;
+
+template <typename Wait>
+using Sharded = strategy::ShardedExecutor<Strategies, Wait>;
+
+// With a ShardedExecutor this thread only sequences the feed (gap detection,
+// recovery, metrics) and routes ticks to the workers that own their symbols.
+// resume_seq is the next tick the strategies need (0 on a cold start): after
+// a restore or a history load, live ticks the state already covers are
+// dropped, and everything from it up to the first newer tick is recovered.
+template <typename Wait>
+void strategy_loop(TickQueue &event_queue, Wait &data_ready, Wait &space_free,
+                   bool batch_eval, Sharded<Wait> *sharded, uint64_t resume_seq,
+                   std::chrono::milliseconds checkpoint_every) {
+  uint64_t expected_seq = resume_seq;
+  auto next_checkpoint = std::chrono::steady_clock::now() + checkpoint_every;
+  const size_t drain_max = batch_eval ? DRAIN_BATCH : 1;
+
+  // Runs a run of drained ticks through the strategy
+  auto run_strategy = [&](std::span<const protocol::TickPacket> ticks) {
+    if (sharded) {
+      sharded->route(ticks);
+    } else if (batch_eval) {
+      strategies->on_batch(ticks);
+    } else {
+      for (const protocol::TickPacket &tick : ticks) {
+        strategies->on_tick(tick);
+      }
     }
-    if (!keep_running)
+  };
+
+  // Performance Metrics
+  uint64_t ticks_received_this_sec = 0;
+  double min_lat = 1e9, max_lat = 0, sum_lat = 0;
+  auto last_report_time = std::chrono::steady_clock::now();
+  protocol::TickPacket last_recv_tick{};
+
+  while (keep_running) {
+    // Strategy Thread: Request read-only access to the next Ring Buffer slots
+    std::span<const protocol::TickPacket> ticks;
+    data_ready.wait_until([&] {
+      ticks = event_queue.front_n(drain_max);
+      return !ticks.empty() || !keep_running;
+    });
+    if (ticks.empty())
       break;
 
-    sockaddr_in sender_addr{};
-    socklen_t sender_len = sizeof(sender_addr);
+    // Ticks before a gap must reach the strategy before the recovered ones
+    size_t pending = 0;
+    for (size_t i = 0; i < ticks.size(); i++) {
+      const protocol::TickPacket &tick = ticks[i];
+
+      // Already in the restored state; anything older than the Publisher's
+      // RingBuffer means it has restarted and the numbering with it
+      if (tick.sequence_num < resume_seq &&
+          resume_seq - tick.sequence_num <= RECOVERY_WINDOW) {
+        run_strategy(ticks.subspan(pending, i - pending));
+        pending = i + 1;
+        continue;
+      }
+      resume_seq = 0;
+
+      if (expected_seq != 0 && tick.sequence_num > expected_seq) {
+        core::log<core::LogId::GapDetected>(expected_seq, tick.sequence_num);
+        run_strategy(ticks.subspan(pending, i - pending));
+        pending = i;
+        ticks_received_this_sec +=
+            recover_gap(expected_seq, tick.sequence_num, run_strategy);
+      }
+
+      uint64_t now_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::high_resolution_clock::now().time_since_epoch())
+              .count();
+      double latency_us = (now_ns - tick.timestamp) / 1000.0;
+
+      ticks_received_this_sec++;
+      if (latency_us < min_lat)
+        min_lat = latency_us;
+      if (latency_us > max_lat)
+        max_lat = latency_us;
+      sum_lat += latency_us;
+      last_recv_tick = tick;
+
+      auto now = std::chrono::steady_clock::now();
+      if (std::chrono::duration_cast<std::chrono::seconds>(now -
+                                                           last_report_time)
+              .count() >= 1) {
+        double avg_lat = sum_lat / ticks_received_this_sec;
+        std::cout << "[METRICS] " << ticks_received_this_sec
+                  << " msgs/sec | Latency (us): Min=" << min_lat
+                  << " Max=" << max_lat << " Avg=" << avg_lat
+                  << " | Last: " << last_recv_tick.symbol << " @ "
+                  << last_recv_tick.price;
+        if (shards)
+          std::cout << " | PnL: $" << shards->session_pnl();
+        core::Bbo top;
+        if (bbo_board &&
+            bbo_board->read(core::symbol_key(last_recv_tick.symbol), top))
+          std::cout << " | BBO: " << format_bbo(top);
+        std::cout << "\n";
+
+        ticks_received_this_sec = 0;
+        min_lat = 1e9;
+        max_lat = 0;
+        sum_lat = 0;
+        last_report_time = now;
+      }
 
-    // Directly input Ticks into ring buffer
-    ssize_t received =
-        recvfrom(udp_sock, raw_slot, sizeof(protocol::TickPacket), 0,
-                 (struct sockaddr *)&sender_addr, &sender_len);
+      // next expected seq
+      expected_seq = tick.sequence_num + 1;
+    }
 
-    if (received == sizeof(protocol::TickPacket)) {
-      // Publish data to the Strategy Engine
-      event_queue.commit_write();
-    } else if (received < 0) {
-      std::cerr << "UDP Receive failed occasionally due to loop disconnect\n";
-      break;
+    // Send the original UDP packets into our strategy engine
+    run_strategy(ticks.subspan(pending));
+
+    // Formally release the Ring Buffer slots back to the
+    // Network Thread
+    event_queue.pop_n(ticks.size());
+    space_free.notify();
+
+    // Between batches the state covers every tick before expected_seq
+    if (checkpointer && expected_seq != 0) {
+      auto now = std::chrono::steady_clock::now();
+      if (now >= next_checkpoint) {
+        save_checkpoint(*checkpointer, expected_seq - 1);
+        next_checkpoint = now + checkpoint_every;
+      }
     }
   }
 }
 
-int main() {
-  std::signal(SIGINT, signal_handler);
+int main(int argc, char **argv) {
+  core::on_interrupt(handle_interrupt);
   std::cout << "Starting Trading Simulation Engine...\n";
 
+  core::CommandLine args(argc, argv);
+
   try {
-    int udp_sock =
-        networking::create_udp_multicast_receiver(MULTICAST_IP, MULTICAST_PORT);
-    std::cout << "[UDP] Listening on " << MULTICAST_IP << ":" << MULTICAST_PORT
-              << "\n";
-
-    uint64_t expected_seq = 0;
-
-    // Performance Metrics
-    uint64_t ticks_received_this_sec = 0;
-    double min_lat = 1e9, max_lat = 0, sum_lat = 0;
-    auto last_report_time = std::chrono::steady_clock::now();
-    protocol::TickPacket last_recv_tick{};
-
-    std::thread net_thread(network_thread_func, udp_sock);
-    std::cout << "[THREAD] Quantitative Strategy Engine initialised.\n";
-
-    while (keep_running) {
-      // Strategy Thread: Request a read-only pointer to the Ring Buffer slot
-      const protocol::TickPacket *tick_ptr = event_queue.front();
-
-      if (tick_ptr) {
-
-        if (expected_seq != 0 && tick_ptr->sequence_num > expected_seq) {
-          std::cout << "\n[!] GAP DETECTED! Expected " << expected_seq
-                    << ", got " << tick_ptr->sequence_num << "\n";
-
-          // Recover missing packet via TCP using ONE persistent connection
-          try {
-            int tcp_sock =
-                networking::connect_tcp_client(PUBLISHER_IP, TCP_PORT);
-
-            for (uint64_t missed_seq = expected_seq;
-                 missed_seq < tick_ptr->sequence_num; ++missed_seq) {
-
-              protocol::RetransmitRequest req{missed_seq};
-              send(tcp_sock, &req, sizeof(req), 0);
-
-              protocol::TickPacket recovered_tick;
-              // Use MSG_WAITALL to ensure strict 32-byte TCP packet
-              // reconstruction
-              ssize_t bytes_recv = recv(tcp_sock, &recovered_tick,
-                                        sizeof(recovered_tick), MSG_WAITALL);
-
-              if (bytes_recv == sizeof(protocol::TickPacket)) {
-                if (recovered_tick.price > 0.0) {
-                  std::cout << "[TCP] Successfully RECOVERED seq="
-                            << recovered_tick.sequence_num
-                            << " price=" << recovered_tick.price << "\n";
-                  ticks_received_this_sec++;
-                  // Send the recovered packet directly into strategy engine
-                  execute_strategy(recovered_tick);
-                } else {
-                  std::cerr << "[TCP] Failed to recover seq=" << missed_seq
-                            << " (Expired from Publisher's RingBuffer)\n";
-                }
-              } else {
-                std::cerr << "[TCP] Connection broken while recovering seq="
-                          << missed_seq << "\n";
-                break; // Exit the loop if the TCP pipe breaks halfway through
-              }
-            }
-
-            // Close the connection explicitly once the entire batch is
-            // completed
-            close(tcp_sock);
-
-          } catch (const std::exception &e) {
-            std::cerr << "[TCP] Recovery connection failed: " << e.what()
-                      << "\n";
-          }
-        }
+    // Trades, gaps and recoveries are logged as binary records and formatted
+    // on a background thread; --log-file=PATH also keeps the raw records
+    core::Logger::instance().start({stdout, args.get("log-file", "")});
+
+    // --transport=shm reads the Publisher's shared-memory ring instead of UDP
+    networking::Transport transport =
+        networking::parse_transport(args.get("transport", "udp"));
+    networking::FeedReceiver feed(transport, MULTICAST_IP, MULTICAST_PORT);
+    if (transport == networking::Transport::Udp) {
+      std::cout << "[UDP] Listening on " << MULTICAST_IP << ":"
+                << MULTICAST_PORT << "\n";
+    } else {
+      std::cout << "[SHM] Reading " << networking::FEED_SHM_NAME << "\n";
+    }
 
-        uint64_t now_ns =
-            std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::high_resolution_clock::now().time_since_epoch())
-                .count();
-        double latency_us = (now_ns - tick_ptr->timestamp) / 1000.0;
-
-        ticks_received_this_sec++;
-        if (latency_us < min_lat)
-          min_lat = latency_us;
-        if (latency_us > max_lat)
-          max_lat = latency_us;
-        sum_lat += latency_us;
-        last_recv_tick = *tick_ptr;
-
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now -
-                                                             last_report_time)
-                .count() >= 1) {
-          double avg_lat = sum_lat / ticks_received_this_sec;
-          std::cout << "[METRICS] " << ticks_received_this_sec
-                    << " msgs/sec | Latency (us): Min=" << min_lat
-                    << " Max=" << max_lat << " Avg=" << avg_lat
-                    << " | Last: " << last_recv_tick.symbol << " @ "
-                    << last_recv_tick.price << "\n";
-
-          ticks_received_this_sec = 0;
-          min_lat = 1e9;
-          max_lat = 0;
-          sum_lat = 0;
-          last_report_time = now;
-        }
+    // Huge pages must be configured before the queue and strategy state are
+    // allocated
+    core::configure_huge_pages(args);
+    auto event_queue = std::make_unique<TickQueue>();
+
+    // --eval=batch drains up to DRAIN_BATCH ticks per wakeup and computes the
+    // bands with the --simd=auto|avx512|avx2|scalar kernel; --eval=tick runs
+    // the strategy one tick at a time. Both make identical decisions.
+    std::string eval = args.get("eval", "batch");
+    if (eval != "batch" && eval != "tick")
+      throw std::runtime_error("Unknown --eval mode: " + eval);
+    strategy::SimdLevel simd =
+        strategy::parse_simd_level(args.get("simd", "auto"));
+    // --workers=N shards symbols across N strategy threads; 0 (default) runs
+    // the strategies on the strategy thread itself
+    long workers = args.get_int("workers", 0);
+    if (workers < 0)
+      throw std::runtime_error("--workers must not be negative");
+
+    // --wait=spin|pause|yield|block trades wakeup latency for CPU, on the
+    // strategy thread and the order gateway alike
+    core::WaitKind wait_kind =
+        core::parse_wait_strategy(args.get("wait", "spin"));
+
+    // Every strategy thread (the strategy thread, or each worker) submits
+    // orders through its own sink into the gateway thread
+    size_t order_producers = workers > 0 ? static_cast<size_t>(workers) : 1;
+    try {
+      gateway = std::make_unique<networking::OrderGateway>(
+          PUBLISHER_IP, ORDER_PORT, order_producers, wait_kind);
+      std::cout << "[ORDERS] Order entry connected to " << PUBLISHER_IP << ":"
+                << ORDER_PORT << "\n";
+    } catch (const std::exception &e) {
+      std::cerr << "[ORDERS] Order entry unavailable (" << e.what()
+                << "), trading locally\n";
+    }
+    // --book=l3 builds full depth for every symbol from the order-by-order
+    // channel, --book=l2 the top DEPTH_LEVELS from the conflated
+    // market-by-price channel, on a thread of their own; strategies read
+    // top of book through the BboBoard
+    std::string book_mode = args.get("book", "off");
+    if (book_mode != "l3" && book_mode != "l2" && book_mode != "off")
+      throw std::runtime_error("Unknown --book mode: " + book_mode);
+    std::unique_ptr<Books> books;
+    std::unique_ptr<DepthBooks> depth_books;
+    int book_sock = -1;
+    if (book_mode != "off") {
+      int port = book_mode == "l3" ? BOOK_PORT : DEPTH_PORT;
+      book_sock = networking::create_udp_multicast_receiver(MULTICAST_IP, port);
+      if (book_mode == "l3")
+        books = std::make_unique<Books>(MAX_BOOK_ORDERS);
+      else
+        depth_books = std::make_unique<DepthBooks>();
+      bbo_board = std::make_unique<core::BboBoard>(MAX_BOOK_SYMBOLS);
+      std::cout << "[BOOK] Building " << book_mode << " books from "
+                << MULTICAST_IP << ":" << port << "\n";
+    }
 
-        // next expected seq
-        expected_seq = tick_ptr->sequence_num + 1;
+    // Every strategy thread checks its decisions against its own RiskGate
+    // (--risk=on, the default) with the same per-symbol limits
+    std::string risk_mode = args.get("risk", "on");
+    if (risk_mode != "on" && risk_mode != "off")
+      throw std::runtime_error("Unknown --risk mode: " + risk_mode);
+    if (risk_mode == "on") {
+      strategy::RiskLimits limits;
+      limits.max_position = args.get_int("max-position", limits.max_position);
+      limits.max_notional =
+          args.get_double("max-notional", limits.max_notional);
+      limits.rate.per_sec = args.get_double("order-rate", limits.rate.per_sec);
+      limits.rate.burst = args.get_double("order-burst", limits.rate.burst);
+      limits.price_band = args.get_double("price-band", limits.price_band);
+      if (limits.max_position <= 0 || limits.max_notional <= 0 ||
+          limits.rate.per_sec <= 0 || limits.rate.burst < 1 ||
+          limits.price_band <= 0)
+        throw std::runtime_error("Risk limits must be positive");
+      for (size_t p = 0; p < order_producers; p++)
+        risk_gates.push_back(std::make_unique<strategy::RiskGate>(limits));
+      std::cout << "[RISK] Max position " << limits.max_position
+                << " | notional $" << limits.max_notional << " | "
+                << limits.rate.per_sec << " orders/sec (burst "
+                << limits.rate.burst << ") | band "
+                << limits.price_band * 100 << "%\n";
+    }
 
-        // Send the original UDP packet into our strategy engine
-        execute_strategy(*tick_ptr);
+    auto config_for = [&](size_t producer) {
+      strategy::StrategyConfig config;
+      config.simd = simd;
+      config.orders = gateway ? &gateway->sink(producer) : nullptr;
+      config.bbo = bbo_board.get();
+      config.risk = risk_gates.empty() ? nullptr : risk_gates[producer].get();
+      return config;
+    };
+
+    if (workers > 0) {
+      shards = std::make_unique<strategy::ShardGroup<Strategies>>(
+          static_cast<size_t>(workers), config_for);
+    } else {
+      strategies = std::make_unique<Strategies>(config_for(0));
+    }
 
-        // Formally release the Ring Buffer slot back to the
-        // Network Thread
-        event_queue.pop();
+    // --checkpoint=PATH saves the strategy state every --checkpoint-ms into a
+    // memory-mapped file (two slots of --checkpoint-mb each) and resumes from
+    // the newest one on startup; the ticks published since are recovered
+    // from the Publisher before the strategies go live
+    std::string checkpoint_path = args.get("checkpoint", "");
+    auto checkpoint_every =
+        std::chrono::milliseconds(args.get_int("checkpoint-ms", 1000));
+    uint64_t resume_seq = 0;
+    if (!checkpoint_path.empty()) {
+      if (workers > 0)
+        throw std::runtime_error("--checkpoint needs --workers=0");
+      long checkpoint_mb = args.get_int("checkpoint-mb", 64);
+      if (checkpoint_every.count() <= 0 || checkpoint_mb <= 0)
+        throw std::runtime_error("Checkpoint interval and size must be "
+                                 "positive");
+      checkpointer = std::make_unique<core::Checkpointer>(
+          checkpoint_path, static_cast<size_t>(checkpoint_mb) << 20);
+      auto start = std::chrono::steady_clock::now();
+      if (auto snapshot = checkpointer->latest()) {
+        core::CheckpointReader in(snapshot->data);
+        if (restore_checkpoint(in)) {
+          resume_seq = snapshot->sequence + 1;
+          std::cout << "[CHECKPOINT] Restored " << snapshot->data.size()
+                    << " bytes up to seq " << snapshot->sequence << " in "
+                    << std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count()
+                    << " us, recovering from seq " << resume_seq << "\n";
+        } else {
+          strategies = std::make_unique<Strategies>(config_for(0));
+          std::cout << "[CHECKPOINT] " << checkpoint_path
+                    << " holds other strategies or risk state, starting cold\n";
+        }
+      } else {
+        std::cout << "[CHECKPOINT] No checkpoint in " << checkpoint_path
+                  << ", starting cold\n";
       }
     }
-
-    std::cout << "[MAIN] Loop broken, waiting for background threads...\n";
-    net_thread.join();
+    // --history=N primes the strategies with the last N ticks of every
+    // symbol from the Publisher's RingBuffer before going live, so a symbol
+    // can trade on its first live tick instead of after N of them. The
+    // default is the longest window of the strategies; 0 turns it off, and
+    // a restored checkpoint makes it unnecessary.
+    std::string history = args.get("history", "auto");
+    size_t set_warmup = shards ? shards->strategies(0).warmup_ticks()
+                               : strategies->warmup_ticks();
+    long depth = history == "auto" ? static_cast<long>(set_warmup)
+                                   : args.get_int("history", 0);
+    if (depth < 0 || depth > static_cast<long>(RECOVERY_WINDOW))
+      throw std::runtime_error("--history must be 0-" +
+                               std::to_string(RECOVERY_WINDOW));
+    if (depth > 0 && resume_seq == 0) {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t last_sequence;
+      std::vector<protocol::TickPacket> ticks =
+          fetch_history(static_cast<uint32_t>(depth), last_sequence);
+      if (!ticks.empty()) {
+        warm_up(ticks);
+        resume_seq = last_sequence + 1;
+        std::cout << "[HISTORY] Loaded " << ticks.size() << " ticks (last "
+                  << depth << " per symbol, up to seq " << last_sequence
+                  << ") in "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count()
+                  << " us\n";
+      } else {
+        std::cout << "[HISTORY] No history, warming up on live ticks\n";
+      }
+    }
+    std::cout << "[MEMORY] " << core::huge_page_summary() << "\n";
+
+    core::with_wait_strategy(wait_kind, [&](auto tag) {
+      using Wait = typename decltype(tag)::type;
+      Wait data_ready;
+      Wait space_free;
+
+      std::thread net_thread(network_thread_func<Wait>, std::ref(feed),
+                             std::ref(*event_queue), std::ref(data_ready),
+                             std::ref(space_free));
+      std::thread book_thread;
+      if (books)
+        book_thread = std::thread(book_thread_func<protocol::BookUpdate, Books>,
+                                  book_sock, std::ref(*books),
+                                  std::ref(*bbo_board));
+      else if (depth_books)
+        book_thread =
+            std::thread(book_thread_func<protocol::LevelUpdate, DepthBooks>,
+                        book_sock, std::ref(*depth_books),
+                        std::ref(*bbo_board));
+      std::cout << "[THREAD] Quantitative Strategy Engine initialised (wait="
+                << Wait::name << ", eval=" << eval;
+      if (eval == "batch")
+        std::cout << ", simd=" << strategy::simd_name(simd);
+      if (shards)
+        std::cout << ", workers=" << shards->size();
+      std::cout << ").\n";
+
+      std::optional<Sharded<Wait>> sharded;
+      if (shards)
+        sharded.emplace(*shards, eval == "batch", DRAIN_BATCH);
+
+      strategy_loop(*event_queue, data_ready, space_free, eval == "batch",
+                    sharded ? &*sharded : nullptr, resume_seq,
+                    checkpoint_every);
+      if (sharded)
+        sharded->stop();
+
+      std::cout << "[MAIN] Loop broken, waiting for background threads...\n";
+      net_thread.join();
+      if (book_thread.joinable())
+        book_thread.join();
+    });
+    if (book_sock >= 0)
+      close(book_sock);
+    if (gateway)
+      gateway->stop();
+    core::Logger::instance().stop();
 
   } catch (const std::exception &e) {
     std::cerr << "Fatal Error: " << e.what() << "\n";